@@ -16,16 +16,6 @@ vkCreateGraphicsPipelines(): pCreateInfos[0].pRasterizationState->lineWidth is 0
 The Vulkan spec states: If the pipeline requires pre-rasterization shader state, and the wideLines feature is not enabled,
 and no element of the pDynamicStates member of pDynamicState is VK_DYNAMIC_STATE_LINE_WIDTH, the lineWidth member of pRasterizationState
 must be 1.0 (https://vulkan.lunarg.com/doc/view/1.4.304.1/windows/antora/spec/latest/chapters/pipelines.html#VUID-VkGraphicsPipelineCreateInfo-pDynamicStates-00749)
-
-2.
-Validation Layer:Validation Error: [ VUID-vkCmdPipelineBarrier-pImageMemoryBarriers-02820 ] Object 0: handle = 0x24fc1562070,
-type = VK_OBJECT_TYPE_COMMAND_BUFFER; | MessageID = 0xaf8d561d | vkCmdPipelineBarrier(): pImageMemoryBarriers[0].dstAccessMask
-(VK_ACCESS_TRANSFER_READ_BIT) is not supported by stage mask (VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT).
-
-The Vulkan spec states: For any element of pImageMemoryBarriers, if its srcQueueFamilyIndex and dstQueueFamilyIndex members are equal,
-or if its dstQueueFamilyIndex is the queue family index that was used to create the command pool that commandBuffer was allocated from,
-then its dstAccessMask member must only contain access flags that are supported by one or more of the pipeline stages in dstStageMask,
-as specified in the table of supported access types (https://vulkan.lunarg.com/doc/view/1.4.304.1/windows/antora/spec/latest/chapters/synchronization.html#VUID-vkCmdPipelineBarrier-pImageMemoryBarriers-02820)
 */
 
 /*
@@ -46,18 +36,38 @@ HelloTriangleApplication::HelloTriangleApplication() {
 	instanceManager = std::make_unique<VulkanApplicationInstanceManager>();
 	createSurface();
 	deviceManager = std::make_unique<VulkanApplicationDeviceManager>(instanceManager->getInstance(), surface);
+	pipelineCache = std::make_unique<VulkanApplicationPipelineCache>(deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice());
+	memoryAllocator = std::make_unique<VulkanApplicationMemoryAllocator>(deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice());
+	stagingRing = std::make_unique<VulkanApplicationStagingRing>(deviceManager->getLogicalDevice(), *memoryAllocator, kSTAGING_RING_SIZE);
 	swapchainManager = std::make_unique<VulkanApplicationSwapchainManager>(deviceManager->getPhysicalDevice(), deviceManager->getLogicalDevice(), surface, window);
 	graphicsManager = std::make_unique<VulkanApplicationGraphicsManager>(swapchainManager->getSwapchainImageFormat(), deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice());
 	createDescriptorSetLayout();// descriptor file
-	graphicsManager->createGraphicsPipeline(deviceManager->getLogicalDevice(), descriptorSetLayout);
 	createCommandPool();		// command
-	swapchainManager->createDepthResources(deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice(), deviceManager->getGraphicsQueue(), commandPool);
+	uploadContext = std::make_unique<VulkanApplicationUploadContext>(deviceManager->getLogicalDevice(),
+		deviceManager->getGraphicsQueue(), deviceManager->getQueueFamilyIndices().graphicsFamily.value(),
+		deviceManager->getTransferQueue(), deviceManager->getQueueFamilyIndices().transferFamily.value(), *stagingRing);
+	swapchainManager->createDepthResources(deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice(), *memoryAllocator, *uploadContext);
 	swapchainManager->createFrameBuffer(deviceManager->getLogicalDevice(), graphicsManager->getRenderPass());
-	textureManager = std::make_unique<VulkanApplicationTextureManager>(deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice(), commandPool, deviceManager->getGraphicsQueue());
-	bufferManager = std::make_unique<VulkanApplicationBufferManager>(deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice(), deviceManager->getGraphicsQueue(), commandPool);
+	textureManager = std::make_unique<VulkanApplicationTextureManager>(deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice(), *memoryAllocator, *uploadContext,
+		deviceManager->getEnabledFeatures().textureCompressionBC);
+	bufferManager = std::make_unique<VulkanApplicationBufferManager>(deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice(), *memoryAllocator, *uploadContext);
+	createBindlessTextures();
+	// pipelines need the vertex format the mesh was encoded in
+	auto pipelineStart = std::chrono::high_resolution_clock::now();
+	graphicsManager->createGraphicsPipeline(deviceManager->getLogicalDevice(), pipelineCache->getPipelineCache(), descriptorSetLayout,
+		bindlessTextures ? bindlessTextures->getDescriptorSetLayout() : VK_NULL_HANDLE, bufferManager->getVertexFormat());
+	// cold is a full shader compile, warm should be a fraction of it
+	if (debug) {
+		cout << "Graphics pipelines created in " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - pipelineStart).count()
+			<< " ms, " << (pipelineCache->isWarm() ? "warm" : "cold") << " pipeline cache" << endl;
+	}
+	createGpuCuller();
+	// everything above was only recorded, one submit for all of it
+	uploadContext->submit();
 	createDescriptorPool();		// descriptor file
 	createDescriptorSets();		// descriptor file
 	createCommandBuffer();		// command
+	commandRecorder = std::make_unique<VulkanApplicationCommandRecorder>(deviceManager->getLogicalDevice(), deviceManager->getQueueFamilyIndices().graphicsFamily.value());
 	createSyncObjects();		// sync
 }
 
@@ -77,6 +87,7 @@ void HelloTriangleApplication::initWindow() {
 	window = glfwCreateWindow(kWIDTH, kHEIGHT, "Vulkan", nullptr, nullptr);
 	glfwSetWindowUserPointer(window, this);
 	glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+	glfwSetKeyCallback(window, keyCallback);
 }
 
 void HelloTriangleApplication::framebufferResizeCallback(GLFWwindow* window, int width, int height) {
@@ -84,9 +95,181 @@ void HelloTriangleApplication::framebufferResizeCallback(GLFWwindow* window, int
 	app->framebufferResized = true;
 }
 
+void HelloTriangleApplication::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+
+	if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+		uint32_t next = (static_cast<uint32_t>(app->drawPath) + 1) % static_cast<uint32_t>(DrawPath::kCount);
+
+		// skipped on devices that can't put the object index in an indirect draw
+		if (static_cast<DrawPath>(next) == DrawPath::kGpuDriven && !app->gpuCuller) {
+			next = (next + 1) % static_cast<uint32_t>(DrawPath::kCount);
+		}
+
+		app->setDrawPath(static_cast<DrawPath>(next));
+	}
+
+	if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+		if (app->drawPathFrames > 0) {
+			app->reportDrawPathTiming();
+		}
+
+		app->bufferManager->setLodEnabled(!app->bufferManager->getLodEnabled());
+		cout << "LOD: " << (app->bufferManager->getLodEnabled() ? "On" : "Off") << endl;
+	}
+
+	if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+		if (app->drawPathFrames > 0) {
+			app->reportDrawPathTiming();
+		}
+
+		app->bufferManager->setCullingEnabled(!app->bufferManager->getCullingEnabled());
+		cout << "CPU Culling: " << (app->bufferManager->getCullingEnabled() ? "On" : "Off") << endl;
+	}
+
+	// inline, then 1, 2, 4... recording threads up to the recorder's limit
+	if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+		if (app->drawPathFrames > 0) {
+			app->reportDrawPathTiming();
+		}
+
+		uint32_t maxThreads = app->commandRecorder->getMaxThreads();
+		uint32_t threads = app->recordingThreads;
+		app->recordingThreads = threads == 0 ? 1 : (threads >= maxThreads ? 0 : std::min(threads * 2, maxThreads));
+		cout << "Recording Threads: " << (app->recordingThreads > 0 ? std::to_string(app->recordingThreads) : "Inline") << endl;
+	}
+
+	// quarters the texture budget down to the minimum then goes back to the full one, levels get evicted and streamed back in
+	if (key == GLFW_KEY_B && action == GLFW_PRESS) {
+		VulkanApplicationStreamingTexture& texture = app->textureManager->getStreamingTexture();
+		VkDeviceSize budget = texture.getBudget();
+		texture.setBudget(budget <= kMIN_TEXTURE_STREAMING_BUDGET ? kTEXTURE_STREAMING_BUDGET : budget / 4);
+		cout << "Texture Budget: " << texture.getBudget() / 1024 << " KiB" << endl;
+	}
+
+	// the new pipelines compile in jobs, every path keeps drawing with the previous ones until they're ready
+	if (key == GLFW_KEY_S && action == GLFW_PRESS) {
+		std::vector<ShaderPermutation> presets = getShaderPermutationPresets();
+		app->shaderPermutationIndex = (app->shaderPermutationIndex + 1) % static_cast<uint32_t>(presets.size());
+		app->graphicsManager->setShaderPermutation(presets[app->shaderPermutationIndex]);
+		cout << "Shader Permutation: " << getShaderPermutationName(presets[app->shaderPermutationIndex]) << endl;
+	}
+}
+
+void HelloTriangleApplication::setDrawPath(DrawPath newDrawPath) {
+	if (drawPathFrames > 0) {
+		reportDrawPathTiming();
+	}
+
+	drawPath = newDrawPath;
+	cout << "Draw Path: " << getDrawPathName(drawPath) << endl;
+}
+
+void HelloTriangleApplication::reportDrawPathTiming() {
+	// cpu side only, the gpu cost of every path is close to identical since they draw the same triangles
+	cout << getDrawPathName(drawPath) << ": " << (drawPathCpuTime / drawPathFrames) * 1000.0 << " ms per frame updating + recording "
+		<< drawPathDrawCalls / drawPathFrames << " draws for " << kOBJECT_COUNT << " objects (" << drawPathFrames << " frames)" << endl;
+	cout << "  LOD " << (bufferManager->getLodEnabled() ? "on" : "off") << ": " << lodTrianglesSubmitted / drawPathFrames
+		<< " triangles per frame, " << lodTrianglesWithoutLod / drawPathFrames << " without LOD" << endl;
+
+	cout << "  Scene graph: " << (sceneGraphCpuTime / drawPathFrames) * 1e6 << " us per frame propagating, " << sceneGraphMatricesWritten / drawPathFrames
+		<< " model matrices written per frame" << endl;
+
+	bool threadedRecording = recordingThreads > 0 && (drawPath == DrawPath::kUniformBuffer || drawPath == DrawPath::kPushConstants);
+	cout << "  Recording: " << (recordingCpuTime / drawPathFrames) * 1e6 << " us per frame, "
+		<< (threadedRecording ? std::to_string(recordingThreads) + " threads into secondary command buffers" : std::string("inline on the main thread")) << endl;
+
+	if (drawPath != DrawPath::kGpuDriven) {
+		cout << "  CPU culling " << (bufferManager->getCullingEnabled() ? "on" : "off") << " (" << getCullingSimdName() << "): "
+			<< cullingVisibleObjects / drawPathFrames << " of " << kOBJECT_COUNT << " objects visible, "
+			<< (cullingCpuTime / drawPathFrames) * 1e6 << " us per frame culling" << endl;
+	} else {
+		GpuCullStats cullStats = gpuCuller->getStats();
+		cout << "  " << getIndirectDrawModeName(gpuCuller->getDrawMode()) << ": " << cullStats.visibleObjects << " of " << kOBJECT_COUNT
+			<< " objects visible, " << cullStats.framesMismatched << " of " << cullStats.framesValidated << " frames disagreed with the cpu" << endl;
+	}
+
+	drawPathCpuTime = 0.0;
+	cullingCpuTime = 0.0;
+	cullingVisibleObjects = 0;
+	sceneGraphCpuTime = 0.0;
+	sceneGraphMatricesWritten = 0;
+	recordingCpuTime = 0.0;
+	drawPathDrawCalls = 0;
+	lodTrianglesSubmitted = 0;
+	lodTrianglesWithoutLod = 0;
+	drawPathFrames = 0;
+}
+
+void HelloTriangleApplication::createGpuCuller() {
+	VkPhysicalDeviceFeatures features = deviceManager->getEnabledFeatures();
+
+	if (!isGpuCullingSupported(features, deviceManager->getGraphicsComputeSupported())) {
+		if (debug) {
+			cout << "GPU driven path unavailable, needs drawIndirectFirstInstance and compute on the graphics queue" << endl;
+		}
+
+		return;
+	}
+
+	IndirectDrawMode drawMode = selectIndirectDrawMode(features, deviceManager->getDrawIndirectCountEnabled());
+	gpuCuller = std::make_unique<VulkanApplicationGpuCuller>(deviceManager->getLogicalDevice(), *memoryAllocator, pipelineCache->getPipelineCache(), drawMode, kOBJECT_COUNT,
+		bufferManager->getMeshLods(), bufferManager->getBoundingSphere(), bufferManager->getInstanceBuffers());
+
+	if (debug) {
+		cout << "GPU driven path draws with " << getIndirectDrawModeName(gpuCuller->getDrawMode()) << endl;
+	}
+}
+
+void HelloTriangleApplication::createBindlessTextures() {
+	if (!deviceManager->getDescriptorIndexingEnabled()) {
+		if (debug) {
+			cout << "Bindless textures unavailable, needs descriptor indexing, drawing with binding 1" << endl;
+		}
+
+		return;
+	}
+
+	bindlessTextures = std::make_unique<VulkanApplicationBindlessTextures>(deviceManager->getLogicalDevice(), deviceManager->getPhysicalDevice());
+
+	// one slot per cached texture, materials that got the same texture from the cache share its slot
+	VulkanApplicationTextureCache& textureCache = textureManager->getTextureCache();
+	std::vector<uint32_t> materialSlots;
+
+	for (uint32_t material = 0; material < textureManager->getMaterialCount(); material++) {
+		TextureHandle texture = textureManager->getMaterialTexture(material);
+		auto found = std::find_if(slotTextures.begin(), slotTextures.end(), [&](TextureHandle slotTexture) { return slotTexture.index == texture.index; });
+
+		if (found != slotTextures.end()) {
+			materialSlots.push_back(static_cast<uint32_t>(found - slotTextures.begin()));
+		} else {
+			materialSlots.push_back(bindlessTextures->registerTexture(textureCache.getImageView(texture), textureCache.getSampler(texture)));
+			slotTextures.push_back(texture);
+		}
+	}
+
+	for (uint32_t i = 0; i < kOBJECT_COUNT; i++) {
+		bufferManager->setObjectMaterial(i, materialSlots[i % materialSlots.size()]);
+	}
+}
+
+void HelloTriangleApplication::recordGpuCull(VkCommandBuffer commandBuffer) {
+	Frustum frustum = extractFrustum(bufferManager->getViewProjection());
+
+	CullPushConstants pushConstants{};
+	pushConstants.planes = frustum.planes;
+	pushConstants.eye = glm::vec4(bufferManager->getEye(), bufferManager->getPixelsPerUnit() / kLOD_PIXEL_ERROR);
+	pushConstants.flags = bufferManager->getLodEnabled() ? kCULL_FLAG_LOD : 0;
+	gpuCuller->recordCull(commandBuffer, currentFrame, pushConstants);
+
+	if (debug) {
+		gpuCuller->validate(currentFrame, bufferManager->getObjectModels(), frustum);
+	}
+}
+
 void HelloTriangleApplication::createDescriptorPool() {
 	std::array<VkDescriptorPoolSize, 2> poolSizes{};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	poolSizes[0].descriptorCount = static_cast<uint32_t>(kMAX_FRAMES_IN_FLIGHT);
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	poolSizes[1].descriptorCount = static_cast<uint32_t>(kMAX_FRAMES_IN_FLIGHT);
@@ -111,6 +294,7 @@ void HelloTriangleApplication::createDescriptorSets() {
 	allocInfo.pSetLayouts = layouts.data();
 
 	descriptorSets.resize(kMAX_FRAMES_IN_FLIGHT);
+	descriptorImageViews.resize(kMAX_FRAMES_IN_FLIGHT);
 
 	if (vkAllocateDescriptorSets(deviceManager->getLogicalDevice(), &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to allocate Descriptor Sets");
@@ -118,7 +302,8 @@ void HelloTriangleApplication::createDescriptorSets() {
 
 	for (size_t i = 0; i < kMAX_FRAMES_IN_FLIGHT; i++) {
 		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = bufferManager->getUniformBuffers()[i];
+		// the whole arena is bound once, each draw picks its ubo with a dynamic offset
+		bufferInfo.buffer = bufferManager->getUniformArena().getBuffer(static_cast<uint32_t>(i));
 		bufferInfo.offset = 0;
 		bufferInfo.range = sizeof(UniformBufferObject);
 
@@ -126,13 +311,14 @@ void HelloTriangleApplication::createDescriptorSets() {
 		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		imageInfo.imageView = textureManager->getTextureImageView();
 		imageInfo.sampler = textureManager->getTextureSampler();
+		descriptorImageViews[i] = imageInfo.imageView;
 
 		std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
 		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		descriptorWrites[0].dstSet = descriptorSets[i];
 		descriptorWrites[0].dstBinding = 0;
 		descriptorWrites[0].dstArrayElement = 0;
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		descriptorWrites[0].descriptorCount = 1;
 		descriptorWrites[0].pBufferInfo = &bufferInfo;
 
@@ -148,10 +334,44 @@ void HelloTriangleApplication::createDescriptorSets() {
 	}
 }
 
+// only called once the frame's fence has signalled, a set can't be updated while a submitted frame still uses it
+void HelloTriangleApplication::updateTextureDescriptor(uint32_t frameIndex) {
+	VkImageView imageView = textureManager->getTextureImageView();
+
+	if (bindlessTextures) {
+		for (uint32_t slot = 0; slot < slotTextures.size(); slot++) {
+			bindlessTextures->setTexture(slot, textureManager->getTextureCache().getImageView(slotTextures[slot]));
+		}
+
+		bindlessTextures->flush(frameIndex);
+	}
+
+	if (descriptorImageViews[frameIndex] == imageView) {
+		return;
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = imageView;
+	imageInfo.sampler = textureManager->getTextureSampler();
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = descriptorSets[frameIndex];
+	descriptorWrite.dstBinding = 1;
+	descriptorWrite.dstArrayElement = 0;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(deviceManager->getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+	descriptorImageViews[frameIndex] = imageView;
+}
+
 void HelloTriangleApplication::createDescriptorSetLayout() {
 	VkDescriptorSetLayoutBinding uboLayoutBinding{};
 	uboLayoutBinding.binding = 0;
-	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboLayoutBinding.descriptorCount = 1;
 	uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 	uboLayoutBinding.pImmutableSamplers = nullptr;
@@ -233,13 +453,68 @@ void HelloTriangleApplication::recordCommandBuffer(VkCommandBuffer commandBuffer
 	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassInfo.pClearValues = clearValues.data();
 
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsManager->getGraphicsPipeline());
+	// looked up once per frame, every command buffer binds the same one. a pipeline that's still compiling only clears the frame instead of stalling it
+	VkPipeline pipeline = graphicsManager->getGraphicsPipeline(drawPath);
+	bool pipelineReady = pipeline != VK_NULL_HANDLE;
+
+	if (drawPath == DrawPath::kGpuDriven && pipelineReady) {
+		// compute can't run inside a render pass
+		recordGpuCull(commandBuffer);
+	}
+
+	// only the per object paths have enough draws to be worth spreading across threads
+	bool perObjectDraws = drawPath == DrawPath::kUniformBuffer || drawPath == DrawPath::kPushConstants;
+	auto recordStart = std::chrono::high_resolution_clock::now();
+
+	if (!pipelineReady) {
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	} else if (perObjectDraws && recordingThreads > 0) {
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+		uint32_t drawCount = static_cast<uint32_t>(bufferManager->getVisibleObjects().size());
+		drawPathDrawCalls += commandRecorder->record(commandBuffer, currentFrame, recordingThreads, renderPassInfo.renderPass, renderPassInfo.framebuffer, drawCount,
+			[this, pipeline](VkCommandBuffer secondaryCommandBuffer, uint32_t first, uint32_t last) {
+				recordDrawState(secondaryCommandBuffer, pipeline);
+				return recordObjectDraws(secondaryCommandBuffer, first, last);
+			});
+	} else {
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		recordDrawState(commandBuffer, pipeline);
+
+		if (drawPath == DrawPath::kGpuDriven) {
+			// the culling pass decided the draws
+			drawPathDrawCalls += gpuCuller->recordDraws(commandBuffer, currentFrame);
+		} else if (drawPath == DrawPath::kInstanced) {
+			// each lod in use is a single draw
+			std::vector<MeshLod>& meshLods = bufferManager->getMeshLods();
+
+			for (const InstanceBatch& batch : bufferManager->getInstanceBatches()) {
+				const MeshLod& lod = meshLods[batch.lod];
+				vkCmdDrawIndexed(commandBuffer, lod.indexCount, batch.instanceCount, lod.firstIndex, 0, batch.firstInstance);
+				drawPathDrawCalls++;
+			}
+		} else {
+			drawPathDrawCalls += recordObjectDraws(commandBuffer, 0, static_cast<uint32_t>(bufferManager->getVisibleObjects().size()));
+		}
+	}
+
+	recordingCpuTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - recordStart).count();
+
+	vkCmdEndRenderPass(commandBuffer);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Record Command Buffer");
+	}
+}
+
+// everything a command buffer needs before drawing, secondaries inherit none of it
+void HelloTriangleApplication::recordDrawState(VkCommandBuffer commandBuffer, VkPipeline pipeline) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
 	VkBuffer vertexBuffers[] = { bufferManager->getVertexBuffer()};
 	VkDeviceSize offsets[] = {0};
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-	vkCmdBindIndexBuffer(commandBuffer, bufferManager->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT16);
+	vkCmdBindIndexBuffer(commandBuffer, bufferManager->getIndexBuffer(), 0, bufferManager->getIndexType());
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -255,16 +530,67 @@ void HelloTriangleApplication::recordCommandBuffer(VkCommandBuffer commandBuffer
 	scissor.extent = swapchainManager->getSwapchainExtent();
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
+	if (bindlessTextures) {
+		// every texture any draw samples, bound once per command buffer, set 0 rebinding on the uniform path leaves it alone
+		VkDescriptorSet textureSet = bindlessTextures->getDescriptorSet(currentFrame);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsManager->getPipelineLayout(),
+			kBINDLESS_TEXTURE_SET, 1, &textureSet, 0, nullptr);
+	}
+
+	if (drawPath == DrawPath::kUniformBuffer) {
+		// bound per draw with each object's dynamic offset
+		return;
+	}
+
+	// one bind for the camera, the model comes from push constants or the instance binding
+	uint32_t cameraOffset = bufferManager->getCameraUniformOffset();
 	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsManager->getPipelineLayout(),
-		0, 1, &descriptorSets[currentFrame], 0, nullptr);
+		0, 1, &descriptorSets[currentFrame], 1, &cameraOffset);
 
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(bufferManager->getIndices().size()), 1, 0, 0, 0);
+	if (drawPath == DrawPath::kInstanced || drawPath == DrawPath::kGpuDriven) {
+		VkBuffer instanceBuffer = bufferManager->getInstanceBuffer(currentFrame);
+		VkDeviceSize instanceOffset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, kINSTANCE_BINDING, 1, &instanceBuffer, &instanceOffset);
+	}
+}
 
-	vkCmdEndRenderPass(commandBuffer);
+// visible objects [first, last) one draw each, only reads shared state so recording threads can call it side by side
+uint32_t HelloTriangleApplication::recordObjectDraws(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last) {
+	std::vector<MeshLod>& meshLods = bufferManager->getMeshLods();
+	std::vector<uint32_t>& objectLods = bufferManager->getObjectLods();
+	std::vector<uint32_t>& visibleObjects = bufferManager->getVisibleObjects();
+
+	if (drawPath == DrawPath::kPushConstants) {
+		std::vector<glm::mat4>& objectModels = bufferManager->getObjectModels();
+		std::vector<uint32_t>& objectMaterials = bufferManager->getObjectMaterials();
+		ObjectPushConstants pushConstants{};
+
+		for (uint32_t v = first; v < last; v++) {
+			uint32_t i = visibleObjects[v];
+			pushConstants.model = objectModels[i];
+			pushConstants.objectIndex = i;
+			pushConstants.materialIndex = objectMaterials[i];
+			vkCmdPushConstants(commandBuffer, graphicsManager->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT,
+				0, sizeof(ObjectPushConstants), &pushConstants);
+
+			const MeshLod& lod = meshLods[objectLods[i]];
+			vkCmdDrawIndexed(commandBuffer, lod.indexCount, 1, lod.firstIndex, 0, 0);
+		}
+	} else {
+		std::vector<uint32_t>& objectUniformOffsets = bufferManager->getObjectUniformOffsets();
 
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to Record Command Buffer");
+		// same set every draw, only the dynamic offset into this frame's uniform arena changes
+		for (uint32_t v = first; v < last; v++) {
+			uint32_t i = visibleObjects[v];
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsManager->getPipelineLayout(),
+				0, 1, &descriptorSets[currentFrame], 1, &objectUniformOffsets[i]);
+
+			const MeshLod& lod = meshLods[objectLods[i]];
+			vkCmdDrawIndexed(commandBuffer, lod.indexCount, 1, lod.firstIndex, 0, 0);
+		}
 	}
+
+	return last - first;
 }
 
 void HelloTriangleApplication::createCommandPool() {
@@ -307,17 +633,49 @@ void HelloTriangleApplication::drawFrame() {
 	VkResult result = vkAcquireNextImageKHR(deviceManager->getLogicalDevice(), swapchainManager->getSwapchain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-		swapchainManager->recreateSwapchain(deviceManager->getPhysicalDevice(), deviceManager->getLogicalDevice(), surface, window, graphicsManager->getRenderPass(), deviceManager->getGraphicsQueue(), commandPool);
+		swapchainManager->recreateSwapchain(deviceManager->getPhysicalDevice(), deviceManager->getLogicalDevice(), *memoryAllocator, surface, window, graphicsManager->getRenderPass(), *uploadContext);
 		return;
 	} else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
 		throw std::runtime_error("Failed to Acquire Swapchain Image");
 	}
 
 	vkResetFences(deviceManager->getLogicalDevice(), 1, &inFlightFences[currentFrame]);
+	stagingRing->retire();
+
+	if (gpuCuller) {
+		// this frame's last culling results are complete now that its fence has signalled
+		gpuCuller->collectResults(currentFrame);
+	}
+
+	// starts the next streaming upload and swaps in the last one once it landed
+	if (textureManager->update(*uploadContext, frameNumber) && debug) {
+		VulkanApplicationStreamingTexture& texture = textureManager->getStreamingTexture();
+		cout << "Texture: mip " << texture.getResidentMip() << " of " << texture.getMipCount() << " resident, "
+			<< texture.getResidentBytes() / 1024 << " KiB" << endl;
+	}
+
+	updateTextureDescriptor(currentFrame);
 
+	auto cpuStart = std::chrono::high_resolution_clock::now();
+
+	// uniforms first, recording needs this frame's dynamic offsets
+	bufferManager->updateUniformBuffer(currentFrame, swapchainManager->getSwapchainExtent(), drawPath);
 	vkResetCommandBuffer(commandBuffers[currentFrame], 0);
 	recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
-	bufferManager->updateUniformBuffer(currentFrame, swapchainManager->getSwapchainExtent());
+
+	drawPathCpuTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - cpuStart).count();
+	drawPathFrames++;
+	// the gpu driven path only knows its triangle count once a frame has been read back, so it lags by kMAX_FRAMES_IN_FLIGHT
+	lodTrianglesSubmitted += drawPath == DrawPath::kGpuDriven ? gpuCuller->getStats().trianglesSubmitted : bufferManager->getLodStats().trianglesSubmitted;
+	lodTrianglesWithoutLod += bufferManager->getLodStats().trianglesWithoutLod;
+	cullingCpuTime += bufferManager->getCullingSeconds();
+	cullingVisibleObjects += bufferManager->getCullingStats().visibleObjects;
+	sceneGraphCpuTime += bufferManager->getSceneGraphSeconds();
+	sceneGraphMatricesWritten += bufferManager->getSceneGraphStats().matricesWritten;
+
+	if (debug && drawPathFrames == 1000) {
+		reportDrawPathTiming();
+	}
 
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -356,23 +714,32 @@ void HelloTriangleApplication::drawFrame() {
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
 		framebufferResized = false;
-		swapchainManager->recreateSwapchain(deviceManager->getPhysicalDevice(), deviceManager->getLogicalDevice(), surface, window, graphicsManager->getRenderPass(), deviceManager->getGraphicsQueue(), commandPool);
+		swapchainManager->recreateSwapchain(deviceManager->getPhysicalDevice(), deviceManager->getLogicalDevice(), *memoryAllocator, surface, window, graphicsManager->getRenderPass(), *uploadContext);
 	} else if (result != VK_SUCCESS) {
 		throw std::runtime_error("Failed to Present Swapchain Image");
 	}
 
 	currentFrame = (currentFrame + 1) % kMAX_FRAMES_IN_FLIGHT;
+	frameNumber++;
 }
 
 void HelloTriangleApplication::cleanup() {
 	// done automatically -> vkFreeCommandBuffers(deviceManager->getLogicalDevice(), commandPool, 1, &commandBuffer);
-	swapchainManager->cleanup(deviceManager->getLogicalDevice());
-	textureManager->cleanup(deviceManager->getLogicalDevice());
+	swapchainManager->cleanup(deviceManager->getLogicalDevice(), *memoryAllocator);
+	textureManager->cleanup(deviceManager->getLogicalDevice(), *memoryAllocator);
 
 	vkDestroyDescriptorPool(deviceManager->getLogicalDevice(), descriptorPool, nullptr);
 	vkDestroyDescriptorSetLayout(deviceManager->getLogicalDevice(), descriptorSetLayout, nullptr);
 
-	bufferManager->cleanup(deviceManager->getLogicalDevice());
+	if (bindlessTextures) {
+		bindlessTextures->cleanup();
+	}
+
+	if (gpuCuller) {
+		gpuCuller->cleanup();
+	}
+
+	bufferManager->cleanup(deviceManager->getLogicalDevice(), *memoryAllocator);
 	graphicsManager->cleanup(deviceManager->getLogicalDevice());
 
 	for (size_t i = 0; i < kMAX_FRAMES_IN_FLIGHT; i++) {
@@ -381,8 +748,13 @@ void HelloTriangleApplication::cleanup() {
 		vkDestroyFence(deviceManager->getLogicalDevice(), inFlightFences[i], nullptr);
 	}
 
+	commandRecorder->cleanup();
 	vkDestroyCommandPool(deviceManager->getLogicalDevice(), commandPool, nullptr);
 
+	uploadContext->cleanup();
+	stagingRing->cleanup();
+	memoryAllocator->cleanup();
+	pipelineCache->cleanup();
 	deviceManager->cleanup();
 
 	// nullptr is a custom allocator callback
@@ -0,0 +1,147 @@
+#include "headers/VulkanApplicationBindlessTextures.h"
+
+VulkanApplicationBindlessTextures::VulkanApplicationBindlessTextures(VkDevice logicalDevice, VkPhysicalDevice physicalDevice) {
+	this->logicalDevice = logicalDevice;
+
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties{};
+	indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+	VkPhysicalDeviceProperties2 properties{};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &indexingProperties;
+	vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+	// the limits count every sampler the stage sees, binding 1 of set 0 is one of them
+	capacity = std::min({ kBINDLESS_TEXTURE_CAPACITY,
+		indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers - 1,
+		indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages - 1,
+		indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+		indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages });
+
+	VkDescriptorSetLayoutBinding textureBinding{};
+	textureBinding.binding = 0;
+	textureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	textureBinding.descriptorCount = capacity;
+	textureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorBindingFlagsEXT bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+		VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+	bindingFlagsInfo.bindingCount = 1;
+	bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &bindingFlagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &textureBinding;
+
+	if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Bindless Descriptor Set Layout");
+	}
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSize.descriptorCount = capacity * kMAX_FRAMES_IN_FLIGHT;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = kMAX_FRAMES_IN_FLIGHT;
+
+	if (vkCreateDescriptorPool(logicalDevice, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Bindless Descriptor Pool");
+	}
+
+	std::vector<VkDescriptorSetLayout> layouts(kMAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = static_cast<uint32_t>(kMAX_FRAMES_IN_FLIGHT);
+	allocInfo.pSetLayouts = layouts.data();
+
+	descriptorSets.resize(kMAX_FRAMES_IN_FLIGHT);
+	writtenViews.resize(kMAX_FRAMES_IN_FLIGHT);
+
+	if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Allocate Bindless Descriptor Sets");
+	}
+
+	if (debug) {
+		cout << "Bindless texture table holds " << capacity << " textures" << endl;
+	}
+}
+
+VulkanApplicationBindlessTextures::~VulkanApplicationBindlessTextures() {}
+
+void VulkanApplicationBindlessTextures::cleanup() {
+	// destroying the pool frees the sets
+	vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(logicalDevice, descriptorSetLayout, nullptr);
+}
+
+void VulkanApplicationBindlessTextures::writeSlot(uint32_t frameIndex, uint32_t slot) {
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = descriptorSets[frameIndex];
+	descriptorWrite.dstBinding = 0;
+	descriptorWrite.dstArrayElement = slot;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pImageInfo = &textures[slot];
+
+	vkUpdateDescriptorSets(logicalDevice, 1, &descriptorWrite, 0, nullptr);
+	writtenViews[frameIndex][slot] = textures[slot].imageView;
+}
+
+// the new slot isn't sampled by anything in flight yet, so every frame's set gets it right away
+uint32_t VulkanApplicationBindlessTextures::registerTexture(VkImageView imageView, VkSampler sampler) {
+	if (textures.size() >= capacity) {
+		throw std::runtime_error("Bindless Texture Table Is Full");
+	}
+
+	uint32_t slot = static_cast<uint32_t>(textures.size());
+	textures.push_back({ sampler, imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+
+	for (uint32_t frame = 0; frame < kMAX_FRAMES_IN_FLIGHT; frame++) {
+		writtenViews[frame].push_back(VK_NULL_HANDLE);
+		writeSlot(frame, slot);
+	}
+
+	return slot;
+}
+
+// only remembered here, each frame's set picks it up in its next flush()
+void VulkanApplicationBindlessTextures::setTexture(uint32_t slot, VkImageView imageView) {
+	textures[slot].imageView = imageView;
+}
+
+// call once the frame's fence has signalled, before recording anything that binds its set
+void VulkanApplicationBindlessTextures::flush(uint32_t frameIndex) {
+	for (uint32_t slot = 0; slot < textures.size(); slot++) {
+		if (writtenViews[frameIndex][slot] != textures[slot].imageView) {
+			writeSlot(frameIndex, slot);
+		}
+	}
+}
+
+VkDescriptorSetLayout VulkanApplicationBindlessTextures::getDescriptorSetLayout() {
+	return this->descriptorSetLayout;
+}
+
+VkDescriptorSet VulkanApplicationBindlessTextures::getDescriptorSet(uint32_t frameIndex) {
+	return this->descriptorSets[frameIndex];
+}
+
+uint32_t VulkanApplicationBindlessTextures::getCapacity() {
+	return this->capacity;
+}
+
+uint32_t VulkanApplicationBindlessTextures::getTextureCount() {
+	return static_cast<uint32_t>(this->textures.size());
+}
\ No newline at end of file
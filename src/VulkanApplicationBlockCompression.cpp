@@ -0,0 +1,873 @@
+#include "headers/VulkanApplicationBlockCompression.h"
+#include "headers/VulkanApplicationJobSystem.h"
+#include <cmath>
+#include <cstring>
+
+/***** FORMATS *****/
+
+bool isBlockCompressed(VkFormat format) {
+	switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return true;
+		default:
+			return false;
+	}
+}
+
+uint32_t getBlockBytes(VkFormat format) {
+	switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			return 8;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return 16;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			return 4;
+		default:
+			throw std::runtime_error("Unsupported Texture Format");
+	}
+}
+
+VkDeviceSize getMipBytes(VkFormat format, uint32_t width, uint32_t height) {
+	if (!isBlockCompressed(format)) {
+		return static_cast<VkDeviceSize>(width) * height * getBlockBytes(format);
+	}
+
+	return static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4) * getBlockBytes(format);
+}
+
+VkFormat getDecompressedFormat(VkFormat format) {
+	switch (format) {
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			return VK_FORMAT_R8G8B8A8_SRGB;
+		default:
+			return VK_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+const char* getFormatName(VkFormat format) {
+	switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+			return "BC1";
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			return "BC1 sRGB";
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+			return "BC3";
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			return "BC3 sRGB";
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			return "BC5";
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+			return "BC7";
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return "BC7 sRGB";
+		case VK_FORMAT_R8G8B8A8_UNORM:
+			return "RGBA8";
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			return "RGBA8 sRGB";
+		default:
+			return "Unknown";
+	}
+}
+
+/***** BC7 TABLES *****/
+
+struct Bc7Mode {
+	uint32_t subsets;
+	uint32_t partitionBits;
+	uint32_t rotationBits;
+	uint32_t indexSelectionBits;
+	uint32_t colorBits;
+	uint32_t alphaBits; // 0 means opaque
+	uint32_t endpointPBits; // one p bit per endpoint
+	uint32_t sharedPBits; // one p bit per subset
+	uint32_t indexBits;
+	uint32_t secondaryIndexBits; // modes 4 and 5 index alpha separately
+};
+
+static const Bc7Mode kBC7_MODES[8] = {
+	{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+	{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+	{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+	{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+	{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+	{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+	{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+	{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+};
+
+// bit n is the subset of texel n
+static const uint16_t kBC7_PARTITIONS_2[64] = {
+	0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+	0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+	0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+	0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+	0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+	0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+	0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+	0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+};
+
+static const uint8_t kBC7_PARTITIONS_3[64][16] = {
+	{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 }, { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+	{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 }, { 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+	{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+	{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 }, { 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+	{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+	{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 }, { 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+	{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 }, { 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+	{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 }, { 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+	{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 }, { 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+	{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 }, { 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+	{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 }, { 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 }, { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+	{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 }, { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+	{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 }, { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 }, { 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 }, { 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+	{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 }, { 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+	{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 }, { 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+	{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 }, { 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+	{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 }, { 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+	{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+	{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 }, { 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+	{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 }
+};
+
+// the texel of every subset but the first whose index is stored a bit short, subset 0 always uses texel 0
+static const uint8_t kBC7_ANCHORS_2[64] = {
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+	15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+	6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+};
+
+static const uint8_t kBC7_ANCHORS_3_SECOND[64] = {
+	3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+	3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+	8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+	3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+};
+
+static const uint8_t kBC7_ANCHORS_3_THIRD[64] = {
+	15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+	15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+	15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+	15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+};
+
+static const uint8_t kBC7_WEIGHTS_2[4] = { 0, 21, 43, 64 };
+static const uint8_t kBC7_WEIGHTS_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint8_t kBC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static uint32_t getBc7Subset(uint32_t subsets, uint32_t partition, uint32_t texel) {
+	if (subsets == 2) {
+		return (kBC7_PARTITIONS_2[partition] >> texel) & 1;
+	}
+
+	return subsets == 3 ? kBC7_PARTITIONS_3[partition][texel] : 0;
+}
+
+static bool isBc7Anchor(uint32_t subsets, uint32_t partition, uint32_t texel) {
+	if (texel == 0) {
+		return true;
+	}
+
+	if (subsets == 2) {
+		return texel == kBC7_ANCHORS_2[partition];
+	}
+
+	return subsets == 3 && (texel == kBC7_ANCHORS_3_SECOND[partition] || texel == kBC7_ANCHORS_3_THIRD[partition]);
+}
+
+static uint32_t getBc7Weight(uint32_t indexBits, uint32_t index) {
+	return indexBits == 2 ? kBC7_WEIGHTS_2[index] : (indexBits == 3 ? kBC7_WEIGHTS_3[index] : kBC7_WEIGHTS_4[index]);
+}
+
+static uint8_t interpolateBc7(uint32_t a, uint32_t b, uint32_t weight) {
+	return static_cast<uint8_t>(((64 - weight) * a + weight * b + 32) >> 6);
+}
+
+// blocks are little endian bit streams, the first field starts at bit 0 of byte 0
+struct BlockBitReader {
+	const uint8_t* data;
+	uint32_t position;
+
+	uint32_t read(uint32_t count) {
+		uint32_t value = 0;
+
+		for (uint32_t i = 0; i < count; i++, position++) {
+			value |= ((data[position >> 3] >> (position & 7)) & 1u) << i;
+		}
+
+		return value;
+	}
+};
+
+struct BlockBitWriter {
+	uint8_t* data; // has to start zeroed
+	uint32_t position;
+
+	void write(uint32_t value, uint32_t count) {
+		for (uint32_t i = 0; i < count; i++, position++) {
+			data[position >> 3] |= static_cast<uint8_t>(((value >> i) & 1u) << (position & 7));
+		}
+	}
+};
+
+/***** DECODING *****/
+
+static void expand565(uint16_t color, uint8_t* texel) {
+	uint32_t r = (color >> 11) & 31;
+	uint32_t g = (color >> 5) & 63;
+	uint32_t b = color & 31;
+	texel[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+	texel[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+	texel[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+	texel[3] = 255;
+}
+
+// shared with the encoder so both agree on the interpolated colors
+static void buildBc1Palette(uint16_t color0, uint16_t color1, bool alwaysFourColors, uint8_t palette[4][4]) {
+	expand565(color0, palette[0]);
+	expand565(color1, palette[1]);
+
+	for (uint32_t c = 0; c < 3; c++) {
+		uint32_t a = palette[0][c];
+		uint32_t b = palette[1][c];
+
+		if (color0 > color1 || alwaysFourColors) {
+			palette[2][c] = static_cast<uint8_t>((2 * a + b + 1) / 3);
+			palette[3][c] = static_cast<uint8_t>((a + 2 * b + 1) / 3);
+		} else {
+			palette[2][c] = static_cast<uint8_t>((a + b + 1) / 2);
+			palette[3][c] = 0;
+		}
+	}
+
+	palette[2][3] = 255;
+	// the 3 color mode's last entry is transparent black
+	palette[3][3] = (color0 > color1 || alwaysFourColors) ? 255 : 0;
+}
+
+static void buildBc4Palette(uint8_t value0, uint8_t value1, uint8_t palette[8]) {
+	palette[0] = value0;
+	palette[1] = value1;
+
+	if (value0 > value1) {
+		for (uint32_t i = 2; i < 8; i++) {
+			palette[i] = static_cast<uint8_t>(((8 - i) * value0 + (i - 1) * value1 + 3) / 7);
+		}
+	} else {
+		for (uint32_t i = 2; i < 6; i++) {
+			palette[i] = static_cast<uint8_t>(((6 - i) * value0 + (i - 1) * value1 + 2) / 5);
+		}
+
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+// bc2 and bc3 color blocks always interpolate 4 colors, whatever the endpoint order
+static void decodeBc1Block(const uint8_t* block, uint8_t* texels, bool alwaysFourColors) {
+	uint8_t palette[4][4];
+	buildBc1Palette(static_cast<uint16_t>(block[0] | (block[1] << 8)), static_cast<uint16_t>(block[2] | (block[3] << 8)), alwaysFourColors, palette);
+
+	uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		memcpy(&texels[texel * 4], palette[(indices >> (texel * 2)) & 3], 4);
+	}
+}
+
+// one channel of the 16 rgba texels
+static void decodeBc4Block(const uint8_t* block, uint8_t* texels, uint32_t channel) {
+	uint8_t palette[8];
+	buildBc4Palette(block[0], block[1], palette);
+
+	uint64_t indices = 0;
+
+	for (uint32_t i = 0; i < 6; i++) {
+		indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+	}
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		texels[texel * 4 + channel] = palette[(indices >> (texel * 3)) & 7];
+	}
+}
+
+static void decodeBc7Block(const uint8_t* block, uint8_t* texels) {
+	// the mode is the position of the first set bit
+	uint32_t modeIndex = 0;
+
+	while (modeIndex < 8 && !(block[0] & (1u << modeIndex))) {
+		modeIndex++;
+	}
+
+	// reserved, decodes to transparent black
+	if (modeIndex == 8) {
+		memset(texels, 0, 64);
+		return;
+	}
+
+	const Bc7Mode& mode = kBC7_MODES[modeIndex];
+	BlockBitReader bits{ block, modeIndex + 1 };
+	uint32_t partition = bits.read(mode.partitionBits);
+	uint32_t rotation = bits.read(mode.rotationBits);
+	uint32_t indexSelection = bits.read(mode.indexSelectionBits);
+
+	// [subset * 2 + end][channel], every red first, then green, blue and alpha
+	uint32_t endpoints[6][4];
+	uint32_t endpointCount = mode.subsets * 2;
+
+	for (uint32_t channel = 0; channel < 4; channel++) {
+		uint32_t channelBits = channel < 3 ? mode.colorBits : mode.alphaBits;
+
+		for (uint32_t endpoint = 0; endpoint < endpointCount; endpoint++) {
+			endpoints[endpoint][channel] = bits.read(channelBits);
+		}
+	}
+
+	uint32_t pBits[6] = {};
+
+	for (uint32_t endpoint = 0; endpoint < endpointCount && mode.endpointPBits; endpoint++) {
+		pBits[endpoint] = bits.read(1);
+	}
+
+	for (uint32_t subset = 0; subset < mode.subsets && mode.sharedPBits; subset++) {
+		pBits[subset * 2] = pBits[subset * 2 + 1] = bits.read(1);
+	}
+
+	// p bits go under every channel, then the top bits are repeated down to 8
+	for (uint32_t endpoint = 0; endpoint < endpointCount; endpoint++) {
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			uint32_t precision = channel < 3 ? mode.colorBits : mode.alphaBits;
+
+			if (precision == 0) {
+				endpoints[endpoint][channel] = 255;
+				continue;
+			}
+
+			uint32_t value = endpoints[endpoint][channel];
+
+			if (mode.endpointPBits || mode.sharedPBits) {
+				value = (value << 1) | pBits[endpoint];
+				precision++;
+			}
+
+			value <<= 8 - precision;
+			endpoints[endpoint][channel] = value | (value >> precision);
+		}
+	}
+
+	uint32_t indices[16];
+	uint32_t secondaryIndices[16] = {};
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		indices[texel] = bits.read(mode.indexBits - (isBc7Anchor(mode.subsets, partition, texel) ? 1 : 0));
+	}
+
+	for (uint32_t texel = 0; texel < 16 && mode.secondaryIndexBits; texel++) {
+		secondaryIndices[texel] = bits.read(mode.secondaryIndexBits - (texel == 0 ? 1 : 0));
+	}
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		uint32_t subset = getBc7Subset(mode.subsets, partition, texel);
+		const uint32_t* end0 = endpoints[subset * 2];
+		const uint32_t* end1 = endpoints[subset * 2 + 1];
+
+		uint32_t colorWeight = getBc7Weight(mode.indexBits, indices[texel]);
+		uint32_t alphaWeight = colorWeight;
+
+		// with two index sets the selection bit says which one the color uses
+		if (mode.secondaryIndexBits) {
+			uint32_t secondaryWeight = getBc7Weight(mode.secondaryIndexBits, secondaryIndices[texel]);
+			(indexSelection ? colorWeight : alphaWeight) = secondaryWeight;
+		}
+
+		uint8_t* out = &texels[texel * 4];
+
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			out[channel] = interpolateBc7(end0[channel], end1[channel], channel < 3 ? colorWeight : alphaWeight);
+		}
+
+		if (rotation > 0) {
+			std::swap(out[3], out[rotation - 1]);
+		}
+	}
+}
+
+static void decodeBlock(VkFormat format, const uint8_t* block, uint8_t* texels) {
+	switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			decodeBc1Block(block, texels, false);
+
+			// without alpha the transparent black entry is plain black
+			if (format == VK_FORMAT_BC1_RGB_UNORM_BLOCK || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK) {
+				for (uint32_t texel = 0; texel < 16; texel++) {
+					texels[texel * 4 + 3] = 255;
+				}
+			}
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			decodeBc1Block(block + 8, texels, true);
+			decodeBc4Block(block, texels, 3);
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			// sampling bc5 gives 0 blue and 1 alpha, the decoded texels match that
+			for (uint32_t texel = 0; texel < 16; texel++) {
+				texels[texel * 4 + 2] = 0;
+				texels[texel * 4 + 3] = 255;
+			}
+
+			decodeBc4Block(block, texels, 0);
+			decodeBc4Block(block + 8, texels, 1);
+			break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			decodeBc7Block(block, texels);
+			break;
+		default:
+			throw std::runtime_error("Unsupported Texture Format");
+	}
+}
+
+TextureMip decompressMip(VkFormat format, const TextureMip& mip) {
+	uint32_t blockBytes = getBlockBytes(format);
+	uint32_t blocksX = (mip.width + 3) / 4;
+	uint32_t blocksY = (mip.height + 3) / 4;
+
+	if (mip.pixels.size() < getMipBytes(format, mip.width, mip.height)) {
+		throw std::runtime_error("Texture Level Is Missing Data");
+	}
+
+	TextureMip decoded;
+	decoded.width = mip.width;
+	decoded.height = mip.height;
+	decoded.pixels.resize(static_cast<size_t>(mip.width) * mip.height * 4);
+
+	getJobSystem().parallelFor(blocksY, kBLOCK_ROWS_PER_JOB, [&](uint32_t firstRow, uint32_t lastRow) {
+		uint8_t texels[64];
+
+		for (uint32_t blockY = firstRow; blockY < lastRow; blockY++) {
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+				decodeBlock(format, &mip.pixels[(static_cast<size_t>(blockY) * blocksX + blockX) * blockBytes], texels);
+
+				// the edge blocks of sizes that aren't a multiple of 4 hang over
+				for (uint32_t y = 0; y < 4 && blockY * 4 + y < mip.height; y++) {
+					uint32_t width = std::min(4u, mip.width - blockX * 4);
+					memcpy(&decoded.pixels[((static_cast<size_t>(blockY) * 4 + y) * mip.width + blockX * 4) * 4], &texels[y * 16], width * 4);
+				}
+			}
+		}
+	});
+
+	return decoded;
+}
+
+/***** ENCODING *****/
+
+// mean and the direction the texels spread along most, found by power iteration on the covariance
+static void getPrincipalAxis(const float points[16][4], uint32_t channels, float mean[4], float axis[4]) {
+	float covariance[4][4] = {};
+
+	for (uint32_t c = 0; c < 4; c++) {
+		mean[c] = 0.0f;
+		axis[c] = c < channels ? 1.0f : 0.0f;
+
+		for (uint32_t texel = 0; texel < 16 && c < channels; texel++) {
+			mean[c] += points[texel][c] / 16.0f;
+		}
+	}
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		for (uint32_t i = 0; i < channels; i++) {
+			for (uint32_t j = 0; j < channels; j++) {
+				covariance[i][j] += (points[texel][i] - mean[i]) * (points[texel][j] - mean[j]);
+			}
+		}
+	}
+
+	for (uint32_t iteration = 0; iteration < 8; iteration++) {
+		float next[4] = {};
+		float length = 0.0f;
+
+		for (uint32_t i = 0; i < channels; i++) {
+			for (uint32_t j = 0; j < channels; j++) {
+				next[i] += covariance[i][j] * axis[j];
+			}
+
+			length += next[i] * next[i];
+		}
+
+		// a flat block has no axis, both endpoints land on the mean
+		if (length < 1e-8f) {
+			std::fill(axis, axis + 4, 0.0f);
+			return;
+		}
+
+		length = std::sqrt(length);
+
+		for (uint32_t i = 0; i < channels; i++) {
+			axis[i] = next[i] / length;
+		}
+	}
+}
+
+// the two points furthest apart along the axis
+static void getAxisEndpoints(const float points[16][4], uint32_t channels, float end0[4], float end1[4]) {
+	float mean[4];
+	float axis[4];
+	getPrincipalAxis(points, channels, mean, axis);
+
+	float minProjection = 0.0f;
+	float maxProjection = 0.0f;
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		float projection = 0.0f;
+
+		for (uint32_t c = 0; c < channels; c++) {
+			projection += (points[texel][c] - mean[c]) * axis[c];
+		}
+
+		minProjection = std::min(minProjection, projection);
+		maxProjection = std::max(maxProjection, projection);
+	}
+
+	for (uint32_t c = 0; c < 4; c++) {
+		end0[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+		end1[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+	}
+}
+
+static uint16_t quantize565(const float* color) {
+	uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+	uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+	uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+// picks the closest palette entry for every texel and returns the squared error, swaps the endpoints into 4 color order
+static uint32_t fitBc1Indices(const uint8_t* texels, uint16_t& color0, uint16_t& color1, uint32_t& indices) {
+	if (color0 < color1) {
+		std::swap(color0, color1);
+	}
+
+	uint8_t palette[4][4];
+	buildBc1Palette(color0, color1, true, palette);
+
+	// equal endpoints decode in 3 color mode, index 0 is the only one that means the same thing there
+	uint32_t paletteSize = color0 == color1 ? 1 : 4;
+	uint32_t error = 0;
+	indices = 0;
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		uint32_t bestError = UINT32_MAX;
+		uint32_t bestIndex = 0;
+
+		for (uint32_t i = 0; i < paletteSize; i++) {
+			uint32_t distance = 0;
+
+			for (uint32_t c = 0; c < 3; c++) {
+				int32_t difference = static_cast<int32_t>(texels[texel * 4 + c]) - palette[i][c];
+				distance += difference * difference;
+			}
+
+			if (distance < bestError) {
+				bestError = distance;
+				bestIndex = i;
+			}
+		}
+
+		indices |= bestIndex << (texel * 2);
+		error += bestError;
+	}
+
+	return error;
+}
+
+static void encodeBc1Block(const uint8_t* texels, uint8_t* block) {
+	float points[16][4] = {};
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		for (uint32_t c = 0; c < 3; c++) {
+			points[texel][c] = texels[texel * 4 + c];
+		}
+	}
+
+	float end0[4];
+	float end1[4];
+	getAxisEndpoints(points, 3, end0, end1);
+
+	uint16_t color0 = quantize565(end0);
+	uint16_t color1 = quantize565(end1);
+	uint32_t indices;
+	uint32_t error = fitBc1Indices(texels, color0, color1, indices);
+
+	// least squares endpoints for the indices just picked, kept when they do better
+	const float kWEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[3] = {}, bx[3] = {};
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		float a = kWEIGHTS[(indices >> (texel * 2)) & 3];
+		float b = 1.0f - a;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+
+		for (uint32_t c = 0; c < 3; c++) {
+			ax[c] += a * points[texel][c];
+			bx[c] += b * points[texel][c];
+		}
+	}
+
+	float determinant = aa * bb - ab * ab;
+
+	if (std::abs(determinant) > 1e-6f) {
+		for (uint32_t c = 0; c < 3; c++) {
+			end0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+			end1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+		}
+
+		uint16_t refined0 = quantize565(end0);
+		uint16_t refined1 = quantize565(end1);
+		uint32_t refinedIndices;
+		uint32_t refinedError = fitBc1Indices(texels, refined0, refined1, refinedIndices);
+
+		if (refinedError < error) {
+			color0 = refined0;
+			color1 = refined1;
+			indices = refinedIndices;
+		}
+	}
+
+	block[0] = static_cast<uint8_t>(color0);
+	block[1] = static_cast<uint8_t>(color0 >> 8);
+	block[2] = static_cast<uint8_t>(color1);
+	block[3] = static_cast<uint8_t>(color1 >> 8);
+	memcpy(&block[4], &indices, 4);
+}
+
+static void encodeBc4Block(const uint8_t* texels, uint32_t channel, uint8_t* block) {
+	uint8_t minValue = 255;
+	uint8_t maxValue = 0;
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		minValue = std::min(minValue, texels[texel * 4 + channel]);
+		maxValue = std::max(maxValue, texels[texel * 4 + channel]);
+	}
+
+	// max first picks the 8 value mode, a flat block only ever uses index 0
+	uint8_t palette[8];
+	buildBc4Palette(maxValue, minValue, palette);
+	uint32_t paletteSize = maxValue > minValue ? 8 : 1;
+	uint64_t indices = 0;
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		uint32_t bestError = UINT32_MAX;
+		uint32_t bestIndex = 0;
+
+		for (uint32_t i = 0; i < paletteSize; i++) {
+			uint32_t distance = std::abs(static_cast<int32_t>(texels[texel * 4 + channel]) - palette[i]);
+
+			if (distance < bestError) {
+				bestError = distance;
+				bestIndex = i;
+			}
+		}
+
+		indices |= static_cast<uint64_t>(bestIndex) << (texel * 3);
+	}
+
+	block[0] = maxValue;
+	block[1] = minValue;
+
+	for (uint32_t i = 0; i < 6; i++) {
+		block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+	}
+}
+
+// mode 6 only: one subset, 7 bit rgba endpoints with a p bit each, 4 bit indices
+static void encodeBc7Block(const uint8_t* texels, uint8_t* block) {
+	float points[16][4];
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		for (uint32_t c = 0; c < 4; c++) {
+			points[texel][c] = texels[texel * 4 + c];
+		}
+	}
+
+	float ends[2][4];
+	getAxisEndpoints(points, 4, ends[0], ends[1]);
+
+	// every endpoint takes whichever p bit lands it closer
+	uint32_t quantized[2][4];
+	uint32_t pBits[2];
+	uint32_t endpoints[2][4];
+
+	for (uint32_t end = 0; end < 2; end++) {
+		float bestError = std::numeric_limits<float>::max();
+
+		for (uint32_t pBit = 0; pBit < 2; pBit++) {
+			uint32_t candidate[4];
+			float error = 0.0f;
+
+			for (uint32_t c = 0; c < 4; c++) {
+				candidate[c] = static_cast<uint32_t>(std::clamp(std::lround((ends[end][c] - pBit) / 2.0f), 0l, 127l));
+				float difference = static_cast<float>((candidate[c] << 1) | pBit) - ends[end][c];
+				error += difference * difference;
+			}
+
+			if (error < bestError) {
+				bestError = error;
+				pBits[end] = pBit;
+				std::copy(candidate, candidate + 4, quantized[end]);
+			}
+		}
+
+		for (uint32_t c = 0; c < 4; c++) {
+			endpoints[end][c] = (quantized[end][c] << 1) | pBits[end];
+		}
+	}
+
+	uint32_t indices[16];
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		uint32_t bestError = UINT32_MAX;
+
+		for (uint32_t i = 0; i < 16; i++) {
+			uint32_t distance = 0;
+
+			for (uint32_t c = 0; c < 4; c++) {
+				int32_t difference = static_cast<int32_t>(texels[texel * 4 + c]) - interpolateBc7(endpoints[0][c], endpoints[1][c], kBC7_WEIGHTS_4[i]);
+				distance += difference * difference;
+			}
+
+			if (distance < bestError) {
+				bestError = distance;
+				indices[texel] = i;
+			}
+		}
+	}
+
+	// texel 0 only has 3 bits, swapping the endpoints mirrors the weights so its top bit becomes 0
+	if (indices[0] & 8) {
+		std::swap(quantized[0], quantized[1]);
+		std::swap(pBits[0], pBits[1]);
+
+		for (uint32_t texel = 0; texel < 16; texel++) {
+			indices[texel] = 15 - indices[texel];
+		}
+	}
+
+	memset(block, 0, 16);
+	BlockBitWriter bits{ block, 0 };
+	bits.write(1u << 6, 7);
+
+	for (uint32_t c = 0; c < 4; c++) {
+		bits.write(quantized[0][c], 7);
+		bits.write(quantized[1][c], 7);
+	}
+
+	bits.write(pBits[0], 1);
+	bits.write(pBits[1], 1);
+
+	for (uint32_t texel = 0; texel < 16; texel++) {
+		bits.write(indices[texel], texel == 0 ? 3 : 4);
+	}
+}
+
+static void encodeBlock(VkFormat format, const uint8_t* texels, uint8_t* block) {
+	switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			encodeBc1Block(texels, block);
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			encodeBc4Block(texels, 3, block);
+			encodeBc1Block(texels, block + 8);
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			encodeBc4Block(texels, 0, block);
+			encodeBc4Block(texels, 1, block + 8);
+			break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			encodeBc7Block(texels, block);
+			break;
+		default:
+			throw std::runtime_error("Unsupported Texture Format");
+	}
+}
+
+// mip holds rgba8 texels
+TextureMip compressMip(VkFormat format, const TextureMip& mip) {
+	uint32_t blockBytes = getBlockBytes(format);
+	uint32_t blocksX = (mip.width + 3) / 4;
+	uint32_t blocksY = (mip.height + 3) / 4;
+
+	TextureMip encoded;
+	encoded.width = mip.width;
+	encoded.height = mip.height;
+	encoded.pixels.resize(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+	getJobSystem().parallelFor(blocksY, kBLOCK_ROWS_PER_JOB, [&](uint32_t firstRow, uint32_t lastRow) {
+		uint8_t texels[64];
+
+		for (uint32_t blockY = firstRow; blockY < lastRow; blockY++) {
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+				// texels past the edge repeat the last row and column, they're never sampled
+				for (uint32_t y = 0; y < 4; y++) {
+					uint32_t sourceY = std::min(blockY * 4 + y, mip.height - 1);
+
+					for (uint32_t x = 0; x < 4; x++) {
+						uint32_t sourceX = std::min(blockX * 4 + x, mip.width - 1);
+						memcpy(&texels[(y * 4 + x) * 4], &mip.pixels[(static_cast<size_t>(sourceY) * mip.width + sourceX) * 4], 4);
+					}
+				}
+
+				encodeBlock(format, texels, &encoded.pixels[(static_cast<size_t>(blockY) * blocksX + blockX) * blockBytes]);
+			}
+		}
+	});
+
+	return encoded;
+}
\ No newline at end of file
@@ -1,139 +1,519 @@
 #include "headers/VulkanApplicationBufferManager.h"
 
-VulkanApplicationBufferManager::VulkanApplicationBufferManager(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool) {
-	createVertexBuffer(logicalDevice, physicalDevice, graphicsQueue, commandPool);
-	createIndexBuffer(logicalDevice, physicalDevice, graphicsQueue, commandPool);
-	createUniformBuffers(logicalDevice, physicalDevice);
+VulkanApplicationBufferManager::VulkanApplicationBufferManager(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext) {
+	loadMesh();
+	positionDequantization = getPositionDequantization(mesh.vertexFormat, mesh.getVertexQuantization());
+	boundingSphere = computeBoundingSphere();
+	createVertexBuffer(logicalDevice, allocator, uploadContext);
+	createIndexBuffer(logicalDevice, allocator, uploadContext);
+	closeMeshCache(meshCache); // both blobs were copied into staging memory already
+	createUniformBuffers(logicalDevice, physicalDevice, allocator);
+	createInstanceBuffers(logicalDevice, allocator);
+	createSceneGraph();
+	createCullingBvh();
 }
 
 VulkanApplicationBufferManager::~VulkanApplicationBufferManager() {}
 
-void VulkanApplicationBufferManager::cleanup(VkDevice logicalDevice) {
-	for (size_t i = 0; i < kMAX_FRAMES_IN_FLIGHT; i++) {
-		vkDestroyBuffer(logicalDevice, uniformBuffers[i], nullptr);
-		vkFreeMemory(logicalDevice, uniformBuffersMemories[i], nullptr);
+void VulkanApplicationBufferManager::cleanup(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator) {
+	uniformArena->cleanup();
+
+	for (size_t i = 0; i < instanceBuffers.size(); i++) {
+		destroyBuffer(logicalDevice, allocator, instanceBuffers[i], instanceBufferAllocations[i]);
 	}
 
-	vkDestroyBuffer(logicalDevice, indexBuffer, nullptr);
-	vkFreeMemory(logicalDevice, indexBufferMemory, nullptr);
-	vkDestroyBuffer(logicalDevice, vertexBuffer, nullptr);
-	vkFreeMemory(logicalDevice, vertexBufferMemory, nullptr);
+	destroyBuffer(logicalDevice, allocator, indexBuffer, indexBufferAllocation);
+	destroyBuffer(logicalDevice, allocator, vertexBuffer, vertexBufferAllocation);
 }
 
-void VulkanApplicationBufferManager::createUniformBuffers(VkDevice logicalDevice, VkPhysicalDevice physicalDevice) {
-	VkDeviceSize bufferSize = sizeof(UniformBufferObject);
+void VulkanApplicationBufferManager::createUniformBuffers(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator) {
+	uniformArena = std::make_unique<VulkanApplicationUniformArena>(logicalDevice, physicalDevice, allocator, kUNIFORM_ARENA_SIZE);
+	objectUniformOffsets.resize(kOBJECT_COUNT);
+	objectModels.resize(kOBJECT_COUNT);
+	objectLods.resize(kOBJECT_COUNT);
+	objectMaterials.resize(kOBJECT_COUNT);
+}
 
-	uniformBuffers.resize(kMAX_FRAMES_IN_FLIGHT);
-	uniformBuffersMemories.resize(kMAX_FRAMES_IN_FLIGHT);
-	uniformBuffersMapped.resize(kMAX_FRAMES_IN_FLIGHT);
+void VulkanApplicationBufferManager::createInstanceBuffers(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator) {
+	instanceBuffers.resize(kMAX_FRAMES_IN_FLIGHT);
+	instanceBufferAllocations.resize(kMAX_FRAMES_IN_FLIGHT);
 
+	// written by the cpu every frame and read once per instance, not worth a copy to device local memory
+	// the gpu driven path also reads it as a storage buffer while culling
 	for (size_t i = 0; i < kMAX_FRAMES_IN_FLIGHT; i++) {
-		createBuffer(logicalDevice, physicalDevice, bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemories[i]);
-
-		vkMapMemory(logicalDevice, uniformBuffersMemories[i], 0, bufferSize, 0, &uniformBuffersMapped[i]);
+		createBuffer(logicalDevice, allocator, sizeof(InstanceData) * kOBJECT_COUNT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, instanceBuffers[i], instanceBufferAllocations[i]);
 	}
-}
 
-void VulkanApplicationBufferManager::createVertexBuffer(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool) {
-	VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+	instanceBatches.reserve(kMAX_MESH_LODS);
+	instanceBuffersInObjectOrder.assign(kMAX_FRAMES_IN_FLIGHT, false);
+}
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
+// root, one node per grid row, the objects under their row
+void VulkanApplicationBufferManager::createSceneGraph() {
+	sceneGraph = std::make_unique<VulkanApplicationSceneGraph>(&getJobSystem());
+	objectNodes.resize(kOBJECT_COUNT);
 
-	createBuffer(logicalDevice, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+	uint32_t root = sceneGraph->createNode(kSCENE_GRAPH_NONE, glm::mat4(1.0f));
+	std::vector<uint32_t> rows;
 
-	void* data;
-	vkMapMemory(logicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, vertices.data(), (size_t)bufferSize);
-	vkUnmapMemory(logicalDevice, stagingBufferMemory);
+	for (uint32_t i = 0; i < kOBJECT_COUNT; i++) {
+		glm::vec3 position = getObjectPosition(i);
+		uint32_t row = i / getGridSize();
 
-	createBuffer(logicalDevice, physicalDevice, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		vertexBuffer, vertexBufferMemory);
+		if (row == rows.size()) {
+			rows.push_back(sceneGraph->createNode(root, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, position.y, 0.0f))));
+		}
 
-	copyBuffer(stagingBuffer, vertexBuffer, bufferSize, logicalDevice, graphicsQueue, commandPool);
+		objectNodes[i] = sceneGraph->createNode(rows[row], getObjectLocal(i, 0.0f), i);
+	}
 
-	vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-	vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
+	sceneGraphOutputs.reserve(2);
 }
 
-void VulkanApplicationBufferManager::createIndexBuffer(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool) {
-	VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+// objects only spin about their own origin, so a box around the sphere that reaches the farthest vertex never changes
+void VulkanApplicationBufferManager::createCullingBvh() {
+	glm::vec3 center = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+	float reach = glm::length(center) + glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f;
+	std::vector<CullingBox> boxes(kOBJECT_COUNT);
+
+	for (uint32_t i = 0; i < kOBJECT_COUNT; i++) {
+		boxes[i].center = getObjectPosition(i);
+		boxes[i].extent = glm::vec3(reach);
+	}
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
+	cullingBvh = buildCullingBvh(boxes);
+	visibleObjects.reserve(kOBJECT_COUNT);
+}
 
-	createBuffer(logicalDevice, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+void VulkanApplicationBufferManager::loadMesh() {
+	std::ifstream file(kMODEL_PATH);
+
+	if (file.good()) {
+		file.close();
+		auto start = std::chrono::high_resolution_clock::now();
+		std::string cachePath = getMeshCachePath(kMODEL_PATH);
+		uint64_t sourceHash = hashSourceFile(kMODEL_PATH);
+
+		if (openMeshCache(cachePath, sourceHash, meshCache)) {
+			mesh.indexType = static_cast<VkIndexType>(meshCache.header->indexType);
+			mesh.vertexFormat = static_cast<VertexFormat>(meshCache.header->vertexFormat);
+			memcpy(&mesh.boundsMin, meshCache.header->boundsMin, sizeof(meshCache.header->boundsMin));
+			memcpy(&mesh.boundsMax, meshCache.header->boundsMax, sizeof(meshCache.header->boundsMax));
+			indexCount = static_cast<uint32_t>(meshCache.header->indexCount);
+			mesh.lods.assign(meshCache.lods, meshCache.lods + meshCache.header->lodCount);
+
+			if (debug) {
+				cout << "Loaded " << cachePath << ": " << mesh.lods[0].indexCount / 3 << " triangles, " << mesh.lods.size() << " lods in "
+					<< std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() << " ms" << endl;
+			}
+
+			return;
+		}
+
+		MeshLoadStats stats;
+		mesh = loadObjMesh(kMODEL_PATH, &stats);
+
+		// lods and optimization only happen here, the cache keeps the result
+		MeshLodStats lodStats;
+		generateMeshLods(mesh, &lodStats);
+		MeshOptimizeStats optimizeStats;
+		optimizeMesh(mesh, &optimizeStats);
+
+		indexCount = static_cast<uint32_t>(mesh.indices.size());
+		writeMeshCache(cachePath, mesh, sourceHash);
+
+		if (debug) {
+			printMeshLoadStats(kMODEL_PATH, stats);
+			printMeshLodStats(lodStats);
+			printMeshOptimizeStats(optimizeStats);
+		}
+
+		return;
+	}
 
-	void* data;
-	vkMapMemory(logicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, indices.data(), (size_t)bufferSize);
-	vkUnmapMemory(logicalDevice, stagingBufferMemory);
+	// no model on disk, fall back to the two textured quads
+	mesh.vertices = {
+		{{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
+		{{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
+		{{0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+		{{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}},
+
+		{{-0.5f, -0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
+		{{0.5f, -0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
+		{{0.5f, 0.5f, -0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
+		{{-0.5f, 0.5f, -0.5f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}}
+	};
+
+	mesh.indices = {
+		0, 1, 2, 2, 3, 0,
+		4, 5, 6, 6, 7, 4
+	};
+
+	finalizeMesh(mesh);
+	indexCount = static_cast<uint32_t>(mesh.indices.size());
+}
 
-	createBuffer(logicalDevice, physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
+void VulkanApplicationBufferManager::createVertexBuffer(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext) {
+	StagingRegion staging;
+	VkDeviceSize bufferSize;
+
+	if (meshCache.header != nullptr) {
+		bufferSize = meshCache.vertexBytes;
+		staging = uploadContext.stage(meshCache.vertices, bufferSize, 16);
+	} else {
+		// encoded straight into the staging memory
+		bufferSize = getVertexStride(mesh.vertexFormat) * mesh.vertices.size();
+		staging = uploadContext.stage(nullptr, bufferSize, 16);
+		encodeVertices(mesh.vertices, mesh.vertexFormat, mesh.getVertexQuantization(), staging.mapped);
+	}
 
-	copyBuffer(stagingBuffer, indexBuffer, bufferSize, logicalDevice, graphicsQueue, commandPool);
+	createBuffer(logicalDevice, allocator, bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		vertexBuffer, vertexBufferAllocation);
 
-	vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-	vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
+	uploadContext.copyBuffer(staging, vertexBuffer, 0, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
 }
 
-void VulkanApplicationBufferManager::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDevice logicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool) {
-	VkCommandBuffer commandBuffer = beginSingleTimeCommands(logicalDevice, commandPool);
+void VulkanApplicationBufferManager::createIndexBuffer(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext) {
+	VkDeviceSize bufferSize = mesh.getIndexSize() * indexCount;
+	StagingRegion staging;
+
+	if (meshCache.header != nullptr) {
+		// already stored in the final index width
+		staging = uploadContext.stage(meshCache.indices, bufferSize, mesh.getIndexSize());
+	} else if (mesh.indexType == VK_INDEX_TYPE_UINT16) {
+		// narrow straight into the staging memory, no temporary copy
+		staging = uploadContext.stage(nullptr, bufferSize, sizeof(uint16_t));
+		uint16_t* dst = static_cast<uint16_t*>(staging.mapped);
+
+		for (size_t i = 0; i < mesh.indices.size(); i++) {
+			dst[i] = static_cast<uint16_t>(mesh.indices[i]);
+		}
+	} else {
+		staging = uploadContext.stage(mesh.indices.data(), bufferSize, sizeof(uint32_t));
+	}
 
-	VkBufferCopy copyRegion{};
-	// srcOffset and dstOffset are optional
-	copyRegion.size = size;
-	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+	createBuffer(logicalDevice, allocator, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferAllocation);
 
-	endSingleTimeCommands(commandBuffer, commandPool, logicalDevice, graphicsQueue);
+	uploadContext.copyBuffer(staging, indexBuffer, 0, VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
 }
 
-void VulkanApplicationBufferManager::updateUniformBuffer(uint32_t currentImage, VkExtent2D swapchainExtent) {
+void VulkanApplicationBufferManager::updateUniformBuffer(uint32_t currentImage, VkExtent2D swapchainExtent, DrawPath drawPath) {
 	static auto startTime = std::chrono::high_resolution_clock::now();
 	auto currentTime = std::chrono::high_resolution_clock::now();
 	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
+	// pull the camera back far enough to see the whole grid of objects
+	float gridExtent = std::max(2.0f, std::sqrt(static_cast<float>(kOBJECT_COUNT)) * 0.75f);
+
+	glm::vec3 eye(gridExtent, gridExtent, gridExtent);
+	float fieldOfView = glm::radians(45.0f);
+
 	UniformBufferObject ubo{};
-	ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-	ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-	ubo.projection = glm::perspective(glm::radians(45.0f), (swapchainExtent.width / (float)swapchainExtent.height), 0.1f, 10.0f);
+	ubo.view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	ubo.projection = glm::perspective(fieldOfView, (swapchainExtent.width / (float)swapchainExtent.height), 0.1f, gridExtent * 5.0f);
 
 	ubo.projection[1][1] *= -1; // flip y since vulkan is upside down
-	memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+
+	uniformArena->beginFrame(currentImage);
+
+	// pixels covered by one unit at a distance of one unit
+	pixelsPerUnit = swapchainExtent.height / (2.0f * std::tan(fieldOfView * 0.5f));
+	this->eye = eye;
+	viewProjection = ubo.projection * ubo.view;
+	lodStats = LodFrameStats{};
+
+	// the gpu driven path culls and picks lods itself and needs every object, in order, at lod 0
+	bool gpuDriven = drawPath == DrawPath::kGpuDriven;
+	bool selectLods = lodEnabled && !gpuDriven;
+	auto cullStart = std::chrono::high_resolution_clock::now();
+
+	if (cullingEnabled && !gpuDriven) {
+		cullFrustumBvh(cullingBvh, extractFrustum(viewProjection), visibleObjects, &cullingStats);
+	} else {
+		visibleObjects.resize(kOBJECT_COUNT);
+
+		for (uint32_t i = 0; i < kOBJECT_COUNT; i++) {
+			visibleObjects[i] = i;
+		}
+
+		cullingStats = CullingStats{ kOBJECT_COUNT, 0 };
+	}
+
+	cullingSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - cullStart).count();
+
+	for (uint32_t i = 0; i < kOBJECT_COUNT; i++) {
+		sceneGraph->setLocalTransform(objectNodes[i], getObjectLocal(i, time));
+	}
+
+	// the gpu driven path gets its models written straight into this frame's instance buffer, the others read objectModels
+	auto sceneGraphStart = std::chrono::high_resolution_clock::now();
+	sceneGraphOutputs.clear();
+
+	if (gpuDriven) {
+		if (!instanceBuffersInObjectOrder[currentImage]) {
+			fillInstanceTints(currentImage);
+		}
+
+		sceneGraphOutputs.push_back({ instanceBufferAllocations[currentImage].mapped, sizeof(InstanceData), currentImage });
+	}
+
+	// debug validates the gpu culling against objectModels
+	if (!gpuDriven || debug) {
+		sceneGraphOutputs.push_back({ objectModels.data(), sizeof(glm::mat4), kOBJECT_MODELS_OUTPUT });
+	}
+
+	sceneGraph->propagate(sceneGraphOutputs);
+	sceneGraphSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - sceneGraphStart).count();
+
+	for (uint32_t i : visibleObjects) {
+		objectLods[i] = selectLods ? selectLod(objectModels[i], eye, pixelsPerUnit) : 0;
+
+		lodStats.trianglesSubmitted += mesh.lods[objectLods[i]].indexCount / 3;
+		lodStats.trianglesWithoutLod += mesh.lods[0].indexCount / 3;
+		lodStats.objectsPerLod[objectLods[i]]++;
+	}
+
+	if (drawPath != DrawPath::kUniformBuffer) {
+		// models go out as push constants or instance data, only the camera needs uniform memory
+		CameraUniformObject camera{};
+		camera.view = ubo.view;
+		camera.projection = ubo.projection;
+		cameraUniformOffset = uniformArena->push(camera);
+
+		if (drawPath == DrawPath::kInstanced) {
+			updateInstanceBuffer(currentImage);
+		}
+
+		return;
+	}
+
+	for (uint32_t i : visibleObjects) {
+		ubo.model = objectModels[i];
+		ubo.materialIndex = objectMaterials[i];
+		objectUniformOffsets[i] = uniformArena->push(ubo);
+	}
+}
+
+// tints in object order, the scene graph has to write every model again after anything else used the buffer
+void VulkanApplicationBufferManager::fillInstanceTints(uint32_t currentImage) {
+	InstanceData* instances = static_cast<InstanceData*>(instanceBufferAllocations[currentImage].mapped);
+
+	for (uint32_t i = 0; i < kOBJECT_COUNT; i++) {
+		instances[i].tint = getObjectTint(i);
+	}
+
+	sceneGraph->invalidateOutput(currentImage);
+	instanceBuffersInObjectOrder[currentImage] = true;
+}
+
+// counting sort by lod straight into the mapped buffer, so every lod in use is one contiguous run of instances
+void VulkanApplicationBufferManager::updateInstanceBuffer(uint32_t currentImage) {
+	std::array<uint32_t, kMAX_MESH_LODS> lodStart{};
+	uint32_t first = 0;
+
+	for (uint32_t lod = 0; lod < mesh.lods.size(); lod++) {
+		lodStart[lod] = first;
+		first += lodStats.objectsPerLod[lod];
+	}
+
+	instanceBatches.clear();
+	instanceBuffersInObjectOrder[currentImage] = false;
+
+	for (uint32_t lod = 0; lod < mesh.lods.size(); lod++) {
+		if (lodStats.objectsPerLod[lod] > 0) {
+			instanceBatches.push_back({ lod, lodStart[lod], lodStats.objectsPerLod[lod] });
+		}
+	}
+
+	InstanceData* instances = static_cast<InstanceData*>(instanceBufferAllocations[currentImage].mapped);
+
+	for (uint32_t i : visibleObjects) {
+		InstanceData& instance = instances[lodStart[objectLods[i]]++];
+		instance.model = objectModels[i];
+		instance.tint = getObjectTint(i);
+	}
+}
+
+// coarsest lod whose error projects to at most kLOD_PIXEL_ERROR pixels, measured from the nearest point of the bounding sphere
+uint32_t VulkanApplicationBufferManager::selectLod(const glm::mat4& model, const glm::vec3& eye, float pixelsPerUnit) {
+	// object models only rotate and translate past the dequantization, so the bounds keep their size
+	glm::vec4 center = model * glm::vec4(glm::vec3(boundingSphere), 1.0f);
+	float distance = std::max(glm::distance(glm::vec3(center), eye) - boundingSphere.w, 0.1f);
+
+	for (uint32_t lod = static_cast<uint32_t>(mesh.lods.size()) - 1; lod > 0; lod--) {
+		if (mesh.lods[lod].error * pixelsPerUnit / distance <= kLOD_PIXEL_ERROR) {
+			return lod;
+		}
+	}
+
+	return 0;
+}
+
+// center in the space the vertex buffer is encoded in, so it goes through the same model matrix as the vertices
+glm::vec4 VulkanApplicationBufferManager::computeBoundingSphere() {
+	glm::vec3 center = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+	glm::vec4 encodedCenter = glm::inverse(positionDequantization) * glm::vec4(center, 1.0f);
+	return glm::vec4(glm::vec3(encodedCenter), glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f);
+}
+
+glm::vec4 VulkanApplicationBufferManager::getBoundingSphere() {
+	return this->boundingSphere;
+}
+
+// objects sit on a square grid in the xy plane centered on the origin
+uint32_t VulkanApplicationBufferManager::getGridSize() {
+	return static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(kOBJECT_COUNT))));
+}
+
+glm::vec3 VulkanApplicationBufferManager::getObjectPosition(uint32_t objectIndex) {
+	uint32_t gridSize = getGridSize();
+	float spacing = 1.5f;
+	float halfGrid = (gridSize - 1) * spacing * 0.5f;
+
+	return glm::vec3((objectIndex % gridSize) * spacing - halfGrid, (objectIndex / gridSize) * spacing - halfGrid, 0.0f);
+}
+
+// relative to the object's row, each spinning at its own speed, dequantization last so the model takes the vertices as they're stored
+glm::mat4 VulkanApplicationBufferManager::getObjectLocal(uint32_t objectIndex, float time) {
+	float speed = 1.0f + (objectIndex % 7) * 0.25f;
+
+	glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::vec3(getObjectPosition(objectIndex).x, 0.0f, 0.0f));
+	local = glm::rotate(local, time * speed * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	return local * positionDequantization;
+}
+
+// a fixed pale tint per object so instances can be told apart, w carries the material to the instanced shader
+glm::vec4 VulkanApplicationBufferManager::getObjectTint(uint32_t objectIndex) {
+	uint32_t hash = objectIndex * 2654435761u;
+	return glm::vec4(0.6f + 0.4f * ((hash >> 8) & 0xFF) / 255.0f, 0.6f + 0.4f * ((hash >> 16) & 0xFF) / 255.0f,
+		0.6f + 0.4f * ((hash >> 24) & 0xFF) / 255.0f, static_cast<float>(objectMaterials[objectIndex]));
+}
+
+// index into the bindless texture table, floats hold it exactly far past any table size
+void VulkanApplicationBufferManager::setObjectMaterial(uint32_t objectIndex, uint32_t materialIndex) {
+	objectMaterials[objectIndex] = materialIndex;
+	// the gpu driven path only writes tints when its buffer isn't in object order already
+	instanceBuffersInObjectOrder.assign(kMAX_FRAMES_IN_FLIGHT, false);
+}
+
+std::vector<uint32_t>& VulkanApplicationBufferManager::getObjectMaterials() {
+	return this->objectMaterials;
 }
 
 VkBuffer VulkanApplicationBufferManager::getVertexBuffer() {
 	return this->vertexBuffer;
 }
 
-VkDeviceMemory VulkanApplicationBufferManager::getVertexBufferMemory() {
-	return this->vertexBufferMemory;
+MemoryAllocation VulkanApplicationBufferManager::getVertexBufferAllocation() {
+	return this->vertexBufferAllocation;
 }
 
 VkBuffer VulkanApplicationBufferManager::getIndexBuffer() {
 	return this->indexBuffer;
 }
 
-VkDeviceMemory VulkanApplicationBufferManager::getIndexBufferMemory() {
-	return this->indexBufferMemory;
+MemoryAllocation VulkanApplicationBufferManager::getIndexBufferAllocation() {
+	return this->indexBufferAllocation;
+}
+
+VulkanApplicationUniformArena& VulkanApplicationBufferManager::getUniformArena() {
+	return *this->uniformArena;
+}
+
+std::vector<uint32_t>& VulkanApplicationBufferManager::getObjectUniformOffsets() {
+	return this->objectUniformOffsets;
+}
+
+uint32_t VulkanApplicationBufferManager::getCameraUniformOffset() {
+	return this->cameraUniformOffset;
+}
+
+std::vector<glm::mat4>& VulkanApplicationBufferManager::getObjectModels() {
+	return this->objectModels;
+}
+
+std::vector<uint32_t>& VulkanApplicationBufferManager::getVisibleObjects() {
+	return this->visibleObjects;
+}
+
+CullingStats VulkanApplicationBufferManager::getCullingStats() {
+	return this->cullingStats;
+}
+
+double VulkanApplicationBufferManager::getCullingSeconds() {
+	return this->cullingSeconds;
+}
+
+bool VulkanApplicationBufferManager::getCullingEnabled() {
+	return this->cullingEnabled;
+}
+
+void VulkanApplicationBufferManager::setCullingEnabled(bool enabled) {
+	this->cullingEnabled = enabled;
+}
+
+VkBuffer VulkanApplicationBufferManager::getInstanceBuffer(uint32_t frameIndex) {
+	return this->instanceBuffers[frameIndex];
+}
+
+std::vector<VkBuffer>& VulkanApplicationBufferManager::getInstanceBuffers() {
+	return this->instanceBuffers;
+}
+
+SceneGraphStats VulkanApplicationBufferManager::getSceneGraphStats() {
+	return this->sceneGraph->getStats();
+}
+
+double VulkanApplicationBufferManager::getSceneGraphSeconds() {
+	return this->sceneGraphSeconds;
+}
+
+std::vector<InstanceBatch>& VulkanApplicationBufferManager::getInstanceBatches() {
+	return this->instanceBatches;
+}
+
+std::vector<MeshLod>& VulkanApplicationBufferManager::getMeshLods() {
+	return this->mesh.lods;
+}
+
+std::vector<uint32_t>& VulkanApplicationBufferManager::getObjectLods() {
+	return this->objectLods;
+}
+
+LodFrameStats VulkanApplicationBufferManager::getLodStats() {
+	return this->lodStats;
+}
+
+bool VulkanApplicationBufferManager::getLodEnabled() {
+	return this->lodEnabled;
+}
+
+void VulkanApplicationBufferManager::setLodEnabled(bool enabled) {
+	this->lodEnabled = enabled;
+}
+
+glm::mat4 VulkanApplicationBufferManager::getViewProjection() {
+	return this->viewProjection;
+}
+
+glm::vec3 VulkanApplicationBufferManager::getEye() {
+	return this->eye;
 }
 
-std::vector<VkBuffer> VulkanApplicationBufferManager::getUniformBuffers() {
-	return this->uniformBuffers;
+float VulkanApplicationBufferManager::getPixelsPerUnit() {
+	return this->pixelsPerUnit;
 }
 
-std::vector<VkDeviceMemory> VulkanApplicationBufferManager::getUniformBuffersMemories() {
-	return this->uniformBuffersMemories;
+VertexFormat VulkanApplicationBufferManager::getVertexFormat() {
+	return this->mesh.vertexFormat;
 }
 
-std::vector<void*> VulkanApplicationBufferManager::getUniformBuffersMapped() {
-	return this->uniformBuffersMapped;
+VkIndexType VulkanApplicationBufferManager::getIndexType() {
+	return this->mesh.indexType;
 }
 
-std::vector<uint16_t> VulkanApplicationBufferManager::getIndices() {
-	return this->indices;
+Mesh& VulkanApplicationBufferManager::getMesh() {
+	return this->mesh;
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "headers/VulkanApplicationCommandRecorder.h"
+
+VulkanApplicationCommandRecorder::VulkanApplicationCommandRecorder(VkDevice logicalDevice, uint32_t queueFamilyIndex, uint32_t maxThreads) {
+	this->logicalDevice = logicalDevice;
+	this->maxThreads = maxThreads > 0 ? maxThreads : std::min(getJobSystem().getThreadCount(), kMAX_RECORDING_THREADS);
+
+	commandPools.resize(kMAX_FRAMES_IN_FLIGHT);
+	secondaryCommandBuffers.resize(kMAX_FRAMES_IN_FLIGHT);
+
+	for (size_t frame = 0; frame < kMAX_FRAMES_IN_FLIGHT; frame++) {
+		commandPools[frame].resize(this->maxThreads);
+		secondaryCommandBuffers[frame].resize(this->maxThreads);
+
+		for (uint32_t thread = 0; thread < this->maxThreads; thread++) {
+			// short lived buffers, re-recorded every time the frame comes around
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+			if (vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &commandPools[frame][thread]) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to Create Recording Command Pool");
+			}
+
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = commandPools[frame][thread];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &secondaryCommandBuffers[frame][thread]) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to Allocate Secondary Command Buffer");
+			}
+		}
+	}
+}
+
+VulkanApplicationCommandRecorder::~VulkanApplicationCommandRecorder() {}
+
+void VulkanApplicationCommandRecorder::cleanup() {
+	// destroying a pool frees its buffers
+	for (std::vector<VkCommandPool>& framePools : commandPools) {
+		for (VkCommandPool commandPool : framePools) {
+			vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
+		}
+	}
+}
+
+void VulkanApplicationCommandRecorder::recordSecondary(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer,
+	uint32_t first, uint32_t last, const RecordRangeFunction& recordRange, uint32_t& drawCount) {
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = renderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = framebuffer;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Begin Recording Secondary Command Buffer");
+	}
+
+	drawCount = recordRange(commandBuffer, first, last);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Record Secondary Command Buffer");
+	}
+}
+
+// the primary has to be inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+uint32_t VulkanApplicationCommandRecorder::record(VkCommandBuffer primaryCommandBuffer, uint32_t frameIndex, uint32_t threadCount, VkRenderPass renderPass,
+	VkFramebuffer framebuffer, uint32_t drawCount, const RecordRangeFunction& recordRange) {
+	// never more threads than pools, or than draws to hand out
+	threadCount = std::clamp(std::min(threadCount, drawCount), 1u, maxThreads);
+	uint32_t chunkSize = (drawCount + threadCount - 1) / threadCount;
+
+	std::vector<VkCommandPool>& framePools = commandPools[frameIndex];
+	std::vector<VkCommandBuffer>& frameBuffers = secondaryCommandBuffers[frameIndex];
+
+	// the frame's fence has signalled, nothing from these pools is in flight
+	for (uint32_t i = 0; i < threadCount; i++) {
+		vkResetCommandPool(logicalDevice, framePools[i], 0);
+	}
+
+	// one range per job, a failed recording is rethrown here
+	std::vector<uint32_t> drawCounts(threadCount, 0);
+
+	getJobSystem().parallelFor(threadCount, 1, [&](uint32_t firstRange, uint32_t lastRange) {
+		for (uint32_t i = firstRange; i < lastRange; i++) {
+			uint32_t first = std::min(drawCount, i * chunkSize);
+			uint32_t last = std::min(drawCount, first + chunkSize);
+			recordSecondary(frameBuffers[i], renderPass, framebuffer, first, last, recordRange, drawCounts[i]);
+		}
+	});
+
+	// ranges are in order, so the draws land in the same order a single thread would record them
+	vkCmdExecuteCommands(primaryCommandBuffer, threadCount, frameBuffers.data());
+
+	uint32_t recorded = 0;
+
+	for (uint32_t count : drawCounts) {
+		recorded += count;
+	}
+
+	return recorded;
+}
+
+uint32_t VulkanApplicationCommandRecorder::getMaxThreads() {
+	return this->maxThreads;
+}
\ No newline at end of file
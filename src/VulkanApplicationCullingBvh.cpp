@@ -0,0 +1,451 @@
+#include "headers/VulkanApplicationCullingBvh.h"
+#include <chrono>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define CULLING_SSE
+#include <immintrin.h>
+#endif
+
+#if defined(CULLING_SSE) && defined(__AVX__)
+#define CULLING_AVX
+#endif
+
+// the 6 planes split into components, with the absolute normals used to project the extents
+struct FrustumPlanes {
+	float normalX[6];
+	float normalY[6];
+	float normalZ[6];
+	float distance[6];
+	float absNormalX[6];
+	float absNormalY[6];
+	float absNormalZ[6];
+};
+
+static FrustumPlanes getFrustumPlanes(const Frustum& frustum) {
+	FrustumPlanes planes;
+
+	for (int i = 0; i < 6; i++) {
+		planes.normalX[i] = frustum.planes[i].x;
+		planes.normalY[i] = frustum.planes[i].y;
+		planes.normalZ[i] = frustum.planes[i].z;
+		planes.distance[i] = frustum.planes[i].w;
+		planes.absNormalX[i] = std::fabs(frustum.planes[i].x);
+		planes.absNormalY[i] = std::fabs(frustum.planes[i].y);
+		planes.absNormalZ[i] = std::fabs(frustum.planes[i].z);
+	}
+
+	return planes;
+}
+
+/*****************************************************
+						BUILD
+*****************************************************/
+
+static void getRangeBounds(const std::vector<CullingBox>& boxes, const std::vector<uint32_t>& order, uint32_t first, uint32_t count,
+	glm::vec3& boundsMin, glm::vec3& boundsMax, glm::vec3& centroidMin, glm::vec3& centroidMax) {
+	boundsMin = centroidMin = glm::vec3(std::numeric_limits<float>::max());
+	boundsMax = centroidMax = glm::vec3(-std::numeric_limits<float>::max());
+
+	for (uint32_t i = first; i < first + count; i++) {
+		const CullingBox& box = boxes[order[i]];
+		boundsMin = glm::min(boundsMin, box.center - box.extent);
+		boundsMax = glm::max(boundsMax, box.center + box.extent);
+		centroidMin = glm::min(centroidMin, box.center);
+		centroidMax = glm::max(centroidMax, box.center);
+	}
+}
+
+// median split along the longest axis of the centers, returns the size of the first half
+static uint32_t splitRange(const std::vector<CullingBox>& boxes, std::vector<uint32_t>& order, uint32_t first, uint32_t count) {
+	glm::vec3 boundsMin, boundsMax, centroidMin, centroidMax;
+	getRangeBounds(boxes, order, first, count, boundsMin, boundsMax, centroidMin, centroidMax);
+
+	glm::vec3 size = centroidMax - centroidMin;
+	int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+	uint32_t half = count / 2;
+
+	std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, [&](uint32_t a, uint32_t b) {
+		return boxes[a].center[axis] < boxes[b].center[axis];
+	});
+
+	return half;
+}
+
+static void buildNode(CullingBvh& bvh, const std::vector<CullingBox>& boxes, std::vector<uint32_t>& order, uint32_t nodeIndex, uint32_t first, uint32_t count) {
+	// two levels of binary splits give up to 4 children
+	std::array<uint32_t, 4> childFirst{};
+	std::array<uint32_t, 4> childCount{};
+	uint32_t children = 0;
+
+	if (count <= kCULLING_BVH_LEAF_SIZE) {
+		childFirst[0] = first;
+		childCount[0] = count;
+		children = 1;
+	} else {
+		uint32_t half = splitRange(boxes, order, first, count);
+		uint32_t halves[2][2] = { { first, half }, { first + half, count - half } };
+
+		for (auto& range : halves) {
+			if (range[1] > kCULLING_BVH_LEAF_SIZE) {
+				uint32_t quarter = splitRange(boxes, order, range[0], range[1]);
+				childFirst[children] = range[0];
+				childCount[children++] = quarter;
+				childFirst[children] = range[0] + quarter;
+				childCount[children++] = range[1] - quarter;
+			} else {
+				childFirst[children] = range[0];
+				childCount[children++] = range[1];
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < 4; i++) {
+		CullingBvhNode& node = bvh.nodes[nodeIndex];
+		node.first[i] = childFirst[i];
+		node.count[i] = childCount[i];
+		node.children[i] = -1;
+
+		if (i >= children) {
+			node.centerX[i] = node.centerY[i] = node.centerZ[i] = 0.0f;
+			node.extentX[i] = node.extentY[i] = node.extentZ[i] = -std::numeric_limits<float>::max();
+			continue;
+		}
+
+		glm::vec3 boundsMin, boundsMax, centroidMin, centroidMax;
+		getRangeBounds(boxes, order, childFirst[i], childCount[i], boundsMin, boundsMax, centroidMin, centroidMax);
+
+		// grown by a hair so rounding in center and extent never leaves a box poking out of its parent
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		glm::vec3 extent = (boundsMax - boundsMin) * 0.5f * 1.0001f + glm::vec3(1e-5f);
+		node.centerX[i] = center.x;
+		node.centerY[i] = center.y;
+		node.centerZ[i] = center.z;
+		node.extentX[i] = extent.x;
+		node.extentY[i] = extent.y;
+		node.extentZ[i] = extent.z;
+	}
+
+	for (uint32_t i = 0; i < children; i++) {
+		if (childCount[i] > kCULLING_BVH_LEAF_SIZE) {
+			uint32_t childIndex = static_cast<uint32_t>(bvh.nodes.size());
+			bvh.nodes.emplace_back();
+			bvh.nodes[nodeIndex].children[i] = static_cast<int32_t>(childIndex);
+			buildNode(bvh, boxes, order, childIndex, childFirst[i], childCount[i]);
+		}
+	}
+}
+
+CullingBvh buildCullingBvh(const std::vector<CullingBox>& boxes) {
+	CullingBvh bvh;
+	bvh.objectCount = static_cast<uint32_t>(boxes.size());
+	bvh.objectIndices.resize(boxes.size());
+
+	for (uint32_t i = 0; i < boxes.size(); i++) {
+		bvh.objectIndices[i] = i;
+	}
+
+	bvh.nodes.reserve(boxes.size() / kCULLING_BVH_LEAF_SIZE * 2 + 1);
+	bvh.nodes.emplace_back();
+	buildNode(bvh, boxes, bvh.objectIndices, 0, 0, bvh.objectCount);
+
+	// padding boxes fail every plane test, same as empty node slots
+	size_t paddedCount = boxes.size() + kCULLING_BVH_PADDING;
+	bvh.centerX.assign(paddedCount, 0.0f);
+	bvh.centerY.assign(paddedCount, 0.0f);
+	bvh.centerZ.assign(paddedCount, 0.0f);
+	bvh.extentX.assign(paddedCount, -std::numeric_limits<float>::max());
+	bvh.extentY.assign(paddedCount, -std::numeric_limits<float>::max());
+	bvh.extentZ.assign(paddedCount, -std::numeric_limits<float>::max());
+
+	for (uint32_t i = 0; i < bvh.objectCount; i++) {
+		const CullingBox& box = boxes[bvh.objectIndices[i]];
+		bvh.centerX[i] = box.center.x;
+		bvh.centerY[i] = box.center.y;
+		bvh.centerZ[i] = box.center.z;
+		bvh.extentX[i] = box.extent.x;
+		bvh.extentY[i] = box.extent.y;
+		bvh.extentZ[i] = box.extent.z;
+	}
+
+	return bvh;
+}
+
+/*****************************************************
+						TESTS
+*****************************************************/
+
+// visible when not entirely behind any plane, the extent projected onto the normal is how far the box reaches towards it
+bool isBoxInFrustum(const Frustum& frustum, const CullingBox& box) {
+	for (const glm::vec4& plane : frustum.planes) {
+		float distance = box.center.x * plane.x + box.center.y * plane.y + box.center.z * plane.z + plane.w;
+		float radius = box.extent.x * std::fabs(plane.x) + box.extent.y * std::fabs(plane.y) + box.extent.z * std::fabs(plane.z);
+
+		if (distance + radius < 0.0f) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// tests boxes [first, first + count) of the bvh arrays and appends the visible ones
+static void cullRange(const CullingBvh& bvh, const FrustumPlanes& planes, uint32_t first, uint32_t count, std::vector<uint32_t>& visibleObjects) {
+	uint32_t i = 0;
+
+#if defined(CULLING_AVX)
+	for (; i < count; i += 8) {
+		uint32_t index = first + i;
+		__m256 centerX = _mm256_loadu_ps(&bvh.centerX[index]);
+		__m256 centerY = _mm256_loadu_ps(&bvh.centerY[index]);
+		__m256 centerZ = _mm256_loadu_ps(&bvh.centerZ[index]);
+		__m256 extentX = _mm256_loadu_ps(&bvh.extentX[index]);
+		__m256 extentY = _mm256_loadu_ps(&bvh.extentY[index]);
+		__m256 extentZ = _mm256_loadu_ps(&bvh.extentZ[index]);
+		__m256 outside = _mm256_setzero_ps();
+
+		for (int p = 0; p < 6; p++) {
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(planes.normalX[p])),
+				_mm256_mul_ps(centerY, _mm256_set1_ps(planes.normalY[p]))), _mm256_mul_ps(centerZ, _mm256_set1_ps(planes.normalZ[p]))),
+				_mm256_set1_ps(planes.distance[p]));
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(extentX, _mm256_set1_ps(planes.absNormalX[p])),
+				_mm256_mul_ps(extentY, _mm256_set1_ps(planes.absNormalY[p]))), _mm256_mul_ps(extentZ, _mm256_set1_ps(planes.absNormalZ[p])));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+
+		// lanes past the end of the range belong to the next leaf or the padding
+		uint32_t lanes = std::min(count - i, 8u);
+		uint32_t visible = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & ((1u << lanes) - 1);
+
+		while (visible != 0) {
+			uint32_t lane = 0;
+			while (!(visible & (1u << lane))) lane++;
+			visibleObjects.push_back(bvh.objectIndices[index + lane]);
+			visible &= visible - 1;
+		}
+	}
+#elif defined(CULLING_SSE)
+	for (; i < count; i += 4) {
+		uint32_t index = first + i;
+		__m128 centerX = _mm_loadu_ps(&bvh.centerX[index]);
+		__m128 centerY = _mm_loadu_ps(&bvh.centerY[index]);
+		__m128 centerZ = _mm_loadu_ps(&bvh.centerZ[index]);
+		__m128 extentX = _mm_loadu_ps(&bvh.extentX[index]);
+		__m128 extentY = _mm_loadu_ps(&bvh.extentY[index]);
+		__m128 extentZ = _mm_loadu_ps(&bvh.extentZ[index]);
+		__m128 outside = _mm_setzero_ps();
+
+		for (int p = 0; p < 6; p++) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(planes.normalX[p])), _mm_mul_ps(centerY, _mm_set1_ps(planes.normalY[p]))),
+				_mm_mul_ps(centerZ, _mm_set1_ps(planes.normalZ[p]))), _mm_set1_ps(planes.distance[p]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(planes.absNormalX[p])), _mm_mul_ps(extentY, _mm_set1_ps(planes.absNormalY[p]))),
+				_mm_mul_ps(extentZ, _mm_set1_ps(planes.absNormalZ[p])));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		}
+
+		uint32_t lanes = std::min(count - i, 4u);
+		uint32_t visible = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & ((1u << lanes) - 1);
+
+		while (visible != 0) {
+			uint32_t lane = 0;
+			while (!(visible & (1u << lane))) lane++;
+			visibleObjects.push_back(bvh.objectIndices[index + lane]);
+			visible &= visible - 1;
+		}
+	}
+#else
+	for (; i < count; i++) {
+		uint32_t index = first + i;
+		bool outside = false;
+
+		for (int p = 0; p < 6 && !outside; p++) {
+			float distance = bvh.centerX[index] * planes.normalX[p] + bvh.centerY[index] * planes.normalY[p] + bvh.centerZ[index] * planes.normalZ[p] + planes.distance[p];
+			float radius = bvh.extentX[index] * planes.absNormalX[p] + bvh.extentY[index] * planes.absNormalY[p] + bvh.extentZ[index] * planes.absNormalZ[p];
+			outside = distance + radius < 0.0f;
+		}
+
+		if (!outside) {
+			visibleObjects.push_back(bvh.objectIndices[index]);
+		}
+	}
+#endif
+}
+
+// all 4 children at once, bit i of visibleMask is set when child i isn't outside, insideMask when it's entirely inside
+static void cullNode(const CullingBvhNode& node, const FrustumPlanes& planes, uint32_t& visibleMask, uint32_t& insideMask) {
+#if defined(CULLING_SSE)
+	__m128 centerX = _mm_load_ps(node.centerX);
+	__m128 centerY = _mm_load_ps(node.centerY);
+	__m128 centerZ = _mm_load_ps(node.centerZ);
+	__m128 extentX = _mm_load_ps(node.extentX);
+	__m128 extentY = _mm_load_ps(node.extentY);
+	__m128 extentZ = _mm_load_ps(node.extentZ);
+	__m128 outside = _mm_setzero_ps();
+	__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	for (int p = 0; p < 6; p++) {
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(planes.normalX[p])), _mm_mul_ps(centerY, _mm_set1_ps(planes.normalY[p]))),
+			_mm_mul_ps(centerZ, _mm_set1_ps(planes.normalZ[p]))), _mm_set1_ps(planes.distance[p]));
+		__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(planes.absNormalX[p])), _mm_mul_ps(extentY, _mm_set1_ps(planes.absNormalY[p]))),
+			_mm_mul_ps(extentZ, _mm_set1_ps(planes.absNormalZ[p])));
+		outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_sub_ps(distance, radius), _mm_setzero_ps()));
+	}
+
+	visibleMask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF;
+	insideMask = static_cast<uint32_t>(_mm_movemask_ps(inside)) & visibleMask;
+#else
+	visibleMask = 0;
+	insideMask = 0;
+
+	for (uint32_t i = 0; i < 4; i++) {
+		bool outside = false;
+		bool inside = true;
+
+		for (int p = 0; p < 6; p++) {
+			float distance = node.centerX[i] * planes.normalX[p] + node.centerY[i] * planes.normalY[p] + node.centerZ[i] * planes.normalZ[p] + planes.distance[p];
+			float radius = node.extentX[i] * planes.absNormalX[p] + node.extentY[i] * planes.absNormalY[p] + node.extentZ[i] * planes.absNormalZ[p];
+			outside = outside || distance + radius < 0.0f;
+			inside = inside && distance - radius >= 0.0f;
+		}
+
+		visibleMask |= outside ? 0 : (1u << i);
+		insideMask |= (!outside && inside) ? (1u << i) : 0;
+	}
+#endif
+}
+
+void cullFrustumBvh(const CullingBvh& bvh, const Frustum& frustum, std::vector<uint32_t>& visibleObjects, CullingStats* stats) {
+	visibleObjects.clear();
+
+	if (bvh.objectCount == 0) {
+		return;
+	}
+
+	FrustumPlanes planes = getFrustumPlanes(frustum);
+	uint64_t boxesTested = 0;
+
+	// depth is about log4(n / leaf size), 64 is plenty
+	uint32_t stack[64];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		const CullingBvhNode& node = bvh.nodes[stack[--stackSize]];
+		uint32_t visibleMask, insideMask;
+		cullNode(node, planes, visibleMask, insideMask);
+		boxesTested += 4;
+
+		for (uint32_t i = 0; i < 4; i++) {
+			if (!(visibleMask & (1u << i)) || node.count[i] == 0) {
+				continue;
+			}
+
+			if (insideMask & (1u << i)) {
+				// nothing below can be outside
+				visibleObjects.insert(visibleObjects.end(), bvh.objectIndices.begin() + node.first[i], bvh.objectIndices.begin() + node.first[i] + node.count[i]);
+			} else if (node.children[i] >= 0) {
+				stack[stackSize++] = static_cast<uint32_t>(node.children[i]);
+			} else {
+				cullRange(bvh, planes, node.first[i], node.count[i], visibleObjects);
+				boxesTested += node.count[i];
+			}
+		}
+	}
+
+	if (stats != nullptr) {
+		stats->visibleObjects = static_cast<uint32_t>(visibleObjects.size());
+		stats->boxesTested = boxesTested;
+	}
+}
+
+// every box, no hierarchy, the baseline the bvh has to beat
+void cullFrustumLinear(const CullingBvh& bvh, const Frustum& frustum, std::vector<uint32_t>& visibleObjects, CullingStats* stats) {
+	visibleObjects.clear();
+	cullRange(bvh, getFrustumPlanes(frustum), 0, bvh.objectCount, visibleObjects);
+
+	if (stats != nullptr) {
+		stats->visibleObjects = static_cast<uint32_t>(visibleObjects.size());
+		stats->boxesTested = bvh.objectCount;
+	}
+}
+
+const char* getCullingSimdName() {
+#if defined(CULLING_AVX)
+	return "AVX";
+#elif defined(CULLING_SSE)
+	return "SSE";
+#else
+	return "Scalar";
+#endif
+}
+
+/*****************************************************
+					BENCHMARK
+*****************************************************/
+
+static void printCullingResult(const std::string& name, double seconds, const CullingStats& stats, uint32_t objectCount) {
+	double nanoseconds = seconds * 1e9;
+	cout << "  " << name << ": " << seconds * 1e3 << " ms, " << stats.visibleObjects << " visible, " << stats.boxesTested << " boxes tested, "
+		<< stats.boxesTested / nanoseconds << " boxes/ns, " << objectCount / nanoseconds << " objects/ns" << endl;
+}
+
+// boxes scattered through a cube with the camera in the middle, so only a slice of them is in view
+void runFrustumCullingBenchmark(uint32_t objectCount) {
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> size(0.25f, 2.0f);
+
+	std::vector<CullingBox> boxes(objectCount);
+
+	for (CullingBox& box : boxes) {
+		box.center = glm::vec3(position(random), position(random), position(random));
+		box.extent = glm::vec3(size(random), size(random), size(random));
+	}
+
+	auto buildStart = std::chrono::high_resolution_clock::now();
+	CullingBvh bvh = buildCullingBvh(boxes);
+	double buildSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - buildStart).count();
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.3f, 0.1f), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+	projection[1][1] *= -1;
+	Frustum frustum = extractFrustum(projection * view);
+
+	cout << "Frustum Culling Benchmark: " << objectCount << " boxes, " << getCullingSimdName() << ", bvh of " << bvh.nodes.size()
+		<< " nodes built in " << buildSeconds * 1e3 << " ms" << endl;
+
+	std::vector<uint32_t> scalarVisible;
+	CullingStats scalarStats;
+	double scalarSeconds = timeBenchmark([&]() {
+		scalarVisible.clear();
+
+		for (uint32_t i = 0; i < objectCount; i++) {
+			if (isBoxInFrustum(frustum, boxes[i])) {
+				scalarVisible.push_back(i);
+			}
+		}
+	});
+	scalarStats.visibleObjects = static_cast<uint32_t>(scalarVisible.size());
+	scalarStats.boxesTested = objectCount;
+
+	std::vector<uint32_t> linearVisible;
+	CullingStats linearStats;
+	double linearSeconds = timeBenchmark([&]() { cullFrustumLinear(bvh, frustum, linearVisible, &linearStats); });
+
+	std::vector<uint32_t> bvhVisible;
+	CullingStats bvhStats;
+	double bvhSeconds = timeBenchmark([&]() { cullFrustumBvh(bvh, frustum, bvhVisible, &bvhStats); });
+
+	printCullingResult("Scalar, every box", scalarSeconds, scalarStats, objectCount);
+	printCullingResult(std::string(getCullingSimdName()) + ", every box", linearSeconds, linearStats, objectCount);
+	printCullingResult(std::string(getCullingSimdName()) + ", bvh", bvhSeconds, bvhStats, objectCount);
+
+	// every method has to agree with the scalar reference
+	std::sort(linearVisible.begin(), linearVisible.end());
+	std::sort(bvhVisible.begin(), bvhVisible.end());
+
+	if (linearVisible != scalarVisible || bvhVisible != scalarVisible) {
+		throw std::runtime_error("Culling Results Differ From the Scalar Reference");
+	}
+}
\ No newline at end of file
@@ -70,33 +70,107 @@ bool VulkanApplicationDeviceManager::checkDeviceExtensionSupport(VkPhysicalDevic
 	return requiredExtensions.empty();
 }
 
+bool VulkanApplicationDeviceManager::checkOptionalExtensionSupport(VkPhysicalDevice physicalDevice, const char* extensionName) {
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+	for (const auto& extension : availableExtensions) {
+		if (strcmp(extension.extensionName, extensionName) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// the extension alone isn't enough, each feature is optional within it. Needs a 1.1 device for vkGetPhysicalDeviceFeatures2
+bool VulkanApplicationDeviceManager::checkDescriptorIndexingSupport(VkPhysicalDevice physicalDevice) {
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	if (properties.apiVersion < VK_API_VERSION_1_1 || !checkOptionalExtensionSupport(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+		return false;
+	}
+
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{};
+	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+	VkPhysicalDeviceFeatures2 features{};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &indexingFeatures;
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+	return indexingFeatures.shaderSampledImageArrayNonUniformIndexing && indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+		indexingFeatures.descriptorBindingUpdateUnusedWhilePending && indexingFeatures.descriptorBindingPartiallyBound && indexingFeatures.runtimeDescriptorArray;
+}
+
 void VulkanApplicationDeviceManager::createLogicalDevice(VkSurfaceKHR surface) {
 	QueueFamilyIndices indices = findQueueFamilies(physicalDevice, surface);
+	queueFamilyIndices = indices;
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value(), indices.transferFamily.value() };
 
 	float queuePriority = 1.0f;
 
 	for (uint32_t queueFamily : uniqueQueueFamilies) {
 		VkDeviceQueueCreateInfo queueCreateInfo{};
 		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		queueCreateInfo.queueFamilyIndex = indices.graphicsFamily.value();
+		queueCreateInfo.queueFamilyIndex = queueFamily;
 		queueCreateInfo.queueCount = 1;
 		queueCreateInfo.pQueuePriorities = &queuePriority;
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
-	VkPhysicalDeviceFeatures deviceFeatures{};
-	deviceFeatures.samplerAnisotropy = VK_TRUE;
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+	// the indirect features are optional, the gpu driven path checks for them before using them
+	enabledFeatures = VkPhysicalDeviceFeatures{};
+	enabledFeatures.samplerAnisotropy = VK_TRUE;
+	enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+	// same for BC textures, without it they're decoded on the cpu
+	enabledFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+	std::vector<const char*> extensions = deviceExtensions;
+	drawIndirectCountEnabled = checkOptionalExtensionSupport(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+	if (drawIndirectCountEnabled) {
+		extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	}
+
+	// only what the bindless texture table uses, enabled all together or not at all
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{};
+	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	descriptorIndexingEnabled = checkDescriptorIndexingSupport(physicalDevice);
+
+	if (descriptorIndexingEnabled) {
+		extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+	}
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+	graphicsComputeSupported = (queueFamilies[indices.graphicsFamily.value()].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
 
 	VkDeviceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	createInfo.queueCreateInfoCount = queueCreateInfos.size();
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
-	createInfo.pEnabledFeatures = &deviceFeatures;
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+	createInfo.pNext = descriptorIndexingEnabled ? &indexingFeatures : nullptr;
+	createInfo.pEnabledFeatures = &enabledFeatures;
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+	createInfo.ppEnabledExtensionNames = extensions.data();
 
 	if (debug) {
 		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -111,6 +185,15 @@ void VulkanApplicationDeviceManager::createLogicalDevice(VkSurfaceKHR surface) {
 
 	vkGetDeviceQueue(logicalDevice, indices.graphicsFamily.value(), 0, &graphicsQueue);
 	vkGetDeviceQueue(logicalDevice, indices.presentFamily.value(), 0, &presentQueue);
+	vkGetDeviceQueue(logicalDevice, indices.transferFamily.value(), 0, &transferQueue);
+
+	if (debug) {
+		if (indices.transferFamily.value() != indices.graphicsFamily.value()) {
+			cout << "Uploads use queue family " << indices.transferFamily.value() << ", graphics uses " << indices.graphicsFamily.value() << endl;
+		} else {
+			cout << "No separate transfer queue family, uploads share the graphics queue" << endl;
+		}
+	}
 }
 
 VkPhysicalDevice VulkanApplicationDeviceManager::getPhysicalDevice() {
@@ -127,4 +210,28 @@ VkQueue VulkanApplicationDeviceManager::getGraphicsQueue() {
 
 VkQueue VulkanApplicationDeviceManager::getPresentQueue() {
 	return this->presentQueue;
+}
+
+VkQueue VulkanApplicationDeviceManager::getTransferQueue() {
+	return this->transferQueue;
+}
+
+QueueFamilyIndices VulkanApplicationDeviceManager::getQueueFamilyIndices() {
+	return this->queueFamilyIndices;
+}
+
+VkPhysicalDeviceFeatures VulkanApplicationDeviceManager::getEnabledFeatures() {
+	return this->enabledFeatures;
+}
+
+bool VulkanApplicationDeviceManager::getDrawIndirectCountEnabled() {
+	return this->drawIndirectCountEnabled;
+}
+
+bool VulkanApplicationDeviceManager::getDescriptorIndexingEnabled() {
+	return this->descriptorIndexingEnabled;
+}
+
+bool VulkanApplicationDeviceManager::getGraphicsComputeSupported() {
+	return this->graphicsComputeSupported;
 }
\ No newline at end of file
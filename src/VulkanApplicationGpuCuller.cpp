@@ -0,0 +1,317 @@
+#include "headers/VulkanApplicationGpuCuller.h"
+
+VulkanApplicationGpuCuller::VulkanApplicationGpuCuller(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkPipelineCache pipelineCache, IndirectDrawMode drawMode, uint32_t objectCount,
+	const std::vector<MeshLod>& lods, const glm::vec4& boundingSphere, const std::vector<VkBuffer>& instanceBuffers) {
+	this->logicalDevice = logicalDevice;
+	this->allocator = &allocator;
+	this->drawMode = drawMode;
+	this->objectCount = objectCount;
+	this->boundingSphere = boundingSphere;
+
+	if (drawMode == IndirectDrawMode::kIndirectCount) {
+		// device extension commands aren't exported by the loader, they come from vkGetDeviceProcAddr
+		drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(logicalDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+
+		if (drawIndexedIndirectCount == nullptr) {
+			this->drawMode = IndirectDrawMode::kMultiDrawIndirect;
+		}
+	}
+
+	createMeshBuffer(lods);
+	createFrameBuffers();
+	createDescriptorSets(instanceBuffers);
+	createPipeline(pipelineCache);
+
+	framePending.resize(kMAX_FRAMES_IN_FLIGHT, false);
+	expectedDrawCounts.resize(kMAX_FRAMES_IN_FLIGHT, 0);
+}
+
+VulkanApplicationGpuCuller::~VulkanApplicationGpuCuller() {}
+
+void VulkanApplicationGpuCuller::cleanup() {
+	if (debug && stats.framesValidated > 0) {
+		cout << "GPU Culling: " << stats.framesMismatched << " of " << stats.framesValidated << " validated frames disagreed with the cpu" << endl;
+	}
+
+	vkDestroyPipeline(logicalDevice, pipeline, nullptr);
+	vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
+	vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(logicalDevice, descriptorSetLayout, nullptr);
+
+	for (size_t i = 0; i < kMAX_FRAMES_IN_FLIGHT; i++) {
+		destroyBuffer(logicalDevice, *allocator, resultBuffers[i], resultBufferAllocations[i]);
+		destroyBuffer(logicalDevice, *allocator, drawBuffers[i], drawBufferAllocations[i]);
+	}
+
+	destroyBuffer(logicalDevice, *allocator, meshBuffer, meshBufferAllocation);
+}
+
+void VulkanApplicationGpuCuller::createMeshBuffer(const std::vector<MeshLod>& lods) {
+	// a few dozen bytes written once, not worth a staging copy
+	VkDeviceSize bufferSize = sizeof(CullMeshHeader) + sizeof(MeshLod) * lods.size();
+	createBuffer(logicalDevice, *allocator, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, meshBuffer, meshBufferAllocation);
+
+	CullMeshHeader header{};
+	header.boundingSphere = boundingSphere;
+	header.lodCount = static_cast<uint32_t>(lods.size());
+
+	char* mapped = static_cast<char*>(meshBufferAllocation.mapped);
+	memcpy(mapped, &header, sizeof(CullMeshHeader));
+	memcpy(mapped + sizeof(CullMeshHeader), lods.data(), sizeof(MeshLod) * lods.size());
+}
+
+void VulkanApplicationGpuCuller::createFrameBuffers() {
+	drawBuffers.resize(kMAX_FRAMES_IN_FLIGHT);
+	drawBufferAllocations.resize(kMAX_FRAMES_IN_FLIGHT);
+	resultBuffers.resize(kMAX_FRAMES_IN_FLIGHT);
+	resultBufferAllocations.resize(kMAX_FRAMES_IN_FLIGHT);
+
+	for (size_t i = 0; i < kMAX_FRAMES_IN_FLIGHT; i++) {
+		createBuffer(logicalDevice, *allocator, sizeof(VkDrawIndexedIndirectCommand) * objectCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, drawBuffers[i], drawBufferAllocations[i]);
+		createBuffer(logicalDevice, *allocator, sizeof(CullResults), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, resultBuffers[i], resultBufferAllocations[i]);
+	}
+}
+
+void VulkanApplicationGpuCuller::createDescriptorSets(const std::vector<VkBuffer>& instanceBuffers) {
+	// instances, mesh, draws, results
+	std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+
+	for (uint32_t i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		bindings[i].pImmutableSamplers = nullptr;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Culling Descriptor Set Layout");
+	}
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = static_cast<uint32_t>(bindings.size() * kMAX_FRAMES_IN_FLIGHT);
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = static_cast<uint32_t>(kMAX_FRAMES_IN_FLIGHT);
+
+	if (vkCreateDescriptorPool(logicalDevice, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Culling Descriptor Pool");
+	}
+
+	std::vector<VkDescriptorSetLayout> layouts(kMAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = static_cast<uint32_t>(kMAX_FRAMES_IN_FLIGHT);
+	allocInfo.pSetLayouts = layouts.data();
+
+	descriptorSets.resize(kMAX_FRAMES_IN_FLIGHT);
+
+	if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Allocate Culling Descriptor Sets");
+	}
+
+	for (size_t i = 0; i < kMAX_FRAMES_IN_FLIGHT; i++) {
+		std::array<VkDescriptorBufferInfo, 4> bufferInfos{};
+		bufferInfos[0] = { instanceBuffers[i], 0, VK_WHOLE_SIZE };
+		bufferInfos[1] = { meshBuffer, 0, VK_WHOLE_SIZE };
+		bufferInfos[2] = { drawBuffers[i], 0, VK_WHOLE_SIZE };
+		bufferInfos[3] = { resultBuffers[i], 0, VK_WHOLE_SIZE };
+
+		std::array<VkWriteDescriptorSet, 4> descriptorWrites{};
+
+		for (uint32_t binding = 0; binding < descriptorWrites.size(); binding++) {
+			descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrites[binding].dstSet = descriptorSets[i];
+			descriptorWrites[binding].dstBinding = binding;
+			descriptorWrites[binding].dstArrayElement = 0;
+			descriptorWrites[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorWrites[binding].descriptorCount = 1;
+			descriptorWrites[binding].pBufferInfo = &bufferInfos[binding];
+		}
+
+		vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+	}
+}
+
+void VulkanApplicationGpuCuller::createPipeline(VkPipelineCache pipelineCache) {
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(CullPushConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Culling Pipeline Layout");
+	}
+
+	std::vector<char> code = readFile("shaders/cull.spv");
+
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = code.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+
+	if (vkCreateShaderModule(logicalDevice, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		throw std::runtime_error("Shader Module Creation Failed");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+
+	VkResult result = vkCreateComputePipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+	vkDestroyShaderModule(logicalDevice, shaderModule, nullptr);
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Culling Pipeline");
+	}
+}
+
+// recorded before the render pass, the frame's instance buffer has to be written already
+void VulkanApplicationGpuCuller::recordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex, const CullPushConstants& pushConstants) {
+	vkCmdFillBuffer(commandBuffer, resultBuffers[frameIndex], 0, sizeof(CullResults), 0);
+
+	VkMemoryBarrier clearBarrier{};
+	clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+	CullPushConstants constants = pushConstants;
+	constants.objectCount = objectCount;
+
+	if (drawMode == IndirectDrawMode::kIndirectCount) {
+		constants.flags |= kCULL_FLAG_COMPACT;
+	}
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets[frameIndex], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &constants);
+	vkCmdDispatch(commandBuffer, (objectCount + kCULL_GROUP_SIZE - 1) / kCULL_GROUP_SIZE, 1, 1);
+
+	// the draws read the commands and the count, the host reads the results after the fence
+	VkMemoryBarrier cullBarrier{};
+	cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+		0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+
+	framePending[frameIndex] = true;
+}
+
+// recorded inside the render pass with the instanced pipeline and both vertex bindings bound, returns the draw calls recorded
+uint32_t VulkanApplicationGpuCuller::recordDraws(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+	uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+	switch (drawMode) {
+		case IndirectDrawMode::kIndirectCount:
+			drawIndexedIndirectCount(commandBuffer, drawBuffers[frameIndex], 0, resultBuffers[frameIndex], offsetof(CullResults, drawCount), objectCount, stride);
+			return 1;
+		case IndirectDrawMode::kMultiDrawIndirect:
+			vkCmdDrawIndexedIndirect(commandBuffer, drawBuffers[frameIndex], 0, objectCount, stride);
+			return 1;
+		default:
+			for (uint32_t i = 0; i < objectCount; i++) {
+				vkCmdDrawIndexedIndirect(commandBuffer, drawBuffers[frameIndex], static_cast<VkDeviceSize>(i) * stride, 1, stride);
+			}
+
+			return objectCount;
+	}
+}
+
+// only safe once the frame's fence has been waited on
+void VulkanApplicationGpuCuller::collectResults(uint32_t frameIndex) {
+	if (!framePending[frameIndex]) {
+		return;
+	}
+
+	framePending[frameIndex] = false;
+
+	CullResults results;
+	memcpy(&results, resultBufferAllocations[frameIndex].mapped, sizeof(CullResults));
+	stats.visibleObjects = results.drawCount;
+	stats.trianglesSubmitted = results.triangleCount;
+
+	if (debug) {
+		stats.framesValidated++;
+
+		if (results.drawCount != expectedDrawCounts[frameIndex]) {
+			stats.framesMismatched++;
+		}
+	}
+}
+
+// the same sphere test as cull.comp over the same models, compared against the gpu count in collectResults()
+void VulkanApplicationGpuCuller::validate(uint32_t frameIndex, const std::vector<glm::mat4>& models, const Frustum& frustum) {
+	uint32_t visible = 0;
+
+	for (uint32_t i = 0; i < objectCount; i++) {
+		glm::vec3 center = glm::vec3(models[i] * glm::vec4(glm::vec3(boundingSphere), 1.0f));
+
+		if (isSphereInFrustum(frustum, center, boundingSphere.w)) {
+			visible++;
+		}
+	}
+
+	expectedDrawCounts[frameIndex] = visible;
+}
+
+IndirectDrawMode VulkanApplicationGpuCuller::getDrawMode() {
+	return this->drawMode;
+}
+
+GpuCullStats VulkanApplicationGpuCuller::getStats() {
+	return this->stats;
+}
+
+// every mode puts the object index in firstInstance, and the graphics queue runs the compute pass
+bool isGpuCullingSupported(const VkPhysicalDeviceFeatures& features, bool graphicsComputeSupported) {
+	return features.drawIndirectFirstInstance && graphicsComputeSupported;
+}
+
+IndirectDrawMode selectIndirectDrawMode(const VkPhysicalDeviceFeatures& features, bool drawIndirectCountEnabled) {
+	if (drawIndirectCountEnabled && features.multiDrawIndirect) {
+		return IndirectDrawMode::kIndirectCount;
+	}
+
+	if (features.multiDrawIndirect) {
+		return IndirectDrawMode::kMultiDrawIndirect;
+	}
+
+	return IndirectDrawMode::kSingleDrawIndirect;
+}
+
+const char* getIndirectDrawModeName(IndirectDrawMode drawMode) {
+	switch (drawMode) {
+		case IndirectDrawMode::kIndirectCount: return "Indirect Count";
+		case IndirectDrawMode::kMultiDrawIndirect: return "Multi Draw Indirect";
+		case IndirectDrawMode::kSingleDrawIndirect: return "Single Draw Indirect";
+		default: return "Unknown";
+	}
+}
\ No newline at end of file
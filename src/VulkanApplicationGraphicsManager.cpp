@@ -7,7 +7,10 @@ VulkanApplicationGraphicsManager::VulkanApplicationGraphicsManager(VkFormat swap
 VulkanApplicationGraphicsManager::~VulkanApplicationGraphicsManager() {}
 
 void VulkanApplicationGraphicsManager::cleanup(VkDevice logicalDevice) {
-	vkDestroyPipeline(logicalDevice, graphicsPipeline, nullptr);
+	if (pipelineRegistry) {
+		pipelineRegistry->cleanup();
+	}
+
 	vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
 	vkDestroyRenderPass(logicalDevice, renderPass, nullptr);
 }
@@ -20,8 +23,13 @@ VkPipelineLayout VulkanApplicationGraphicsManager::getPipelineLayout() {
 	return this->pipelineLayout;
 }
 
-VkPipeline VulkanApplicationGraphicsManager::getGraphicsPipeline() {
-	return this->graphicsPipeline;
+// VK_NULL_HANDLE while the path's pipeline is still compiling, call it from the frame loop's thread only
+VkPipeline VulkanApplicationGraphicsManager::getGraphicsPipeline(DrawPath drawPath) {
+	return this->pipelineRegistry->getPipeline(this->drawPathPipelines[static_cast<size_t>(drawPath)]);
+}
+
+VulkanApplicationPipelineRegistry& VulkanApplicationGraphicsManager::getPipelineRegistry() {
+	return *this->pipelineRegistry;
 }
 
 void VulkanApplicationGraphicsManager::createRenderPass(VkFormat swapchainImageFormat, VkDevice logicalDevice, VkPhysicalDevice physicalDevice) {
@@ -85,146 +93,71 @@ void VulkanApplicationGraphicsManager::createRenderPass(VkFormat swapchainImageF
 	}
 }
 
-void VulkanApplicationGraphicsManager::createGraphicsPipeline(VkDevice logicalDevice, VkDescriptorSetLayout descriptorSetLayout) {
-	auto vertexShaderCode = readFile("shaders/vert.spv");
-	auto fragmentShaderCode = readFile("shaders/frag.spv");
-
-	VkShaderModule vertexShaderModule = createShaderModule(vertexShaderCode, logicalDevice);
-	VkShaderModule fragmentShaderModule = createShaderModule(fragmentShaderCode, logicalDevice);
-
-	VkPipelineShaderStageCreateInfo vertexShaderStageInfo{};
-	vertexShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertexShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	vertexShaderStageInfo.module = vertexShaderModule;
-	vertexShaderStageInfo.pName = "main";
-
-	VkPipelineShaderStageCreateInfo fragmentShaderStageInfo{};
-	fragmentShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	fragmentShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragmentShaderStageInfo.module = fragmentShaderModule;
-	fragmentShaderStageInfo.pName = "main";
-
-	VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderStageInfo, fragmentShaderStageInfo };
-
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescription = Vertex::getAttributeDescriptions();
-
-	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescription.size());
-	vertexInputInfo.pVertexAttributeDescriptions = attributeDescription.data();
-
-	VkPipelineInputAssemblyStateCreateInfo inputAssmebly{};
-	inputAssmebly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssmebly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	inputAssmebly.primitiveRestartEnable = VK_FALSE;
-
-	VkPipelineViewportStateCreateInfo viewportState{};
-	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewportState.viewportCount = 1;
-	viewportState.scissorCount = 1;
-
-	VkPipelineRasterizationStateCreateInfo rasterizer{};
-	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	rasterizer.depthClampEnable = VK_FALSE; // could be used as true during shadow map passes
-	rasterizer.rasterizerDiscardEnable = VK_FALSE; // true disabled output from being sent to framebuffer
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL; // fill polygon with fragments, point and line as read
-	// rasterizer.lineWidth = 1.0f; if the other modes are used, maybe a point weight too?
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-	// below could be used for shadow mapping
-	rasterizer.depthBiasEnable = VK_FALSE; // enable bias, adds constant factor or can bias based on slope
-	rasterizer.depthBiasConstantFactor = 0.0f;
-	rasterizer.depthBiasClamp = 0.0f;
-	rasterizer.depthBiasSlopeFactor = 0.0f;
-
-	VkPipelineMultisampleStateCreateInfo multisampling{};
-	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisampling.sampleShadingEnable = VK_FALSE;
-	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-	multisampling.minSampleShading = 1.0f;
-	multisampling.pSampleMask = nullptr;
-	multisampling.alphaToCoverageEnable = VK_FALSE;
-	multisampling.alphaToOneEnable = VK_FALSE;
-
-	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
-		VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
-		VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.blendEnable = VK_FALSE;
-	/*src, dstColor Blend optional, src dstAlpha Blend Optional, alpha and colorBlendOP optional*/
-
-	VkPipelineColorBlendStateCreateInfo colorBlending{};
-	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	colorBlending.logicOpEnable = VK_FALSE;
-	colorBlending.attachmentCount = 1;
-	colorBlending.pAttachments = &colorBlendAttachment;
-
-	VkPipelineDepthStencilStateCreateInfo depthStencil{};
-	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-	depthStencil.depthTestEnable = VK_TRUE;
-	depthStencil.depthWriteEnable = VK_TRUE;
-	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-	depthStencil.depthBoundsTestEnable = VK_FALSE;
-	depthStencil.stencilTestEnable = VK_FALSE;
-
-	std::vector<VkDynamicState> dynamicStates = {
-		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_SCISSOR
-	};
-
-	VkPipelineDynamicStateCreateInfo dynamicState{};
-	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-	dynamicState.pDynamicStates = dynamicStates.data();
+void VulkanApplicationGraphicsManager::createGraphicsPipeline(VkDevice logicalDevice, VkPipelineCache pipelineCache, VkDescriptorSetLayout descriptorSetLayout,
+	VkDescriptorSetLayout bindlessSetLayout, VertexFormat vertexFormat) {
+	createPipelineLayout(logicalDevice, descriptorSetLayout, bindlessSetLayout);
+	pipelineRegistry = std::make_unique<VulkanApplicationPipelineRegistry>(logicalDevice, pipelineCache, renderPass, pipelineLayout);
 
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-	pipelineLayoutInfo.setLayoutCount = 1;
+	// the mesh's vertex format decides the layout, the shaders read every format the same way
+	baseDescription.vertexFormat = vertexFormat;
+	// with the bindless table every path samples the texture of the object's material instead of binding 1
+	baseDescription.fragmentShaderPath = bindlessSetLayout != VK_NULL_HANDLE ? "shaders/frag_bindless.spv" : "shaders/frag.spv";
 
-	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to Create Pipeline Layout");
-	}
+	requestDrawPathPipelines();
 
-	VkGraphicsPipelineCreateInfo pipelineInfo{};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;
-	pipelineInfo.pStages = shaderStages;
-
-	pipelineInfo.pVertexInputState = &vertexInputInfo;
-	pipelineInfo.pInputAssemblyState = &inputAssmebly;
-	pipelineInfo.pViewportState = &viewportState;
-	pipelineInfo.pRasterizationState = &rasterizer;
-	pipelineInfo.pMultisampleState = &multisampling;
-	pipelineInfo.pDepthStencilState = &depthStencil;
-	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.pDynamicState = &dynamicState;
-	pipelineInfo.layout = pipelineLayout;
-
-	pipelineInfo.renderPass = renderPass;
-	pipelineInfo.subpass = 0;
-
-	if (vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to Create Graphics Pipeline");
+	// they compile side by side, but the first frame can't draw without them
+	for (PipelineHandle handle : drawPathPipelines) {
+		pipelineRegistry->wait(handle);
 	}
+}
 
-	vkDestroyShaderModule(logicalDevice, vertexShaderModule, nullptr);
-	vkDestroyShaderModule(logicalDevice, fragmentShaderModule, nullptr);
+// each path falls back to the pipeline it had before, so switching never waits on a compile
+void VulkanApplicationGraphicsManager::requestDrawPathPipelines() {
+	std::vector<PipelineHandle> previous = drawPathPipelines;
+	previous.resize(static_cast<size_t>(DrawPath::kCount));
+	drawPathPipelines.resize(static_cast<size_t>(DrawPath::kCount));
+
+	PipelineDescription description = baseDescription;
+	description.permutation = shaderPermutation;
+
+	description.vertexShaderPath = "shaders/vert.spv";
+	drawPathPipelines[static_cast<size_t>(DrawPath::kUniformBuffer)] = pipelineRegistry->request(description, previous[static_cast<size_t>(DrawPath::kUniformBuffer)]);
+	description.vertexShaderPath = "shaders/vert_push.spv";
+	drawPathPipelines[static_cast<size_t>(DrawPath::kPushConstants)] = pipelineRegistry->request(description, previous[static_cast<size_t>(DrawPath::kPushConstants)]);
+	description.vertexShaderPath = "shaders/vert_instanced.spv";
+	description.instanced = true;
+	drawPathPipelines[static_cast<size_t>(DrawPath::kInstanced)] = pipelineRegistry->request(description, previous[static_cast<size_t>(DrawPath::kInstanced)]);
+	// indirect draws put the object in firstInstance, so the instanced shader reads the right model unchanged. same description, same pipeline
+	drawPathPipelines[static_cast<size_t>(DrawPath::kGpuDriven)] = pipelineRegistry->request(description, previous[static_cast<size_t>(DrawPath::kGpuDriven)]);
 }
 
-VkShaderModule VulkanApplicationGraphicsManager::createShaderModule(const std::vector<char>& code, VkDevice logicalDevice) {
-	VkShaderModuleCreateInfo createInfo{};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+void VulkanApplicationGraphicsManager::setShaderPermutation(const ShaderPermutation& permutation) {
+	shaderPermutation = permutation;
+	requestDrawPathPipelines();
+}
 
-	VkShaderModule shaderModule;
-	if (vkCreateShaderModule(logicalDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-		throw std::runtime_error("Shader Module Creation Failed");
-	}
+ShaderPermutation VulkanApplicationGraphicsManager::getShaderPermutation() {
+	return this->shaderPermutation;
+}
+
+void VulkanApplicationGraphicsManager::createPipelineLayout(VkDevice logicalDevice, VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSetLayout bindlessSetLayout) {
+	// every path shares the layout, shaders that don't read the push constants just ignore them
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(ObjectPushConstants);
+
+	// set 1 is the bindless texture table when the device has one
+	std::array<VkDescriptorSetLayout, 2> setLayouts = { descriptorSetLayout, bindlessSetLayout };
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutInfo.setLayoutCount = bindlessSetLayout != VK_NULL_HANDLE ? 2 : 1;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
-	return shaderModule;
+	if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Pipeline Layout");
+	}
 }
\ No newline at end of file
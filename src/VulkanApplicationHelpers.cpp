@@ -1,4 +1,6 @@
 #include "headers/VulkanApplicationHelpers.h"
+#include "headers/VulkanApplicationMemoryAllocator.h"
+#include <filesystem>
 
 std::vector<const char*> getRequiredExtensions() {
 	uint32_t glfwExtensionCount = 0;
@@ -52,7 +54,7 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceK
 	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
 
 	// Tutorial does a const auto loop but this is better imo
-	for (int i = 0; i < queueFamilies.size(); i++) {
+	for (uint32_t i = 0; i < queueFamilies.size(); i++) {
 		if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
 			indices.graphicsFamily = i;
 		}
@@ -69,6 +71,25 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceK
 		}
 	}
 
+	// transfer only families usually map to the copy engines, compute + transfer is the next best thing
+	for (uint32_t i = 0; i < queueFamilies.size() && !indices.transferFamily.has_value(); i++) {
+		if ((queueFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+			!(queueFamilies[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			indices.transferFamily = i;
+		}
+	}
+
+	for (uint32_t i = 0; i < queueFamilies.size() && !indices.transferFamily.has_value(); i++) {
+		if ((queueFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+			indices.transferFamily = i;
+		}
+	}
+
+	// graphics queues always support transfers
+	if (!indices.transferFamily.has_value()) {
+		indices.transferFamily = indices.graphicsFamily;
+	}
+
 	return indices;
 }
 
@@ -95,7 +116,7 @@ SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice physicalDevice, V
 	return details;
 }
 
-VkImageView createImageView(VkImage image, VkFormat format, VkDevice logicalDevice, VkImageAspectFlags aspectFlags) {
+VkImageView createImageView(VkImage image, VkFormat format, VkDevice logicalDevice, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
 	VkImageViewCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	createInfo.image = image;
@@ -110,7 +131,7 @@ VkImageView createImageView(VkImage image, VkFormat format, VkDevice logicalDevi
 
 	createInfo.subresourceRange.aspectMask = aspectFlags;
 	createInfo.subresourceRange.baseMipLevel = 0;
-	createInfo.subresourceRange.levelCount = 1;
+	createInfo.subresourceRange.levelCount = mipLevels;
 	createInfo.subresourceRange.baseArrayLayer = 0;
 	createInfo.subresourceRange.layerCount = 1;
 
@@ -141,16 +162,43 @@ std::vector<char> readFile(const std::string& filename) {
 	return buffer;
 }
 
+// written next to the real file and renamed over it, a crash mid write must not leave a valid looking file behind
+bool writeFileAtomically(const std::string& path, const char* data, size_t size) {
+	std::string temporaryPath = path + ".tmp";
+	std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+
+	if (!output.is_open()) {
+		return false;
+	}
+
+	output.write(data, size);
+	output.close();
+
+	std::error_code error;
+	if (output.fail()) {
+		error = std::make_error_code(std::errc::io_error);
+	} else {
+		std::filesystem::rename(temporaryPath, path, error);
+	}
+
+	if (error) {
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	return true;
+}
+
 void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
 	VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image,
-	VkDeviceMemory& imageMemory, VkDevice logicalDevice, VkPhysicalDevice physicalDevice) {
+	MemoryAllocation& imageAllocation, VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, uint32_t mipLevels) {
 	VkImageCreateInfo imageInfo{};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	imageInfo.imageType = VK_IMAGE_TYPE_2D; // 1d is gradient, 2d is mainly texture, 3d is used for voxel volumes
 	imageInfo.extent.width = width;
 	imageInfo.extent.height = height;
 	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
+	imageInfo.mipLevels = mipLevels;
 	imageInfo.arrayLayers = 1;
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
@@ -167,27 +215,65 @@ void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling
 	VkMemoryRequirements memRequirements{};
 	vkGetImageMemoryRequirements(logicalDevice, image, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits,
-		properties);
+	imageAllocation = allocator.allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_OPTIMAL);
 
-	if (vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to Allocate Image Memory");
-	}
+	vkBindImageMemory(logicalDevice, image, imageAllocation.memory, imageAllocation.offset);
+}
 
-	vkBindImageMemory(logicalDevice, image, imageMemory, 0);
+void destroyImage(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkImage& image, MemoryAllocation& imageAllocation) {
+	vkDestroyImage(logicalDevice, image, nullptr);
+	allocator.free(imageAllocation);
+	image = VK_NULL_HANDLE;
 }
 
 bool hasStencilComponent(VkFormat format) {
 	return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 }
 
-void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout,
-	VkCommandPool commandPool, VkDevice logicalDevice, VkQueue graphicsQueue) {
-	VkCommandBuffer commandBuffer = beginSingleTimeCommands(logicalDevice, commandPool);
+const char* getDrawPathName(DrawPath drawPath) {
+	switch (drawPath) {
+		case DrawPath::kUniformBuffer: return "Uniform Buffer";
+		case DrawPath::kPushConstants: return "Push Constants";
+		case DrawPath::kInstanced: return "Instanced";
+		case DrawPath::kGpuDriven: return "GPU Driven";
+		default: return "Unknown";
+	}
+}
+
+// Gribb and Hartmann, planes are sums of the rows of the matrix, near is just the z row since depth is 0..1
+Frustum extractFrustum(const glm::mat4& viewProjection) {
+	glm::vec4 rows[4];
+
+	for (int i = 0; i < 4; i++) {
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	}
+
+	Frustum frustum;
+	frustum.planes[0] = rows[3] + rows[0];
+	frustum.planes[1] = rows[3] - rows[0];
+	frustum.planes[2] = rows[3] + rows[1];
+	frustum.planes[3] = rows[3] - rows[1];
+	frustum.planes[4] = rows[2];
+	frustum.planes[5] = rows[3] - rows[2];
+
+	for (glm::vec4& plane : frustum.planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	return frustum;
+}
+
+bool isSphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius) {
+	for (const glm::vec4& plane : frustum.planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
 
+	return true;
+}
+
+void recordImageLayoutTransition(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevel) {
 	VkImageMemoryBarrier barrier{};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	barrier.oldLayout = oldLayout;
@@ -197,7 +283,7 @@ void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayo
 
 	barrier.image = image;
 	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.baseMipLevel = mipLevel;
 	barrier.subresourceRange.levelCount = 1;
 	barrier.subresourceRange.baseArrayLayer = 0;
 	barrier.subresourceRange.layerCount = 1;
@@ -223,7 +309,7 @@ void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayo
 		destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 	} else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
 		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT; // from
-		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT; // to
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT; // to
 
 		sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 		destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
@@ -245,20 +331,16 @@ void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayo
 		0, nullptr,
 		0, nullptr,
 		1, &barrier);
-
-	endSingleTimeCommands(commandBuffer, commandPool, logicalDevice, graphicsQueue);
 }
 
-void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDevice logicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue) {
-	VkCommandBuffer commandBuffer = beginSingleTimeCommands(logicalDevice, commandPool);
-
+void recordCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevel) {
 	VkBufferImageCopy region{};
-	region.bufferOffset = 0;
+	region.bufferOffset = bufferOffset;
 	region.bufferRowLength = 0;
 	region.bufferImageHeight = 0;
 
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.mipLevel = mipLevel;
 	region.imageSubresource.baseArrayLayer = 0;
 	region.imageSubresource.layerCount = 1;
 
@@ -267,45 +349,10 @@ void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t
 
 	vkCmdCopyBufferToImage(commandBuffer, buffer, image,
 		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	endSingleTimeCommands(commandBuffer, commandPool, logicalDevice, graphicsQueue);
 }
 
-VkCommandBuffer beginSingleTimeCommands(VkDevice logicalDevice, VkCommandPool commandPool) {
-	VkCommandBufferAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool = commandPool;
-	allocInfo.commandBufferCount = 1;
-
-	VkCommandBuffer commandBuffer;
-	vkAllocateCommandBuffers(logicalDevice, &allocInfo, &commandBuffer);
-
-	VkCommandBufferBeginInfo beginInfo{};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-	vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-	return commandBuffer;
-}
-
-void endSingleTimeCommands(VkCommandBuffer commandBuffer, VkCommandPool commandPool, VkDevice logicalDevice, VkQueue graphicsQueue) {
-	vkEndCommandBuffer(commandBuffer);
-
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer;
-
-	vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(graphicsQueue);
-
-	vkFreeCommandBuffers(logicalDevice, commandPool, 1, &commandBuffer);
-}
-
-void createBuffer(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage,
-	VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+void createBuffer(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& bufferAllocation) {
 	VkBufferCreateInfo bufferInfo{};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size = size;
@@ -319,16 +366,15 @@ void createBuffer(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkDev
 	VkMemoryRequirements memRequirements;
 	vkGetBufferMemoryRequirements(logicalDevice, buffer, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
+	bufferAllocation = allocator.allocate(memRequirements, properties, false);
 
-	if (vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to Allocate Vertex Buffer Memory");
-	}
+	vkBindBufferMemory(logicalDevice, buffer, bufferAllocation.memory, bufferAllocation.offset);
+}
 
-	vkBindBufferMemory(logicalDevice, buffer, bufferMemory, 0);
+void destroyBuffer(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkBuffer& buffer, MemoryAllocation& bufferAllocation) {
+	vkDestroyBuffer(logicalDevice, buffer, nullptr);
+	allocator.free(bufferAllocation);
+	buffer = VK_NULL_HANDLE;
 }
 
 uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
@@ -352,6 +398,15 @@ VkFormat findDepthFormat(VkPhysicalDevice physicalDevice) {
 	);
 }
 
+// what vkCmdBlitImage with VK_FILTER_LINEAR needs to build a mip chain in place
+bool supportsLinearBlit(VkPhysicalDevice physicalDevice, VkFormat format) {
+	VkFormatProperties props;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+
+	VkFormatFeatureFlags features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	return (props.optimalTilingFeatures & features) == features;
+}
+
 VkFormat findSupportedFormat(VkPhysicalDevice physicalDevice, const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
 	for (VkFormat format : candidates) {
 		VkFormatProperties props;
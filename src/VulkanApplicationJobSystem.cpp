@@ -0,0 +1,464 @@
+#include "headers/VulkanApplicationJobSystem.h"
+#include <chrono>
+
+// which system and deque the current thread works for, threads outside every system use deque 0
+static thread_local VulkanApplicationJobSystem* currentJobSystem = nullptr;
+static thread_local uint32_t currentWorkerIndex = 0;
+
+VulkanApplicationJobSystem::VulkanApplicationJobSystem(uint32_t threadCount) {
+	this->threadCount = threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+
+	for (uint32_t i = 0; i < this->threadCount; i++) {
+		queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	// the creating thread is worker 0 and only runs jobs while it waits
+	for (uint32_t i = 1; i < this->threadCount; i++) {
+		workers.emplace_back(&VulkanApplicationJobSystem::workerLoop, this, i);
+	}
+}
+
+VulkanApplicationJobSystem::~VulkanApplicationJobSystem() {
+	cleanup();
+}
+
+// queued jobs that never started are dropped
+void VulkanApplicationJobSystem::cleanup() {
+	if (!running.exchange(false)) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wakeCondition.notify_all();
+	}
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	workers.clear();
+}
+
+void VulkanApplicationJobSystem::workerLoop(uint32_t workerIndex) {
+	currentJobSystem = this;
+	currentWorkerIndex = workerIndex;
+	uint32_t idleRounds = 0;
+
+	while (running) {
+		if (runOne(workerIndex, true)) {
+			idleRounds = 0;
+			continue;
+		}
+
+		if (++idleRounds < kJOB_SPIN_COUNT) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		// counted as sleeping before checking for work, push() checks the count after queuing, so one of them always sees the other
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers++;
+		wakeCondition.wait(lock, [this]() { return !running || queuedJobs > 0; });
+		sleepingWorkers--;
+		idleRounds = 0;
+	}
+}
+
+uint32_t VulkanApplicationJobSystem::getCurrentWorker() {
+	return currentJobSystem == this ? currentWorkerIndex : 0;
+}
+
+void VulkanApplicationJobSystem::push(const std::shared_ptr<Job>& job) {
+	WorkerQueue& queue = job->background ? backgroundQueue : *queues[getCurrentWorker()];
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+
+	queuedJobs++;
+
+	if (sleepingWorkers > 0) {
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wakeCondition.notify_one();
+	}
+}
+
+// newest job from the worker's own deque, otherwise the oldest one from the next deque that has any, background jobs last
+std::shared_ptr<Job> VulkanApplicationJobSystem::pop(uint32_t workerIndex, bool background) {
+	std::shared_ptr<Job> job;
+
+	for (uint32_t i = 0; i < threadCount && !job; i++) {
+		WorkerQueue& queue = *queues[(workerIndex + i) % threadCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.jobs.empty()) {
+			continue;
+		}
+
+		if (i == 0) {
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		} else {
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			jobsStolen.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (!job && background) {
+		std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+
+		if (!backgroundQueue.jobs.empty()) {
+			job = std::move(backgroundQueue.jobs.front());
+			backgroundQueue.jobs.pop_front();
+		}
+	}
+
+	if (job) {
+		queuedJobs--;
+	}
+
+	return job;
+}
+
+bool VulkanApplicationJobSystem::runOne(uint32_t workerIndex, bool background) {
+	std::shared_ptr<Job> job = pop(workerIndex, background);
+
+	if (!job) {
+		return false;
+	}
+
+	execute(job);
+	return true;
+}
+
+void VulkanApplicationJobSystem::execute(const std::shared_ptr<Job>& job) {
+	bool dependencyFailed;
+
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		dependencyFailed = job->error != nullptr;
+	}
+
+	if (!dependencyFailed) {
+		try {
+			job->function();
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(job->mutex);
+			job->error = std::current_exception();
+		}
+	}
+
+	job->function = nullptr; // let go of whatever it captured
+
+	std::vector<std::shared_ptr<Job>> continuations;
+	std::exception_ptr error;
+
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->finished = true;
+		continuations.swap(job->continuations);
+		error = job->error;
+	}
+
+	jobsExecuted.fetch_add(1, std::memory_order_relaxed);
+
+	for (std::shared_ptr<Job>& continuation : continuations) {
+		if (error) {
+			std::lock_guard<std::mutex> lock(continuation->mutex);
+
+			if (!continuation->error) {
+				continuation->error = error;
+			}
+		}
+
+		if (continuation->unfinishedDependencies.fetch_sub(1) == 1) {
+			push(continuation);
+		}
+	}
+}
+
+JobHandle VulkanApplicationJobSystem::schedule(std::function<void()> function, const std::vector<JobHandle>& dependencies) {
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->function = std::move(function);
+	return submit(job, dependencies);
+}
+
+// for long jobs the frame loop doesn't wait on, see the top of the header
+JobHandle VulkanApplicationJobSystem::scheduleBackground(std::function<void()> function, const std::vector<JobHandle>& dependencies) {
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->function = std::move(function);
+	job->background = true;
+	return submit(job, dependencies);
+}
+
+JobHandle VulkanApplicationJobSystem::submit(const std::shared_ptr<Job>& job, const std::vector<JobHandle>& dependencies) {
+	for (const JobHandle& dependency : dependencies) {
+		if (!dependency.job) {
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(dependency.job->mutex);
+
+		if (!dependency.job->finished) {
+			job->unfinishedDependencies++;
+			dependency.job->continuations.push_back(job);
+		} else if (dependency.job->error) {
+			std::lock_guard<std::mutex> jobLock(job->mutex);
+
+			if (!job->error) {
+				job->error = dependency.job->error;
+			}
+		}
+	}
+
+	// drops the guard taken at creation, whichever dependency finishes last queues it otherwise
+	if (job->unfinishedDependencies.fetch_sub(1) == 1) {
+		push(job);
+	}
+
+	return { job };
+}
+
+void VulkanApplicationJobSystem::wait(const JobHandle& handle) {
+	if (!handle.job) {
+		return;
+	}
+
+	uint32_t workerIndex = getCurrentWorker();
+	// background work is only taken while blocked on some anyway, a frame job waiting on its chunks mustn't pick up a compile
+	bool background = handle.job->background;
+
+	while (!handle.job->finished) {
+		if (!runOne(workerIndex, background)) {
+			std::this_thread::yield();
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(handle.job->mutex);
+
+	if (handle.job->error) {
+		std::rethrow_exception(handle.job->error);
+	}
+}
+
+bool VulkanApplicationJobSystem::isFinished(const JobHandle& handle) {
+	return !handle.job || handle.job->finished;
+}
+
+// function gets called once per chunk of grainSize indices (the last one may be shorter), in no particular order
+void VulkanApplicationJobSystem::parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t first, uint32_t last)>& function) {
+	grainSize = std::max(grainSize, 1u);
+	uint32_t chunkCount = count / grainSize + (count % grainSize != 0);
+
+	if (chunkCount <= 1 || threadCount == 1) {
+		for (uint32_t first = 0; first < count; first += grainSize) {
+			function(first, std::min(count, first + grainSize));
+		}
+
+		return;
+	}
+
+	std::atomic<uint32_t> nextChunk{ 0 };
+	auto runChunks = [&]() {
+		for (uint32_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+			uint32_t first = chunk * grainSize;
+			function(first, std::min(count, first + grainSize));
+		}
+	};
+
+	std::vector<JobHandle> runners;
+
+	for (uint32_t i = 1; i < std::min(threadCount, chunkCount); i++) {
+		runners.push_back(schedule(runChunks));
+	}
+
+	std::exception_ptr error;
+
+	try {
+		runChunks();
+	} catch (...) {
+		error = std::current_exception();
+		nextChunk = chunkCount; // nobody starts another chunk
+	}
+
+	// runners reference this stack frame, every one of them has to be done before returning
+	for (JobHandle& runner : runners) {
+		try {
+			wait(runner);
+		} catch (...) {
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+uint32_t VulkanApplicationJobSystem::getThreadCount() {
+	return this->threadCount;
+}
+
+JobSystemStats VulkanApplicationJobSystem::getStats() {
+	return { jobsExecuted.load(), jobsStolen.load() };
+}
+
+VulkanApplicationJobSystem& getJobSystem() {
+	static VulkanApplicationJobSystem jobSystem;
+	return jobSystem;
+}
+
+/***** BENCHMARK *****/
+
+// a few rounds of integer mixing so a job or chunk has some work that can't be optimized away
+static uint64_t mixWork(uint64_t value) {
+	for (int i = 0; i < 8; i++) {
+		value ^= value >> 33;
+		value *= 0xff51afd7ed558ccdull;
+	}
+
+	return value;
+}
+
+static double secondsSince(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static void benchmarkThreadCount(uint32_t threadCount, uint32_t jobCount, double serialForSeconds, uint64_t serialSum) {
+	VulkanApplicationJobSystem jobSystem(threadCount);
+	cout << "  " << threadCount << (threadCount == 1 ? " thread" : " threads") << endl;
+
+	// throughput, lots of tiny independent jobs scheduled from outside the workers
+	std::vector<uint64_t> results(jobCount);
+	std::vector<JobHandle> handles(jobCount);
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < jobCount; i++) {
+		handles[i] = jobSystem.schedule([&results, i]() { results[i] = mixWork(i); });
+	}
+
+	for (JobHandle& handle : handles) {
+		jobSystem.wait(handle);
+	}
+
+	double seconds = secondsSince(start);
+	handles.clear();
+	cout << "    Independent jobs: " << jobCount / seconds / 1e6 << " M jobs/s, " << seconds * 1e9 / jobCount << " ns per job" << endl;
+
+	for (uint32_t i = 0; i < jobCount; i++) {
+		if (results[i] != mixWork(i)) {
+			throw std::runtime_error("Job Results Are Wrong");
+		}
+	}
+
+	// dependencies, every job waits on the one before it so nothing runs in parallel
+	uint32_t chainLength = std::max(1u, jobCount / 100);
+	std::atomic<uint32_t> chainPosition{ 0 };
+	std::atomic<bool> chainInOrder{ true };
+	JobHandle previous;
+	start = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < chainLength; i++) {
+		previous = jobSystem.schedule([&chainPosition, &chainInOrder, i]() {
+			if (chainPosition++ != i) {
+				chainInOrder = false;
+			}
+		}, { previous });
+	}
+
+	jobSystem.wait(previous);
+	seconds = secondsSince(start);
+	cout << "    Dependency chain: " << seconds * 1e9 / chainLength << " ns per link over " << chainLength << " jobs" << endl;
+
+	if (!chainInOrder) {
+		throw std::runtime_error("Dependent Jobs Ran Out of Order");
+	}
+
+	// parallelFor over the same mixing, summed per chunk
+	uint32_t forCount = jobCount * 16;
+	std::atomic<uint64_t> sum{ 0 };
+	start = std::chrono::high_resolution_clock::now();
+
+	jobSystem.parallelFor(forCount, 16384, [&sum](uint32_t first, uint32_t last) {
+		uint64_t chunkSum = 0;
+
+		for (uint32_t i = first; i < last; i++) {
+			chunkSum += mixWork(i);
+		}
+
+		sum += chunkSum;
+	});
+
+	seconds = secondsSince(start);
+	cout << "    parallelFor: " << seconds * 1e3 << " ms for " << forCount << " items, " << serialForSeconds / seconds << "x the serial loop" << endl;
+
+	if (sum != serialSum) {
+		throw std::runtime_error("parallelFor Results Differ From the Serial Loop");
+	}
+
+	// latency, from schedule() on this thread until a worker starts the job, this thread spins without helping
+	if (threadCount == 1) {
+		return;
+	}
+
+	for (bool sleeping : { false, true }) {
+		std::vector<double> latencies;
+
+		for (int i = 0; i < 200; i++) {
+			if (sleeping) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(2)); // long enough for every worker to give up spinning
+			}
+
+			std::atomic<bool> started{ false };
+			std::chrono::high_resolution_clock::time_point startTime;
+			auto scheduleTime = std::chrono::high_resolution_clock::now();
+			JobHandle handle = jobSystem.schedule([&]() {
+				startTime = std::chrono::high_resolution_clock::now();
+				started = true;
+			});
+
+			while (!started) {
+				std::this_thread::yield();
+			}
+
+			jobSystem.wait(handle);
+			latencies.push_back(std::chrono::duration<double>(startTime - scheduleTime).count());
+		}
+
+		std::sort(latencies.begin(), latencies.end());
+		cout << "    Start latency, workers " << (sleeping ? "asleep" : "spinning") << ": median " << latencies[latencies.size() / 2] * 1e6
+			<< " us, 99th percentile " << latencies[latencies.size() * 99 / 100] * 1e6 << " us" << endl;
+	}
+
+	JobSystemStats stats = jobSystem.getStats();
+	cout << "    " << stats.jobsExecuted << " jobs executed, " << stats.jobsStolen << " stolen" << endl;
+}
+
+// 1, 2, 4... threads up to one per core
+void runJobSystemBenchmark(uint32_t jobCount) {
+	uint32_t coreCount = std::max(1u, std::thread::hardware_concurrency());
+	uint32_t forCount = jobCount * 16;
+	uint64_t serialSum = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < forCount; i++) {
+		serialSum += mixWork(i);
+	}
+
+	double serialForSeconds = secondsSince(start);
+	cout << "Job System Benchmark: " << jobCount << " jobs, " << coreCount << " cores, serial loop over " << forCount << " items took "
+		<< serialForSeconds * 1e3 << " ms" << endl;
+
+	for (uint32_t threadCount = 1; ; threadCount = std::min(threadCount * 2, coreCount)) {
+		benchmarkThreadCount(threadCount, jobCount, serialForSeconds, serialSum);
+
+		if (threadCount == coreCount) {
+			break;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,301 @@
+#include "headers/VulkanApplicationMemoryAllocator.h"
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// true if the last byte of resource a and the first byte of resource b land on the same granularity page
+static bool onSamePage(VkDeviceSize aOffset, VkDeviceSize aSize, VkDeviceSize bOffset, VkDeviceSize pageSize) {
+	VkDeviceSize aEndPage = (aOffset + aSize - 1) & ~(pageSize - 1);
+	VkDeviceSize bStartPage = bOffset & ~(pageSize - 1);
+	return aEndPage == bStartPage;
+}
+
+VulkanApplicationMemoryAllocator::VulkanApplicationMemoryAllocator(VkDevice logicalDevice, VkPhysicalDevice physicalDevice) {
+	this->logicalDevice = logicalDevice;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	bufferImageGranularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+}
+
+VulkanApplicationMemoryAllocator::~VulkanApplicationMemoryAllocator() {}
+
+void VulkanApplicationMemoryAllocator::cleanup() {
+	if (debug) { printStats(); }
+
+	if (debug && stats.allocationCount != 0) {
+		cerr << "Memory Allocator: " << stats.allocationCount << " Allocations Leaked" << endl;
+	}
+
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		if (blocks[i] != nullptr) {
+			destroyBlock(i);
+		}
+	}
+
+	blocks.clear();
+}
+
+VkDeviceSize VulkanApplicationMemoryAllocator::getBlockSize(uint32_t memoryTypeIndex) {
+	// small heaps (integrated gpus, the 256MB BAR heap) get smaller blocks so one block doesn't eat the heap
+	VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+	return std::min(kDEFAULT_BLOCK_SIZE, alignUp(heapSize / 8, 1024 * 1024));
+}
+
+uint32_t VulkanApplicationMemoryAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated) {
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory;
+	if (vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+		return UINT32_MAX;
+	}
+
+	auto block = std::make_unique<MemoryBlock>();
+	block->memory = memory;
+	block->size = size;
+	block->freeBytes = size;
+	block->memoryTypeIndex = memoryTypeIndex;
+	block->dedicated = dedicated;
+	block->ranges.push_back({ 0, size, RangeType::kFree });
+
+	// host visible blocks stay mapped for their whole life, allocations get a pointer into the mapping
+	if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		if (vkMapMemory(logicalDevice, memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+			vkFreeMemory(logicalDevice, memory, nullptr);
+			throw std::runtime_error("Failed to Map Memory Block");
+		}
+	}
+
+	stats.deviceAllocationCalls++;
+	stats.bytesReserved += size;
+	if (dedicated) {
+		stats.dedicatedCount++;
+	} else {
+		stats.blockCount++;
+	}
+
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		if (blocks[i] == nullptr) {
+			blocks[i] = std::move(block);
+			return i;
+		}
+	}
+
+	blocks.push_back(std::move(block));
+	return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void VulkanApplicationMemoryAllocator::destroyBlock(uint32_t blockIndex) {
+	MemoryBlock& block = *blocks[blockIndex];
+
+	if (block.mapped != nullptr) {
+		vkUnmapMemory(logicalDevice, block.memory);
+	}
+	vkFreeMemory(logicalDevice, block.memory, nullptr);
+
+	stats.bytesReserved -= block.size;
+	if (block.dedicated) {
+		stats.dedicatedCount--;
+	} else {
+		stats.blockCount--;
+	}
+
+	blocks[blockIndex].reset();
+}
+
+bool VulkanApplicationMemoryAllocator::conflictsWithGranularity(RangeType a, RangeType b) {
+	if (bufferImageGranularity == 1 || a == RangeType::kFree || b == RangeType::kFree) {
+		return false;
+	}
+	return a != b;
+}
+
+bool VulkanApplicationMemoryAllocator::tryAllocateFromBlock(uint32_t blockIndex, const VkMemoryRequirements& requirements, RangeType type, MemoryAllocation& allocation) {
+	MemoryBlock& block = *blocks[blockIndex];
+
+	if (block.freeBytes < requirements.size) {
+		return false;
+	}
+
+	for (size_t i = 0; i < block.ranges.size(); i++) {
+		const MemoryRange range = block.ranges[i];
+
+		if (range.type != RangeType::kFree || range.size < requirements.size) {
+			continue;
+		}
+
+		VkDeviceSize offset = alignUp(range.offset, requirements.alignment);
+
+		// free ranges are always merged, so the neighbours of a free range are in use
+		if (i > 0) {
+			const MemoryRange& previous = block.ranges[i - 1];
+			if (conflictsWithGranularity(previous.type, type) && onSamePage(previous.offset, previous.size, offset, bufferImageGranularity)) {
+				offset = alignUp(offset, bufferImageGranularity);
+			}
+		}
+
+		if (offset + requirements.size > range.offset + range.size) {
+			continue;
+		}
+
+		if (i + 1 < block.ranges.size()) {
+			const MemoryRange& next = block.ranges[i + 1];
+			if (conflictsWithGranularity(next.type, type) && onSamePage(offset, requirements.size, next.offset, bufferImageGranularity)) {
+				continue;
+			}
+		}
+
+		// split the free range into [padding][allocation][remainder]
+		VkDeviceSize padding = offset - range.offset;
+		VkDeviceSize remainder = (range.offset + range.size) - (offset + requirements.size);
+
+		std::vector<MemoryRange> replacement;
+		if (padding > 0) { replacement.push_back({ range.offset, padding, RangeType::kFree }); }
+		replacement.push_back({ offset, requirements.size, type });
+		if (remainder > 0) { replacement.push_back({ offset + requirements.size, remainder, RangeType::kFree }); }
+
+		block.ranges.erase(block.ranges.begin() + i);
+		block.ranges.insert(block.ranges.begin() + i, replacement.begin(), replacement.end());
+		block.freeBytes -= requirements.size;
+
+		allocation.memory = block.memory;
+		allocation.offset = offset;
+		allocation.size = requirements.size;
+		allocation.memoryTypeIndex = block.memoryTypeIndex;
+		allocation.blockIndex = blockIndex;
+		allocation.mapped = block.mapped != nullptr ? static_cast<char*>(block.mapped) + offset : nullptr;
+		return true;
+	}
+
+	return false;
+}
+
+MemoryAllocation VulkanApplicationMemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool optimalTiling) {
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	MemoryAllocation allocation{};
+	RangeType type = optimalTiling ? RangeType::kOptimal : RangeType::kLinear;
+
+	// memory types are ordered by preference, so walk every type that satisfies the request
+	// and only fall through to the next one if a new block can't be created in this one
+	for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < memoryProperties.memoryTypeCount; memoryTypeIndex++) {
+		if (!(requirements.memoryTypeBits & (1 << memoryTypeIndex)) ||
+			(memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & properties) != properties) {
+			continue;
+		}
+
+		VkDeviceSize blockSize = getBlockSize(memoryTypeIndex);
+		uint32_t blockIndex = UINT32_MAX;
+
+		if (requirements.size > blockSize / 2) {
+			// large resources get their own allocation instead of fragmenting a block
+			blockIndex = createBlock(memoryTypeIndex, requirements.size, true);
+		} else {
+			for (uint32_t i = 0; i < blocks.size(); i++) {
+				if (blocks[i] != nullptr && !blocks[i]->dedicated && blocks[i]->memoryTypeIndex == memoryTypeIndex &&
+					tryAllocateFromBlock(i, requirements, type, allocation)) {
+					blockIndex = i;
+					break;
+				}
+			}
+
+			if (blockIndex == UINT32_MAX) {
+				blockIndex = createBlock(memoryTypeIndex, blockSize, false);
+			}
+
+			if (blockIndex == UINT32_MAX) {
+				// heap is too full for a whole block, the resource might still fit on its own
+				blockIndex = createBlock(memoryTypeIndex, requirements.size, true);
+			}
+		}
+
+		if (blockIndex == UINT32_MAX) {
+			continue;
+		}
+
+		if (allocation.memory == VK_NULL_HANDLE && !tryAllocateFromBlock(blockIndex, requirements, type, allocation)) {
+			throw std::runtime_error("Failed to Sub-Allocate From a New Memory Block");
+		}
+
+		stats.allocationCount++;
+		stats.bytesInUse += allocation.size;
+		stats.peakAllocationCount = std::max(stats.peakAllocationCount, stats.allocationCount);
+		stats.peakBytesInUse = std::max(stats.peakBytesInUse, stats.bytesInUse);
+		return allocation;
+	}
+
+	throw std::runtime_error("Failed to Allocate Device Memory");
+}
+
+void VulkanApplicationMemoryAllocator::free(MemoryAllocation& allocation) {
+	if (allocation.memory == VK_NULL_HANDLE) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	MemoryBlock& block = *blocks[allocation.blockIndex];
+	std::vector<MemoryRange>& ranges = block.ranges;
+
+	auto it = std::lower_bound(ranges.begin(), ranges.end(), allocation.offset,
+		[](const MemoryRange& range, VkDeviceSize offset) { return range.offset < offset; });
+
+	if (it == ranges.end() || it->offset != allocation.offset || it->type == RangeType::kFree) {
+		throw std::runtime_error("Freeing Memory That was not Allocated");
+	}
+
+	it->type = RangeType::kFree;
+	block.freeBytes += it->size;
+
+	stats.allocationCount--;
+	stats.bytesInUse -= allocation.size;
+
+	// merge with the following and preceding free ranges
+	if (it + 1 != ranges.end() && (it + 1)->type == RangeType::kFree) {
+		it->size += (it + 1)->size;
+		it = ranges.erase(it + 1) - 1;
+	}
+
+	if (it != ranges.begin() && (it - 1)->type == RangeType::kFree) {
+		(it - 1)->size += it->size;
+		ranges.erase(it);
+	}
+
+	if (block.freeBytes == block.size) {
+		// keep one empty block around per memory type so alloc/free churn doesn't hit the driver
+		bool otherEmptyBlock = false;
+		for (uint32_t i = 0; i < blocks.size(); i++) {
+			if (i != allocation.blockIndex && blocks[i] != nullptr && !blocks[i]->dedicated &&
+				blocks[i]->memoryTypeIndex == block.memoryTypeIndex && blocks[i]->freeBytes == blocks[i]->size) {
+				otherEmptyBlock = true;
+				break;
+			}
+		}
+
+		if (block.dedicated || otherEmptyBlock) {
+			destroyBlock(allocation.blockIndex);
+		}
+	}
+
+	allocation = MemoryAllocation{};
+}
+
+MemoryAllocatorStats VulkanApplicationMemoryAllocator::getStats() {
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	return stats;
+}
+
+void VulkanApplicationMemoryAllocator::printStats() {
+	MemoryAllocatorStats current = getStats();
+
+	cout << "Memory Allocator: " << current.allocationCount << " live allocations (peak " << current.peakAllocationCount << ")" << endl;
+	cout << "  in use: " << current.bytesInUse / 1024 << " KiB (peak " << current.peakBytesInUse / 1024 << " KiB)" << endl;
+	cout << "  reserved: " << current.bytesReserved / 1024 << " KiB in " << current.blockCount << " blocks + "
+		<< current.dedicatedCount << " dedicated" << endl;
+	cout << "  vkAllocateMemory calls: " << current.deviceAllocationCalls << endl;
+}
\ No newline at end of file
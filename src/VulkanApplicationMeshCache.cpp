@@ -0,0 +1,286 @@
+#include "headers/VulkanApplicationMeshCache.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char kMESH_CACHE_MAGIC[4] = { 'V', 'M', 'S', 'H' };
+
+static VkDeviceSize alignOffset(VkDeviceSize offset) {
+	return (offset + kMESH_CACHE_ALIGNMENT - 1) & ~(kMESH_CACHE_ALIGNMENT - 1);
+}
+
+static double secondsSince(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool mapFile(const std::string& path, MappedFile& file) {
+	file = MappedFile{};
+
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr) {
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr) {
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	file.fileHandle = fileHandle;
+	file.mappingHandle = mappingHandle;
+	file.size = static_cast<size_t>(size.QuadPart);
+#else
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+		close(descriptor);
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (data == MAP_FAILED) {
+		close(descriptor);
+		return false;
+	}
+
+	// the whole file gets read front to back either way
+	madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+
+	file.descriptor = descriptor;
+	file.size = static_cast<size_t>(status.st_size);
+#endif
+
+	file.data = static_cast<const char*>(data);
+	return true;
+}
+
+void unmapFile(MappedFile& file) {
+	if (file.data == nullptr) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(file.data);
+	CloseHandle(file.mappingHandle);
+	CloseHandle(file.fileHandle);
+#else
+	munmap(const_cast<char*>(file.data), file.size);
+	close(file.descriptor);
+#endif
+
+	file = MappedFile{};
+}
+
+// 64 bit words through a multiply/rotate mix, the source is hashed on every launch so this has to be fast
+uint64_t hashSourceFile(const std::string& path) {
+	MappedFile file;
+	if (!mapFile(path, file)) {
+		throw std::runtime_error("Failed to Open Mesh Source");
+	}
+
+	const uint64_t kPRIME = 0x9E3779B97F4A7C15ull;
+	uint64_t hash = file.size * kPRIME;
+	size_t wordCount = file.size / sizeof(uint64_t);
+
+	for (size_t i = 0; i < wordCount; i++) {
+		uint64_t word;
+		memcpy(&word, file.data + i * sizeof(uint64_t), sizeof(uint64_t));
+		hash = (hash ^ word) * kPRIME;
+		hash = (hash << 31) | (hash >> 33);
+	}
+
+	uint64_t tail = 0;
+	memcpy(&tail, file.data + wordCount * sizeof(uint64_t), file.size - wordCount * sizeof(uint64_t));
+	hash = (hash ^ tail) * kPRIME;
+
+	unmapFile(file);
+
+	return hash ^ (hash >> 29);
+}
+
+std::string getMeshCachePath(const std::string& sourcePath) {
+	return sourcePath + ".meshcache";
+}
+
+bool openMeshCache(const std::string& path, uint64_t sourceHash, MeshCacheView& cache) {
+	cache = MeshCacheView{};
+
+	if (!mapFile(path, cache.file)) {
+		return false;
+	}
+
+	if (cache.file.size < sizeof(MeshCacheHeader)) {
+		closeMeshCache(cache);
+		return false;
+	}
+
+	const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(cache.file.data);
+	VertexFormat vertexFormat = static_cast<VertexFormat>(header->vertexFormat);
+	VkDeviceSize indexSize = header->indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	// anything stale or truncated is treated like a missing cache
+	bool valid = memcmp(header->magic, kMESH_CACHE_MAGIC, sizeof(kMESH_CACHE_MAGIC)) == 0 &&
+		header->version == kMESH_CACHE_VERSION &&
+		header->sourceHash == sourceHash &&
+		vertexFormat < VertexFormat::kCount &&
+		header->vertexStride == getVertexStride(vertexFormat) &&
+		(header->indexType == VK_INDEX_TYPE_UINT16 || header->indexType == VK_INDEX_TYPE_UINT32) &&
+		header->lodCount > 0 &&
+		header->lodCount <= kMAX_MESH_LODS &&
+		header->lodOffset + header->lodCount * sizeof(MeshLod) <= cache.file.size &&
+		header->vertexOffset + header->vertexCount * header->vertexStride <= cache.file.size &&
+		header->indexOffset + header->indexCount * indexSize <= cache.file.size;
+
+	// every lod has to be a range of the index blob, the draws read exactly that range
+	for (uint32_t i = 0; valid && i < header->lodCount; i++) {
+		MeshLod lod;
+		memcpy(&lod, cache.file.data + header->lodOffset + i * sizeof(MeshLod), sizeof(MeshLod));
+		valid = lod.indexCount > 0 && static_cast<uint64_t>(lod.firstIndex) + lod.indexCount <= header->indexCount;
+	}
+
+	if (!valid) {
+		closeMeshCache(cache);
+		return false;
+	}
+
+	cache.header = header;
+	cache.vertices = cache.file.data + header->vertexOffset;
+	cache.indices = cache.file.data + header->indexOffset;
+	cache.lods = reinterpret_cast<const MeshLod*>(cache.file.data + header->lodOffset);
+	cache.vertexBytes = header->vertexCount * header->vertexStride;
+	cache.indexBytes = header->indexCount * indexSize;
+
+	return true;
+}
+
+void closeMeshCache(MeshCacheView& cache) {
+	unmapFile(cache.file);
+	cache = MeshCacheView{};
+}
+
+void writeMeshCache(const std::string& path, const Mesh& mesh, uint64_t sourceHash) {
+	MeshCacheHeader header{};
+	memcpy(header.magic, kMESH_CACHE_MAGIC, sizeof(kMESH_CACHE_MAGIC));
+	header.version = kMESH_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.vertexStride = getVertexStride(mesh.vertexFormat);
+	header.vertexFormat = static_cast<uint32_t>(mesh.vertexFormat);
+	header.indexType = mesh.indexType;
+	header.vertexCount = mesh.vertices.size();
+	header.indexCount = mesh.indices.size();
+	header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+	header.lodOffset = alignOffset(sizeof(MeshCacheHeader));
+	header.vertexOffset = alignOffset(header.lodOffset + header.lodCount * sizeof(MeshLod));
+	header.indexOffset = alignOffset(header.vertexOffset + header.vertexCount * header.vertexStride);
+	memcpy(header.boundsMin, &mesh.boundsMin, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, &mesh.boundsMax, sizeof(header.boundsMax));
+
+	// vertices and indices are written in their final form so loading never has to touch them
+	std::vector<char> file(header.indexOffset + header.indexCount * mesh.getIndexSize(), 0);
+	memcpy(file.data(), &header, sizeof(header));
+	memcpy(file.data() + header.lodOffset, mesh.lods.data(), header.lodCount * sizeof(MeshLod));
+	encodeVertices(mesh.vertices, mesh.vertexFormat, mesh.getVertexQuantization(), file.data() + header.vertexOffset);
+
+	if (mesh.indexType == VK_INDEX_TYPE_UINT16) {
+		uint16_t* indices = reinterpret_cast<uint16_t*>(file.data() + header.indexOffset);
+		for (size_t i = 0; i < mesh.indices.size(); i++) {
+			indices[i] = static_cast<uint16_t>(mesh.indices[i]);
+		}
+	} else {
+		memcpy(file.data() + header.indexOffset, mesh.indices.data(), header.indexCount * sizeof(uint32_t));
+	}
+
+	if (!writeFileAtomically(path, file.data(), file.size()) && debug) {
+		cout << "Failed to write mesh cache " << path << endl;
+	}
+}
+
+// the same steps the buffer manager takes at startup, minus the gpu copy. staging memory is stood in for by a heap buffer
+void runMeshCacheBenchmark(const std::string& sourcePath) {
+	const int kWARM_RUNS = 10;
+	std::string cachePath = getMeshCachePath(sourcePath);
+	std::error_code error;
+	std::filesystem::remove(cachePath, error);
+
+	std::vector<char> staging;
+
+	auto coldStart = std::chrono::high_resolution_clock::now();
+	uint64_t sourceHash = hashSourceFile(sourcePath);
+	Mesh mesh = loadObjMesh(sourcePath);
+	generateMeshLods(mesh);
+	optimizeMesh(mesh);
+	writeMeshCache(cachePath, mesh, sourceHash);
+
+	VkDeviceSize vertexBytes = mesh.vertices.size() * getVertexStride(mesh.vertexFormat);
+	staging.resize(vertexBytes + mesh.indices.size() * mesh.getIndexSize());
+	encodeVertices(mesh.vertices, mesh.vertexFormat, mesh.getVertexQuantization(), staging.data());
+	char* stagingIndices = staging.data() + vertexBytes;
+	for (size_t i = 0; i < mesh.indices.size(); i++) {
+		if (mesh.indexType == VK_INDEX_TYPE_UINT16) {
+			reinterpret_cast<uint16_t*>(stagingIndices)[i] = static_cast<uint16_t>(mesh.indices[i]);
+		} else {
+			reinterpret_cast<uint32_t*>(stagingIndices)[i] = mesh.indices[i];
+		}
+	}
+	double coldSeconds = secondsSince(coldStart);
+
+	double warmBest = std::numeric_limits<double>::max();
+	double warmTotal = 0.0;
+	double hashTotal = 0.0;
+
+	for (int run = 0; run < kWARM_RUNS; run++) {
+		auto warmStart = std::chrono::high_resolution_clock::now();
+		uint64_t warmHash = hashSourceFile(sourcePath);
+		hashTotal += secondsSince(warmStart);
+
+		MeshCacheView cache;
+		if (!openMeshCache(cachePath, warmHash, cache)) {
+			throw std::runtime_error("Mesh Cache Was Not Written");
+		}
+
+		memcpy(staging.data(), cache.vertices, cache.vertexBytes);
+		memcpy(staging.data() + cache.vertexBytes, cache.indices, cache.indexBytes);
+		closeMeshCache(cache);
+
+		double seconds = secondsSince(warmStart);
+		warmBest = std::min(warmBest, seconds);
+		warmTotal += seconds;
+	}
+
+	cout << "Mesh cache benchmark: " << sourcePath << ", " << mesh.lods[0].indexCount / 3 << " triangles in " << mesh.lods.size() << " lods, "
+		<< staging.size() / 1024 << " KiB of vertex and index data" << endl;
+	cout << "  cold (parse + lods + optimize + write cache): " << coldSeconds * 1000.0 << " ms" << endl;
+	cout << "  warm (hash + map + copy):   " << warmTotal / kWARM_RUNS * 1000.0 << " ms average, " << warmBest * 1000.0
+		<< " ms best over " << kWARM_RUNS << " runs, " << hashTotal / kWARM_RUNS * 1000.0 << " ms of that hashing the source" << endl;
+	cout << "  speedup: " << coldSeconds / std::max(warmBest, 1e-9) << "x" << endl;
+}
\ No newline at end of file
@@ -0,0 +1,392 @@
+#include "headers/VulkanApplicationMeshLoader.h"
+#include "headers/VulkanApplicationJobSystem.h"
+#include <chrono>
+#include <cstring>
+
+// a face corner before the chunk offsets are known, relative indices are stored
+// against the start of the chunk and absolute ones are already 0 based
+struct ObjCorner {
+	int32_t position;
+	int32_t texCoord;
+	uint8_t flags;
+};
+
+const uint8_t kPOSITION_RELATIVE = 1;
+const uint8_t kTEXCOORD_RELATIVE = 2;
+const uint8_t kHAS_TEXCOORD = 4;
+
+// every 3 corners are a triangle, polygons are fanned while parsing
+struct ObjChunk {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> colors;
+	std::vector<glm::vec2> texCoords;
+	std::vector<ObjCorner> corners;
+};
+
+static const char* skipSpaces(const char* cursor, const char* end) {
+	while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+		cursor++;
+	}
+	return cursor;
+}
+
+static const char* nextLine(const char* cursor, const char* end) {
+	while (cursor < end && *cursor != '\n') {
+		cursor++;
+	}
+	return cursor < end ? cursor + 1 : end;
+}
+
+// strtof wants a terminated string, lines are short so a small copy is cheaper than getting that wrong
+static const char* parseFloat(const char* cursor, const char* lineEnd, float& value) {
+	cursor = skipSpaces(cursor, lineEnd);
+
+	char buffer[64];
+	size_t length = 0;
+	while (cursor + length < lineEnd && length < sizeof(buffer) - 1 &&
+		cursor[length] != ' ' && cursor[length] != '\t' && cursor[length] != '\r') {
+		buffer[length] = cursor[length];
+		length++;
+	}
+	buffer[length] = '\0';
+
+	char* parsedEnd;
+	value = std::strtof(buffer, &parsedEnd);
+	return parsedEnd == buffer ? nullptr : cursor + (parsedEnd - buffer);
+}
+
+static const char* parseInt(const char* cursor, const char* lineEnd, int32_t& value) {
+	bool negative = false;
+	if (cursor < lineEnd && (*cursor == '-' || *cursor == '+')) {
+		negative = *cursor == '-';
+		cursor++;
+	}
+
+	if (cursor >= lineEnd || *cursor < '0' || *cursor > '9') {
+		return nullptr;
+	}
+
+	int64_t result = 0;
+	while (cursor < lineEnd && *cursor >= '0' && *cursor <= '9') {
+		result = result * 10 + (*cursor - '0');
+		cursor++;
+	}
+
+	value = static_cast<int32_t>(negative ? -result : result);
+	return cursor;
+}
+
+// v, v/vt, v//vn or v/vt/vn, normals are skipped since Vertex has nowhere to put them
+static const char* parseCorner(const char* cursor, const char* lineEnd, const ObjChunk& chunk, ObjCorner& corner) {
+	int32_t index;
+	cursor = parseInt(cursor, lineEnd, index);
+	if (cursor == nullptr || index == 0) {
+		return nullptr;
+	}
+
+	corner.flags = 0;
+	if (index < 0) {
+		corner.position = static_cast<int32_t>(chunk.positions.size()) + index;
+		corner.flags |= kPOSITION_RELATIVE;
+	} else {
+		corner.position = index - 1;
+	}
+	corner.texCoord = 0;
+
+	if (cursor < lineEnd && *cursor == '/') {
+		cursor++;
+
+		if (cursor < lineEnd && *cursor != '/') {
+			cursor = parseInt(cursor, lineEnd, index);
+			if (cursor == nullptr || index == 0) {
+				return nullptr;
+			}
+
+			corner.flags |= kHAS_TEXCOORD;
+			if (index < 0) {
+				corner.texCoord = static_cast<int32_t>(chunk.texCoords.size()) + index;
+				corner.flags |= kTEXCOORD_RELATIVE;
+			} else {
+				corner.texCoord = index - 1;
+			}
+		}
+
+		if (cursor < lineEnd && *cursor == '/') {
+			cursor++;
+			int32_t normal;
+			cursor = parseInt(cursor, lineEnd, normal);
+			if (cursor == nullptr) {
+				return nullptr;
+			}
+		}
+	}
+
+	return cursor;
+}
+
+static void parseChunk(const char* begin, const char* end, ObjChunk& chunk) {
+	std::vector<ObjCorner> polygon;
+
+	for (const char* line = begin; line < end; line = nextLine(line, end)) {
+		const char* lineEnd = line;
+		while (lineEnd < end && *lineEnd != '\n') {
+			lineEnd++;
+		}
+
+		const char* cursor = skipSpaces(line, lineEnd);
+		if (cursor + 1 >= lineEnd) {
+			continue;
+		}
+
+		if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+			glm::vec3 position;
+			const char* next = cursor + 1;
+			for (int i = 0; i < 3 && next != nullptr; i++) {
+				next = parseFloat(next, lineEnd, position[i]);
+			}
+			if (next == nullptr) {
+				throw std::runtime_error("Malformed OBJ Vertex");
+			}
+
+			// some exporters append an rgb color to the position
+			glm::vec3 color(1.0f);
+			const char* colorCursor = next;
+			for (int i = 0; i < 3 && colorCursor != nullptr; i++) {
+				colorCursor = parseFloat(colorCursor, lineEnd, color[i]);
+			}
+			if (colorCursor == nullptr) {
+				color = glm::vec3(1.0f);
+			}
+
+			chunk.positions.push_back(position);
+			chunk.colors.push_back(color);
+		} else if (cursor[0] == 'v' && cursor[1] == 't') {
+			glm::vec2 texCoord;
+			const char* next = cursor + 2;
+			for (int i = 0; i < 2 && next != nullptr; i++) {
+				next = parseFloat(next, lineEnd, texCoord[i]);
+			}
+			if (next == nullptr) {
+				throw std::runtime_error("Malformed OBJ Texture Coordinate");
+			}
+
+			// obj puts v = 0 at the bottom of the image, vulkan samples from the top
+			chunk.texCoords.push_back({ texCoord.x, 1.0f - texCoord.y });
+		} else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+			polygon.clear();
+			cursor += 1;
+
+			while (true) {
+				cursor = skipSpaces(cursor, lineEnd);
+				if (cursor >= lineEnd || *cursor == '\r' || *cursor == '#') {
+					break;
+				}
+
+				ObjCorner corner;
+				cursor = parseCorner(cursor, lineEnd, chunk, corner);
+				if (cursor == nullptr) {
+					throw std::runtime_error("Malformed OBJ Face");
+				}
+				polygon.push_back(corner);
+			}
+
+			for (size_t i = 2; i < polygon.size(); i++) {
+				chunk.corners.push_back(polygon[0]);
+				chunk.corners.push_back(polygon[i - 1]);
+				chunk.corners.push_back(polygon[i]);
+			}
+		}
+		// everything else (vn, o, g, s, usemtl, mtllib, comments) has no effect on the mesh
+	}
+}
+
+// fnv-1a style mixing over the raw words, Vertex has no padding so equal vertices hash equally
+static uint64_t hashVertex(const Vertex& vertex) {
+	uint32_t words[sizeof(Vertex) / sizeof(uint32_t)];
+	memcpy(words, &vertex, sizeof(Vertex));
+
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t word : words) {
+		hash = (hash ^ word) * 1099511628211ull;
+	}
+	return hash ^ (hash >> 32);
+}
+
+// slots hold vertex index + 1 so 0 means empty
+static void rehashVertices(std::vector<uint32_t>& table, size_t tableSize, const std::vector<Vertex>& vertices) {
+	table.assign(tableSize, 0);
+	size_t tableMask = tableSize - 1;
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		size_t slot = hashVertex(vertices[i]) & tableMask;
+		while (table[slot] != 0) {
+			slot = (slot + 1) & tableMask;
+		}
+		table[slot] = static_cast<uint32_t>(i + 1);
+	}
+}
+
+static double secondsSince(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void finalizeMesh(Mesh& mesh) {
+	if (mesh.lods.empty()) {
+		mesh.lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f });
+	}
+
+	mesh.indexType = mesh.vertices.size() <= std::numeric_limits<uint16_t>::max() ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+	if (mesh.vertices.empty()) {
+		mesh.boundsMin = mesh.boundsMax = glm::vec3(0.0f);
+		mesh.vertexFormat = VertexFormat::kFloat;
+		return;
+	}
+
+	mesh.boundsMin = mesh.boundsMax = mesh.vertices[0].pos;
+	for (const Vertex& vertex : mesh.vertices) {
+		mesh.boundsMin = glm::min(mesh.boundsMin, vertex.pos);
+		mesh.boundsMax = glm::max(mesh.boundsMax, vertex.pos);
+	}
+
+	mesh.vertexFormat = selectVertexFormat(mesh.vertices, mesh.getVertexQuantization());
+}
+
+Mesh loadObjMesh(const std::string& path, MeshLoadStats* stats) {
+	static_assert(sizeof(Vertex) == sizeof(glm::vec3) * 2 + sizeof(glm::vec2), "Vertex must stay tightly packed for hashing");
+
+	MeshLoadStats localStats;
+	auto totalStart = std::chrono::high_resolution_clock::now();
+
+	std::vector<char> file = readFile(path);
+	localStats.fileBytes = file.size();
+	localStats.readSeconds = secondsSince(totalStart);
+
+	auto parseStart = std::chrono::high_resolution_clock::now();
+
+	// small files aren't worth splitting
+	const size_t kMIN_CHUNK_BYTES = 1024 * 1024;
+	VulkanApplicationJobSystem& jobSystem = getJobSystem();
+	size_t threadCount = std::max<size_t>(1, std::min<size_t>(jobSystem.getThreadCount(), file.size() / kMIN_CHUNK_BYTES));
+	localStats.threads = static_cast<uint32_t>(threadCount);
+
+	const char* data = file.data();
+	const char* dataEnd = data + file.size();
+
+	std::vector<const char*> boundaries(threadCount + 1);
+	boundaries[0] = data;
+	boundaries[threadCount] = dataEnd;
+	for (size_t i = 1; i < threadCount; i++) {
+		const char* split = data + (file.size() / threadCount) * i;
+		boundaries[i] = std::max(boundaries[i - 1], nextLine(std::max(split - 1, data), dataEnd));
+	}
+
+	std::vector<ObjChunk> chunks(threadCount);
+
+	// one chunk per job, the first parse error is rethrown here
+	jobSystem.parallelFor(static_cast<uint32_t>(threadCount), 1, [&](uint32_t first, uint32_t last) {
+		for (uint32_t i = first; i < last; i++) {
+			parseChunk(boundaries[i], boundaries[i + 1], chunks[i]);
+		}
+	});
+
+	localStats.parseSeconds = secondsSince(parseStart);
+	auto dedupStart = std::chrono::high_resolution_clock::now();
+
+	// stitch the chunks back together, relative indices need the number of elements in earlier chunks
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> colors;
+	std::vector<glm::vec2> texCoords;
+	std::vector<size_t> positionOffsets(threadCount);
+	std::vector<size_t> texCoordOffsets(threadCount);
+	size_t cornerCount = 0;
+
+	for (size_t i = 0; i < threadCount; i++) {
+		positionOffsets[i] = positions.size();
+		texCoordOffsets[i] = texCoords.size();
+		positions.insert(positions.end(), chunks[i].positions.begin(), chunks[i].positions.end());
+		colors.insert(colors.end(), chunks[i].colors.begin(), chunks[i].colors.end());
+		texCoords.insert(texCoords.end(), chunks[i].texCoords.begin(), chunks[i].texCoords.end());
+		cornerCount += chunks[i].corners.size();
+	}
+
+	Mesh mesh;
+	mesh.indices.reserve(cornerCount);
+	mesh.vertices.reserve(positions.size());
+
+	// open addressing with linear probing, sized for about one unique vertex per position and grown past half full
+	size_t tableSize = 1024;
+	while (tableSize < positions.size() * 2) {
+		tableSize <<= 1;
+	}
+	std::vector<uint32_t> table;
+	rehashVertices(table, tableSize, mesh.vertices);
+	size_t tableMask = tableSize - 1;
+
+	for (size_t i = 0; i < threadCount; i++) {
+		for (const ObjCorner& corner : chunks[i].corners) {
+			int64_t positionIndex = corner.position + ((corner.flags & kPOSITION_RELATIVE) ? static_cast<int64_t>(positionOffsets[i]) : 0);
+			if (positionIndex < 0 || positionIndex >= static_cast<int64_t>(positions.size())) {
+				throw std::runtime_error("OBJ Face References a Missing Vertex");
+			}
+
+			Vertex vertex{};
+			vertex.pos = positions[positionIndex];
+			vertex.color = colors[positionIndex];
+
+			if (corner.flags & kHAS_TEXCOORD) {
+				int64_t texCoordIndex = corner.texCoord + ((corner.flags & kTEXCOORD_RELATIVE) ? static_cast<int64_t>(texCoordOffsets[i]) : 0);
+				if (texCoordIndex < 0 || texCoordIndex >= static_cast<int64_t>(texCoords.size())) {
+					throw std::runtime_error("OBJ Face References a Missing Texture Coordinate");
+				}
+				vertex.texCoord = texCoords[texCoordIndex];
+			}
+
+			size_t slot = hashVertex(vertex) & tableMask;
+			while (table[slot] != 0 && !(mesh.vertices[table[slot] - 1] == vertex)) {
+				slot = (slot + 1) & tableMask;
+			}
+
+			if (table[slot] != 0) {
+				mesh.indices.push_back(table[slot] - 1);
+				continue;
+			}
+
+			mesh.vertices.push_back(vertex);
+			table[slot] = static_cast<uint32_t>(mesh.vertices.size());
+			mesh.indices.push_back(table[slot] - 1);
+
+			if (mesh.vertices.size() * 2 > tableSize) {
+				tableSize <<= 1;
+				tableMask = tableSize - 1;
+				rehashVertices(table, tableSize, mesh.vertices);
+			}
+		}
+	}
+
+	finalizeMesh(mesh);
+
+	localStats.dedupSeconds = secondsSince(dedupStart);
+	localStats.totalSeconds = secondsSince(totalStart);
+	localStats.triangles = mesh.indices.size() / 3;
+	localStats.sourceVertices = cornerCount;
+	localStats.uniqueVertices = mesh.vertices.size();
+	localStats.vertexFormat = mesh.vertexFormat;
+
+	if (stats != nullptr) {
+		*stats = localStats;
+	}
+
+	return mesh;
+}
+
+void printMeshLoadStats(const std::string& path, const MeshLoadStats& stats) {
+	double megabytes = stats.fileBytes / (1024.0 * 1024.0);
+
+	cout << "Loaded " << path << ": " << stats.triangles << " triangles, " << stats.uniqueVertices << " unique vertices from "
+		<< stats.sourceVertices << " corners, " << getVertexFormatName(stats.vertexFormat) << " vertex format ("
+		<< getVertexStride(stats.vertexFormat) << " bytes)" << endl;
+	cout << "  " << megabytes << " MiB in " << stats.totalSeconds * 1000.0 << " ms (" << megabytes / std::max(stats.totalSeconds, 1e-9)
+		<< " MiB/s) - read " << stats.readSeconds * 1000.0 << " ms, parse " << stats.parseSeconds * 1000.0 << " ms on "
+		<< stats.threads << " threads, dedup " << stats.dedupSeconds * 1000.0 << " ms" << endl;
+}
\ No newline at end of file
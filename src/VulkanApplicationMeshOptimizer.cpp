@@ -0,0 +1,328 @@
+#include "headers/VulkanApplicationMeshOptimizer.h"
+#include <chrono>
+
+// triangles using each vertex, stored as one flat array with per vertex offsets
+struct TriangleAdjacency {
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> triangles;
+};
+
+static void buildAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount, TriangleAdjacency& adjacency, std::vector<uint32_t>& liveCounts) {
+	liveCounts.assign(vertexCount, 0);
+	for (uint32_t index : indices) {
+		liveCounts[index]++;
+	}
+
+	adjacency.offsets.assign(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; i++) {
+		adjacency.offsets[i + 1] = adjacency.offsets[i] + liveCounts[i];
+	}
+
+	adjacency.triangles.resize(indices.size());
+	std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++) {
+		adjacency.triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+}
+
+// a vertex is in a fifo cache if fewer than cacheSize misses happened since it was loaded
+static uint32_t simulateTriangle(const uint32_t* triangle, std::vector<uint32_t>& timestamps, uint32_t& time, uint32_t cacheSize) {
+	uint32_t misses = 0;
+	for (int i = 0; i < 3; i++) {
+		if (time - timestamps[triangle[i]] >= cacheSize) {
+			timestamps[triangle[i]] = time++;
+			misses++;
+		}
+	}
+	return misses;
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	VertexCacheStats stats;
+	if (indices.empty()) {
+		return stats;
+	}
+
+	// timestamps start far enough in the past that every vertex misses the first time
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t time = cacheSize;
+	uint64_t misses = 0;
+	uint64_t uniqueVertices = 0;
+
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		misses += simulateTriangle(&indices[i], timestamps, time, cacheSize);
+	}
+
+	for (uint32_t index : indices) {
+		if (!referenced[index]) {
+			referenced[index] = true;
+			uniqueVertices++;
+		}
+	}
+
+	stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+	stats.atvr = static_cast<float>(misses) / uniqueVertices;
+	return stats;
+}
+
+// picks the candidate that will still be in the cache after its remaining triangles are emitted, oldest first
+static int64_t getNextVertex(const std::vector<uint32_t>& candidates, const std::vector<uint32_t>& liveCounts, const std::vector<uint32_t>& timestamps,
+	uint32_t time, uint32_t cacheSize, std::vector<uint32_t>& deadEnd, size_t& cursor) {
+	int64_t best = -1;
+	int64_t bestPriority = -1;
+
+	for (uint32_t vertex : candidates) {
+		if (liveCounts[vertex] == 0) {
+			continue;
+		}
+
+		int64_t priority = 0;
+		if (static_cast<int64_t>(time) - timestamps[vertex] + 2 * static_cast<int64_t>(liveCounts[vertex]) <= cacheSize) {
+			priority = time - timestamps[vertex];
+		}
+
+		if (priority > bestPriority) {
+			bestPriority = priority;
+			best = vertex;
+		}
+	}
+
+	if (best != -1) {
+		return best;
+	}
+
+	// nothing nearby has triangles left, back up through recently used vertices before scanning for a fresh start
+	while (!deadEnd.empty()) {
+		uint32_t vertex = deadEnd.back();
+		deadEnd.pop_back();
+		if (liveCounts[vertex] > 0) {
+			return vertex;
+		}
+	}
+
+	while (cursor < liveCounts.size()) {
+		if (liveCounts[cursor] > 0) {
+			return static_cast<int64_t>(cursor);
+		}
+		cursor++;
+	}
+
+	return -1;
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	if (indices.empty()) {
+		return;
+	}
+
+	TriangleAdjacency adjacency;
+	std::vector<uint32_t> liveCounts;
+	buildAdjacency(indices, vertexCount, adjacency, liveCounts);
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	std::vector<bool> emitted(indices.size() / 3, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	uint32_t time = cacheSize + 1;
+	size_t cursor = 0;
+	int64_t fanningVertex = getNextVertex(candidates, liveCounts, timestamps, time, cacheSize, deadEnd, cursor);
+
+	while (fanningVertex >= 0) {
+		candidates.clear();
+
+		for (uint32_t i = adjacency.offsets[fanningVertex]; i < adjacency.offsets[fanningVertex + 1]; i++) {
+			uint32_t triangle = adjacency.triangles[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+				liveCounts[vertex]--;
+
+				if (time - timestamps[vertex] > cacheSize) {
+					timestamps[vertex] = time++;
+				}
+			}
+
+			emitted[triangle] = true;
+		}
+
+		fanningVertex = getNextVertex(candidates, liveCounts, timestamps, time, cacheSize, deadEnd, cursor);
+	}
+
+	indices.swap(output);
+}
+
+uint32_t optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, uint32_t cacheSize, float threshold) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return 0;
+	}
+
+	// hard boundaries are where the cache order already restarts cold, every vertex of the triangle misses
+	std::vector<uint32_t> hardBoundaries;
+	std::vector<uint32_t> timestamps(vertices.size(), 0);
+	uint32_t time = cacheSize;
+
+	for (size_t i = 0; i < triangleCount; i++) {
+		if (simulateTriangle(&indices[i * 3], timestamps, time, cacheSize) == 3) {
+			hardBoundaries.push_back(static_cast<uint32_t>(i));
+		}
+	}
+	hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+	if (hardBoundaries[0] != 0) {
+		hardBoundaries.insert(hardBoundaries.begin(), 0);
+	}
+
+	// soft boundaries split a hard cluster again wherever the running miss ratio is back under the cluster's own
+	// ratio times the threshold, so the extra misses from restarting the cache stay bounded
+	std::vector<uint32_t> clusters;
+	for (size_t c = 0; c + 1 < hardBoundaries.size(); c++) {
+		uint32_t start = hardBoundaries[c];
+		uint32_t end = hardBoundaries[c + 1];
+
+		time += cacheSize + 1;
+		uint32_t clusterMisses = 0;
+		for (uint32_t i = start; i < end; i++) {
+			clusterMisses += simulateTriangle(&indices[i * 3], timestamps, time, cacheSize);
+		}
+		float clusterThreshold = static_cast<float>(clusterMisses) / (end - start) * threshold;
+
+		clusters.push_back(start);
+		time += cacheSize + 1;
+		uint32_t runningMisses = 0;
+		uint32_t runningTriangles = 0;
+
+		for (uint32_t i = start; i < end; i++) {
+			runningMisses += simulateTriangle(&indices[i * 3], timestamps, time, cacheSize);
+			runningTriangles++;
+
+			if (i + 1 < end && static_cast<float>(runningMisses) / runningTriangles <= clusterThreshold) {
+				clusters.push_back(i + 1);
+				time += cacheSize + 1;
+				runningMisses = 0;
+				runningTriangles = 0;
+			}
+		}
+	}
+	clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+	// area weighted centroid and normal of each cluster, the mesh center is the area weighted centroid of everything
+	size_t clusterCount = clusters.size() - 1;
+	std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < clusterCount; c++) {
+		float clusterArea = 0.0f;
+
+		for (uint32_t i = clusters[c]; i < clusters[c + 1]; i++) {
+			const glm::vec3& a = vertices[indices[i * 3 + 0]].pos;
+			const glm::vec3& b = vertices[indices[i * 3 + 1]].pos;
+			const glm::vec3& d = vertices[indices[i * 3 + 2]].pos;
+
+			glm::vec3 normal = glm::cross(b - a, d - a);
+			float area = glm::length(normal);
+
+			clusterCentroids[c] += (a + b + d) * (area / 3.0f);
+			clusterNormals[c] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += clusterCentroids[c];
+		meshArea += clusterArea;
+		clusterCentroids[c] /= std::max(clusterArea, 1e-12f);
+	}
+	meshCentroid /= std::max(meshArea, 1e-12f);
+
+	std::vector<float> sortKeys(clusterCount);
+	std::vector<uint32_t> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++) {
+		float normalLength = glm::length(clusterNormals[c]);
+		glm::vec3 normal = normalLength > 0.0f ? clusterNormals[c] / normalLength : glm::vec3(0.0f);
+		sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, normal);
+		order[c] = static_cast<uint32_t>(c);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (uint32_t c : order) {
+		output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+	}
+
+	indices.swap(output);
+	return static_cast<uint32_t>(clusterCount);
+}
+
+// unreferenced vertices are dropped along the way
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+	const uint32_t kUNUSED = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> remap(vertices.size(), kUNUSED);
+	std::vector<Vertex> output;
+	output.reserve(vertices.size());
+
+	for (uint32_t& index : indices) {
+		if (remap[index] == kUNUSED) {
+			remap[index] = static_cast<uint32_t>(output.size());
+			output.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices.swap(output);
+}
+
+void optimizeMesh(Mesh& mesh, MeshOptimizeStats* stats) {
+	MeshOptimizeStats localStats;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	finalizeMesh(mesh);
+
+	// every lod is reordered on its own, the reported numbers are for the full detail one
+	for (size_t i = 0; i < mesh.lods.size(); i++) {
+		auto lodBegin = mesh.indices.begin() + mesh.lods[i].firstIndex;
+		std::vector<uint32_t> lodIndices(lodBegin, lodBegin + mesh.lods[i].indexCount);
+
+		if (i == 0) {
+			localStats.before = analyzeVertexCache(lodIndices, mesh.vertices.size(), kVERTEX_CACHE_SIZE);
+		}
+
+		optimizeVertexCache(lodIndices, mesh.vertices.size(), kVERTEX_CACHE_SIZE);
+		uint32_t clusters = optimizeOverdraw(lodIndices, mesh.vertices, kVERTEX_CACHE_SIZE, kOVERDRAW_THRESHOLD);
+
+		if (i == 0) {
+			localStats.clusters = clusters;
+		}
+
+		std::copy(lodIndices.begin(), lodIndices.end(), lodBegin);
+	}
+
+	// coarser lods only use a subset of the full detail vertices, so fetch order follows the full detail lod
+	optimizeVertexFetch(mesh.vertices, mesh.indices);
+	finalizeMesh(mesh);
+
+	localStats.after = analyzeVertexCache(std::vector<uint32_t>(mesh.indices.begin(), mesh.indices.begin() + mesh.lods[0].indexCount),
+		mesh.vertices.size(), kVERTEX_CACHE_SIZE);
+	localStats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	if (stats != nullptr) {
+		*stats = localStats;
+	}
+}
+
+void printMeshOptimizeStats(const MeshOptimizeStats& stats) {
+	cout << "Optimized mesh in " << stats.seconds * 1000.0 << " ms, " << stats.clusters << " overdraw clusters (" << kVERTEX_CACHE_SIZE
+		<< " entry cache)" << endl;
+	cout << "  ACMR " << stats.before.acmr << " -> " << stats.after.acmr << ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << endl;
+}
\ No newline at end of file
@@ -0,0 +1,416 @@
+#include "headers/VulkanApplicationMeshSimplifier.h"
+#include <chrono>
+
+const uint8_t kVERTEX_MANIFOLD = 0;
+const uint8_t kVERTEX_BORDER = 1;	// on an open edge, may only collapse along it
+const uint8_t kVERTEX_LOCKED = 2;	// uv seam or non manifold, never moves
+
+// border planes are weighted up so the outline of open meshes holds its shape
+const double kBORDER_WEIGHT = 10.0;
+
+// symmetric 4x4 matrix stored as its upper triangle, plus the total area that went into it
+struct Quadric {
+	double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+	double a11 = 0, a12 = 0, a13 = 0;
+	double a22 = 0, a23 = 0;
+	double a33 = 0;
+	double weight = 0;
+};
+
+struct EdgeCollapse {
+	uint32_t from;	// vertex indices
+	uint32_t to;
+	float error;
+};
+
+// plane ax + by + cz + d = 0 with a unit normal
+static void addPlane(Quadric& quadric, double a, double b, double c, double d, double weight) {
+	quadric.a00 += weight * a * a;
+	quadric.a01 += weight * a * b;
+	quadric.a02 += weight * a * c;
+	quadric.a03 += weight * a * d;
+	quadric.a11 += weight * b * b;
+	quadric.a12 += weight * b * c;
+	quadric.a13 += weight * b * d;
+	quadric.a22 += weight * c * c;
+	quadric.a23 += weight * c * d;
+	quadric.a33 += weight * d * d;
+	quadric.weight += weight;
+}
+
+static void addQuadric(Quadric& quadric, const Quadric& other) {
+	quadric.a00 += other.a00;
+	quadric.a01 += other.a01;
+	quadric.a02 += other.a02;
+	quadric.a03 += other.a03;
+	quadric.a11 += other.a11;
+	quadric.a12 += other.a12;
+	quadric.a13 += other.a13;
+	quadric.a22 += other.a22;
+	quadric.a23 += other.a23;
+	quadric.a33 += other.a33;
+	quadric.weight += other.weight;
+}
+
+// mean squared distance to the planes that went into the quadric
+static float evaluateQuadric(const Quadric& quadric, const glm::vec3& position) {
+	double x = position.x;
+	double y = position.y;
+	double z = position.z;
+
+	double error = quadric.a00 * x * x + 2.0 * quadric.a01 * x * y + 2.0 * quadric.a02 * x * z + 2.0 * quadric.a03 * x
+		+ quadric.a11 * y * y + 2.0 * quadric.a12 * y * z + 2.0 * quadric.a13 * y
+		+ quadric.a22 * z * z + 2.0 * quadric.a23 * z
+		+ quadric.a33;
+
+	return static_cast<float>(std::max(error, 0.0) / std::max(quadric.weight, 1e-20));
+}
+
+static uint64_t getEdgeKey(uint32_t a, uint32_t b) {
+	return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+// every referenced vertex gets the index of the first referenced vertex with the same position
+static void weldPositions(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, std::vector<uint32_t>& positionIds,
+	std::vector<uint32_t>& wedgeCounts) {
+	std::vector<bool> referenced(vertices.size(), false);
+	for (uint32_t index : indices) {
+		referenced[index] = true;
+	}
+
+	std::vector<uint32_t> order;
+	for (uint32_t i = 0; i < vertices.size(); i++) {
+		if (referenced[i]) {
+			order.push_back(i);
+		}
+	}
+
+	auto lessPosition = [&](uint32_t a, uint32_t b) {
+		const glm::vec3& pa = vertices[a].pos;
+		const glm::vec3& pb = vertices[b].pos;
+		if (pa.x != pb.x) return pa.x < pb.x;
+		if (pa.y != pb.y) return pa.y < pb.y;
+		return pa.z < pb.z;
+	};
+	std::sort(order.begin(), order.end(), lessPosition);
+
+	positionIds.assign(vertices.size(), 0);
+	wedgeCounts.assign(vertices.size(), 0);
+
+	for (size_t i = 0; i < order.size(); i++) {
+		bool samePosition = i > 0 && vertices[order[i]].pos == vertices[order[i - 1]].pos;
+		positionIds[order[i]] = samePosition ? positionIds[order[i - 1]] : order[i];
+		wedgeCounts[positionIds[order[i]]]++;
+	}
+}
+
+// planes through each open edge perpendicular to its triangle, and the vertex kinds that follow from the edge counts
+static void classifyVertices(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& positionIds,
+	const std::vector<uint32_t>& wedgeCounts, std::vector<uint8_t>& kinds, std::vector<uint64_t>& borderEdges, std::vector<Quadric>& quadrics) {
+	std::vector<uint64_t> edges;
+	edges.reserve(indices.size());
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		for (int corner = 0; corner < 3; corner++) {
+			edges.push_back(getEdgeKey(positionIds[indices[i + corner]], positionIds[indices[i + (corner + 1) % 3]]));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+
+	kinds.assign(vertices.size(), kVERTEX_MANIFOLD);
+	borderEdges.clear();
+
+	for (size_t i = 0; i < edges.size();) {
+		size_t count = 1;
+		while (i + count < edges.size() && edges[i + count] == edges[i]) {
+			count++;
+		}
+
+		uint32_t a = static_cast<uint32_t>(edges[i] >> 32);
+		uint32_t b = static_cast<uint32_t>(edges[i] & 0xFFFFFFFFu);
+
+		if (count == 1) {
+			borderEdges.push_back(edges[i]);
+			kinds[a] = std::max(kinds[a], kVERTEX_BORDER);
+			kinds[b] = std::max(kinds[b], kVERTEX_BORDER);
+		} else if (count > 2) {
+			kinds[a] = kVERTEX_LOCKED;
+			kinds[b] = kVERTEX_LOCKED;
+		}
+
+		i += count;
+	}
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		if (wedgeCounts[i] > 1) {
+			kinds[i] = kVERTEX_LOCKED;
+		}
+	}
+
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		glm::vec3 p0 = vertices[indices[i + 0]].pos;
+		glm::vec3 p1 = vertices[indices[i + 1]].pos;
+		glm::vec3 p2 = vertices[indices[i + 2]].pos;
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(normal);
+		if (length <= 0.0f) {
+			continue;
+		}
+		normal /= length;
+
+		for (int corner = 0; corner < 3; corner++) {
+			uint32_t a = positionIds[indices[i + corner]];
+			uint32_t b = positionIds[indices[i + (corner + 1) % 3]];
+			if (!std::binary_search(borderEdges.begin(), borderEdges.end(), getEdgeKey(a, b))) {
+				continue;
+			}
+
+			glm::vec3 edge = vertices[b].pos - vertices[a].pos;
+			glm::vec3 planeNormal = glm::cross(edge, normal);
+			float planeLength = glm::length(planeNormal);
+			if (planeLength <= 0.0f) {
+				continue;
+			}
+			planeNormal /= planeLength;
+
+			double d = -glm::dot(planeNormal, vertices[a].pos);
+			double weight = glm::dot(edge, edge) * kBORDER_WEIGHT;
+			addPlane(quadrics[a], planeNormal.x, planeNormal.y, planeNormal.z, d, weight);
+			addPlane(quadrics[b], planeNormal.x, planeNormal.y, planeNormal.z, d, weight);
+		}
+	}
+}
+
+static bool canCollapse(uint32_t from, uint32_t to, const std::vector<uint8_t>& kinds, const std::vector<uint64_t>& borderEdges) {
+	if (kinds[from] == kVERTEX_MANIFOLD) {
+		return true;
+	}
+
+	return kinds[from] == kVERTEX_BORDER && std::binary_search(borderEdges.begin(), borderEdges.end(), getEdgeKey(from, to));
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float& resultError) {
+	std::vector<uint32_t> result = indices;
+	resultError = 0.0f;
+
+	std::vector<uint32_t> positionIds;
+	std::vector<uint32_t> wedgeCounts;
+	weldPositions(vertices, indices, positionIds, wedgeCounts);
+
+	// quadrics, kinds and touched flags live on the welded position, indexed by its representative vertex
+	std::vector<Quadric> quadrics(vertices.size());
+	std::vector<uint8_t> kinds;
+	std::vector<uint64_t> borderEdges;
+	classifyVertices(vertices, indices, positionIds, wedgeCounts, kinds, borderEdges, quadrics);
+
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		glm::vec3 p0 = vertices[indices[i + 0]].pos;
+		glm::vec3 normal = glm::cross(vertices[indices[i + 1]].pos - p0, vertices[indices[i + 2]].pos - p0);
+		float length = glm::length(normal);
+		if (length <= 0.0f) {
+			continue;
+		}
+
+		normal /= length;
+		double d = -glm::dot(normal, p0);
+		for (int corner = 0; corner < 3; corner++) {
+			addPlane(quadrics[positionIds[indices[i + corner]]], normal.x, normal.y, normal.z, d, length * 0.5);
+		}
+	}
+
+	std::vector<uint32_t> adjacencyOffsets;
+	std::vector<uint32_t> adjacency;
+	std::vector<EdgeCollapse> collapses;
+	std::vector<uint32_t> vertexRemap(vertices.size());
+	std::vector<bool> touched(vertices.size());
+	float maxError = 0.0f;
+
+	while (result.size() > targetIndexCount) {
+		size_t triangleCount = result.size() / 3;
+
+		// triangles around each welded position
+		adjacencyOffsets.assign(vertices.size() + 1, 0);
+		for (uint32_t index : result) {
+			adjacencyOffsets[positionIds[index] + 1]++;
+		}
+		for (size_t i = 0; i < vertices.size(); i++) {
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		}
+		adjacency.resize(result.size());
+		std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < result.size(); i++) {
+			adjacency[cursor[positionIds[result[i]]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// the cheaper allowed direction of every edge
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t a = result[i + corner];
+				uint32_t b = result[i + (corner + 1) % 3];
+				uint32_t positionA = positionIds[a];
+				uint32_t positionB = positionIds[b];
+
+				EdgeCollapse collapse{ 0, 0, std::numeric_limits<float>::max() };
+				if (canCollapse(positionA, positionB, kinds, borderEdges)) {
+					collapse = { a, b, evaluateQuadric(quadrics[positionA], vertices[b].pos) };
+				}
+				if (canCollapse(positionB, positionA, kinds, borderEdges)) {
+					float error = evaluateQuadric(quadrics[positionB], vertices[a].pos);
+					if (error < collapse.error) {
+						collapse = { b, a, error };
+					}
+				}
+
+				if (collapse.error != std::numeric_limits<float>::max()) {
+					collapses.push_back(collapse);
+				}
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.error < b.error; });
+
+		for (size_t i = 0; i < vertices.size(); i++) {
+			vertexRemap[i] = static_cast<uint32_t>(i);
+		}
+		std::fill(touched.begin(), touched.end(), false);
+
+		size_t trianglesToRemove = triangleCount - targetIndexCount / 3;
+		size_t trianglesRemoved = 0;
+		size_t collapseCount = 0;
+
+		for (const EdgeCollapse& collapse : collapses) {
+			if (trianglesRemoved >= trianglesToRemove) {
+				break;
+			}
+
+			uint32_t from = positionIds[collapse.from];
+			uint32_t to = positionIds[collapse.to];
+			if (touched[from] || touched[to]) {
+				continue;
+			}
+
+			// nothing around an untouched vertex has moved this pass, so the current positions are the real ones
+			bool flips = false;
+			size_t removedHere = 0;
+			for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1] && !flips; a++) {
+				const uint32_t* triangle = &result[adjacency[a] * 3];
+				glm::vec3 before[3];
+				glm::vec3 after[3];
+				bool sharesEdge = false;
+
+				for (int corner = 0; corner < 3; corner++) {
+					uint32_t position = positionIds[triangle[corner]];
+					sharesEdge |= position == to;
+					before[corner] = vertices[triangle[corner]].pos;
+					after[corner] = position == from ? vertices[collapse.to].pos : before[corner];
+				}
+
+				if (sharesEdge) {
+					removedHere++;
+					continue;
+				}
+
+				glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				flips = glm::dot(normalBefore, normalAfter) <= 0.0f;
+			}
+
+			if (flips) {
+				continue;
+			}
+
+			vertexRemap[collapse.from] = collapse.to;
+			addQuadric(quadrics[to], quadrics[from]);
+			maxError = std::max(maxError, collapse.error);
+
+			// lock the whole one ring, triangles in it are about to change shape
+			for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++) {
+				for (int corner = 0; corner < 3; corner++) {
+					touched[positionIds[result[adjacency[a] * 3 + corner]]] = true;
+				}
+			}
+
+			trianglesRemoved += removedHere;
+			collapseCount++;
+		}
+
+		if (collapseCount == 0) {
+			break;
+		}
+
+		// apply the collapses and drop the triangles that lost an edge
+		size_t writeIndex = 0;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			uint32_t a = vertexRemap[result[i + 0]];
+			uint32_t b = vertexRemap[result[i + 1]];
+			uint32_t c = vertexRemap[result[i + 2]];
+
+			if (positionIds[a] == positionIds[b] || positionIds[b] == positionIds[c] || positionIds[a] == positionIds[c]) {
+				continue;
+			}
+
+			result[writeIndex++] = a;
+			result[writeIndex++] = b;
+			result[writeIndex++] = c;
+		}
+		result.resize(writeIndex);
+	}
+
+	resultError = std::sqrt(maxError);
+	return result;
+}
+
+void generateMeshLods(Mesh& mesh, MeshLodStats* stats) {
+	MeshLodStats localStats;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	const MeshLod& fullDetail = mesh.lods[0];
+	std::vector<uint32_t> current(mesh.indices.begin() + fullDetail.firstIndex, mesh.indices.begin() + fullDetail.firstIndex + fullDetail.indexCount);
+
+	std::vector<uint32_t> indices = current;
+	std::vector<MeshLod> lods = { { 0, static_cast<uint32_t>(current.size()), 0.0f } };
+	float error = 0.0f;
+
+	while (lods.size() < kMAX_MESH_LODS) {
+		size_t targetIndexCount = current.size() / 6 * 3;
+		if (targetIndexCount / 3 < kMIN_LOD_TRIANGLES) {
+			break;
+		}
+
+		float passError;
+		std::vector<uint32_t> simplified = simplifyMesh(mesh.vertices, current, targetIndexCount, passError);
+
+		// locked seams and borders can stall it, a lod that barely shrinks isn't worth the memory
+		if (simplified.size() * 10 > current.size() * 9) {
+			break;
+		}
+
+		// each lod was simplified from the previous one, so errors add up
+		error += passError;
+		lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), error });
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+		current.swap(simplified);
+	}
+
+	mesh.indices.swap(indices);
+	mesh.lods.swap(lods);
+
+	localStats.lodCount = static_cast<uint32_t>(mesh.lods.size());
+	for (size_t i = 0; i < mesh.lods.size(); i++) {
+		localStats.triangles[i] = mesh.lods[i].indexCount / 3;
+		localStats.errors[i] = mesh.lods[i].error;
+	}
+	localStats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	if (stats != nullptr) {
+		*stats = localStats;
+	}
+}
+
+void printMeshLodStats(const MeshLodStats& stats) {
+	cout << "Generated " << stats.lodCount << " lods in " << stats.seconds * 1000.0 << " ms:";
+	for (uint32_t i = 0; i < stats.lodCount; i++) {
+		cout << " " << stats.triangles[i] << " (" << stats.errors[i] << ")";
+	}
+	cout << endl;
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "headers/VulkanApplicationPipelineCache.h"
+
+VulkanApplicationPipelineCache::VulkanApplicationPipelineCache(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, const std::string& path) {
+	this->logicalDevice = logicalDevice;
+	this->path = path;
+
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	// the driver UUID is core in 1.1, older devices only get checked by driver version
+	if (properties.apiVersion >= VK_API_VERSION_1_1) {
+		VkPhysicalDeviceIDProperties idProperties{};
+		idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &idProperties;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+		memcpy(driverUUID, idProperties.driverUUID, VK_UUID_SIZE);
+	}
+
+	std::vector<char> file;
+
+	if (std::filesystem::exists(path)) {
+		try {
+			file = readFile(path);
+		} catch (const std::runtime_error&) {
+			file.clear();
+		}
+	}
+
+	warm = !file.empty() && validate(file);
+
+	VkPipelineCacheCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	if (warm) {
+		createInfo.initialDataSize = file.size() - sizeof(PipelineCacheFileHeader);
+		createInfo.pInitialData = file.data() + sizeof(PipelineCacheFileHeader);
+	}
+
+	if (vkCreatePipelineCache(logicalDevice, &createInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Pipeline Cache");
+	}
+
+	if (debug) {
+		cout << "Pipeline cache " << path << (warm ? " loaded, " + std::to_string(createInfo.initialDataSize) + " bytes" : " starts empty") << endl;
+	}
+}
+
+VulkanApplicationPipelineCache::~VulkanApplicationPipelineCache() {}
+
+// saves before destroying, has to run while the device is still alive
+void VulkanApplicationPipelineCache::cleanup() {
+	save();
+	vkDestroyPipelineCache(logicalDevice, pipelineCache, nullptr);
+}
+
+uint64_t hashPipelineCacheData(const char* data, size_t size) {
+	// fnv-1a, only has to notice a file that was cut short or scribbled over
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001B3ull;
+	}
+
+	return hash;
+}
+
+bool VulkanApplicationPipelineCache::validate(const std::vector<char>& file) {
+	std::string reason;
+	PipelineCacheFileHeader header;
+	VkPipelineCacheHeaderVersionOne driverHeader;
+
+	if (file.size() < sizeof(PipelineCacheFileHeader) + sizeof(VkPipelineCacheHeaderVersionOne)) {
+		reason = "too small";
+	} else {
+		memcpy(&header, file.data(), sizeof(PipelineCacheFileHeader));
+		memcpy(&driverHeader, file.data() + sizeof(PipelineCacheFileHeader), sizeof(VkPipelineCacheHeaderVersionOne));
+		size_t dataSize = file.size() - sizeof(PipelineCacheFileHeader);
+
+		if (memcmp(header.magic, "VKPC", 4) != 0 || header.version != kPIPELINE_CACHE_VERSION) {
+			reason = "not a pipeline cache of this version";
+		} else if (header.dataSize != dataSize || header.dataHash != hashPipelineCacheData(file.data() + sizeof(PipelineCacheFileHeader), dataSize)) {
+			reason = "truncated or corrupt";
+		} else if (header.driverVersion != properties.driverVersion || memcmp(header.driverUUID, driverUUID, VK_UUID_SIZE) != 0) {
+			reason = "written by another driver";
+		} else if (driverHeader.headerSize < sizeof(VkPipelineCacheHeaderVersionOne) || driverHeader.headerSize > dataSize ||
+			driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+			reason = "unknown driver header";
+		} else if (driverHeader.vendorID != properties.vendorID || driverHeader.deviceID != properties.deviceID ||
+			memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+			reason = "written for another device";
+		}
+	}
+
+	if (!reason.empty() && debug) {
+		cout << "Ignoring pipeline cache " << path << ", " << reason << endl;
+	}
+
+	return reason.empty();
+}
+
+// everything compiled so far, including what the file started with
+void VulkanApplicationPipelineCache::save() {
+	size_t dataSize = 0;
+
+	if (vkGetPipelineCacheData(logicalDevice, pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+		return;
+	}
+
+	std::vector<char> file(sizeof(PipelineCacheFileHeader) + dataSize);
+
+	// VK_INCOMPLETE would mean it grew in between, nothing else is creating pipelines here
+	if (vkGetPipelineCacheData(logicalDevice, pipelineCache, &dataSize, file.data() + sizeof(PipelineCacheFileHeader)) != VK_SUCCESS) {
+		return;
+	}
+
+	file.resize(sizeof(PipelineCacheFileHeader) + dataSize);
+
+	PipelineCacheFileHeader header{};
+	memcpy(header.magic, "VKPC", 4);
+	header.version = kPIPELINE_CACHE_VERSION;
+	header.driverVersion = properties.driverVersion;
+	memcpy(header.driverUUID, driverUUID, VK_UUID_SIZE);
+	header.dataSize = dataSize;
+	header.dataHash = hashPipelineCacheData(file.data() + sizeof(PipelineCacheFileHeader), dataSize);
+	memcpy(file.data(), &header, sizeof(PipelineCacheFileHeader));
+
+	if (!writeFileAtomically(path, file.data(), file.size()) && debug) {
+		cout << "Failed to write pipeline cache " << path << endl;
+	}
+}
+
+VkPipelineCache VulkanApplicationPipelineCache::getPipelineCache() {
+	return this->pipelineCache;
+}
+
+bool VulkanApplicationPipelineCache::isWarm() {
+	return this->warm;
+}
\ No newline at end of file
@@ -0,0 +1,354 @@
+#include "headers/VulkanApplicationPipelineRegistry.h"
+
+VulkanApplicationPipelineRegistry::VulkanApplicationPipelineRegistry(VkDevice logicalDevice, VkPipelineCache pipelineCache, VkRenderPass renderPass, VkPipelineLayout pipelineLayout) {
+	this->logicalDevice = logicalDevice;
+	this->pipelineCache = pipelineCache;
+	this->renderPass = renderPass;
+	this->pipelineLayout = pipelineLayout;
+}
+
+VulkanApplicationPipelineRegistry::~VulkanApplicationPipelineRegistry() {}
+
+// jobs still compiling are waited for, a failed one has nothing to destroy
+void VulkanApplicationPipelineRegistry::cleanup() {
+	for (std::unique_ptr<RegisteredPipeline>& registered : pipelines) {
+		if (registered->state == PipelineState::kCompiling) {
+			try {
+				getJobSystem().wait(registered->job);
+			}
+			catch (const std::exception&) {}
+		}
+
+		if (registered->pipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(logicalDevice, registered->pipeline, nullptr);
+		}
+	}
+
+	if (debug) {
+		cout << "Pipeline registry: " << stats.requests << " requests, " << stats.hits << " shared, " << stats.compiled << " compiled in "
+			<< stats.compileSeconds * 1000.0 << " ms of job time, " << stats.failed << " failed" << endl;
+	}
+
+	pipelines.clear();
+	pipelinesByDescription.clear();
+}
+
+bool PipelineDescription::operator==(const PipelineDescription& other) const {
+	return vertexShaderPath == other.vertexShaderPath && fragmentShaderPath == other.fragmentShaderPath && vertexFormat == other.vertexFormat &&
+		instanced == other.instanced && topology == other.topology && polygonMode == other.polygonMode && cullMode == other.cullMode &&
+		frontFace == other.frontFace && depthTest == other.depthTest && depthWrite == other.depthWrite && depthCompareOp == other.depthCompareOp &&
+		blendEnable == other.blendEnable && srcColorBlendFactor == other.srcColorBlendFactor && dstColorBlendFactor == other.dstColorBlendFactor &&
+		colorBlendOp == other.colorBlendOp && srcAlphaBlendFactor == other.srcAlphaBlendFactor && dstAlphaBlendFactor == other.dstAlphaBlendFactor &&
+		alphaBlendOp == other.alphaBlendOp && permutation == other.permutation;
+}
+
+// fnv-1a over every field, the map still compares whole descriptions so a collision only costs a probe
+uint64_t hashPipelineDescription(const PipelineDescription& description) {
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	auto hashBytes = [&hash](const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+		}
+	};
+
+	// the length goes in too, so the two paths can't run into each other
+	auto hashString = [&hashBytes](const std::string& string) {
+		uint64_t size = string.size();
+		hashBytes(&size, sizeof(size));
+		hashBytes(string.data(), string.size());
+	};
+
+	uint32_t state[] = {
+		static_cast<uint32_t>(description.vertexFormat), description.instanced ? 1u : 0u, static_cast<uint32_t>(description.topology),
+		static_cast<uint32_t>(description.polygonMode), static_cast<uint32_t>(description.cullMode), static_cast<uint32_t>(description.frontFace),
+		description.depthTest ? 1u : 0u, description.depthWrite ? 1u : 0u, static_cast<uint32_t>(description.depthCompareOp),
+		description.blendEnable ? 1u : 0u, static_cast<uint32_t>(description.srcColorBlendFactor), static_cast<uint32_t>(description.dstColorBlendFactor),
+		static_cast<uint32_t>(description.colorBlendOp), static_cast<uint32_t>(description.srcAlphaBlendFactor),
+		static_cast<uint32_t>(description.dstAlphaBlendFactor), static_cast<uint32_t>(description.alphaBlendOp)
+	};
+
+	hashString(description.vertexShaderPath);
+	hashString(description.fragmentShaderPath);
+	hashBytes(state, sizeof(state));
+	// no padding in it, the static_asserts next to it make sure of that
+	hashBytes(&description.permutation, sizeof(ShaderPermutation));
+
+	return hash;
+}
+
+// the fallback is only used while this one isn't ready, it should be something already requested
+PipelineHandle VulkanApplicationPipelineRegistry::request(const PipelineDescription& description, PipelineHandle fallback) {
+	stats.requests++;
+	auto found = pipelinesByDescription.find(description);
+
+	if (found != pipelinesByDescription.end()) {
+		stats.hits++;
+		return PipelineHandle{ found->second };
+	}
+
+	uint32_t index = static_cast<uint32_t>(pipelines.size());
+	pipelines.push_back(std::make_unique<RegisteredPipeline>());
+
+	RegisteredPipeline& registered = *pipelines.back();
+	registered.description = description;
+	registered.fallback = fallback;
+	pipelinesByDescription[description] = index;
+
+	// everything the job touches stays alive until cleanup() waited for it
+	RegisteredPipeline* pointer = &registered;
+	registered.job = getJobSystem().scheduleBackground([this, pointer]() { compile(*pointer); });
+
+	return PipelineHandle{ index };
+}
+
+// only the frame loop's thread looks at the state, the job just fills in the pipeline. recording threads get the VkPipeline handed to them
+void VulkanApplicationPipelineRegistry::resolve(RegisteredPipeline& registered) {
+	if (registered.state != PipelineState::kCompiling) {
+		return;
+	}
+
+	// with a single thread there's no worker to pick the compile up, it runs here
+	if (!getJobSystem().isFinished(registered.job) && getJobSystem().getThreadCount() > 1) {
+		return;
+	}
+
+	try {
+		getJobSystem().wait(registered.job);
+		registered.state = PipelineState::kReady;
+		stats.compiled++;
+		stats.compileSeconds += registered.compileSeconds;
+	}
+	catch (const std::exception& error) {
+		registered.state = PipelineState::kFailed;
+		stats.failed++;
+
+		if (debug) {
+			cout << "Pipeline " << registered.description.vertexShaderPath << " + " << registered.description.fragmentShaderPath
+				<< " failed to compile, " << error.what() << endl;
+		}
+	}
+}
+
+// for pipelines there is nothing to draw without, rethrows a failed compile
+void VulkanApplicationPipelineRegistry::wait(PipelineHandle handle) {
+	RegisteredPipeline& registered = *pipelines[handle.index];
+
+	if (registered.state == PipelineState::kCompiling) {
+		try {
+			getJobSystem().wait(registered.job);
+		}
+		catch (const std::exception&) {} // resolve() records the failure
+	}
+
+	resolve(registered);
+
+	if (registered.state == PipelineState::kFailed) {
+		throw std::runtime_error("Failed to Create Graphics Pipeline");
+	}
+}
+
+// VK_NULL_HANDLE means neither it nor any fallback is ready, skip the draw. frame loop's thread only
+VkPipeline VulkanApplicationPipelineRegistry::getPipeline(PipelineHandle handle) {
+	while (handle.isValid()) {
+		RegisteredPipeline& registered = *pipelines[handle.index];
+		resolve(registered);
+
+		if (registered.state == PipelineState::kReady) {
+			return registered.pipeline;
+		}
+
+		handle = registered.fallback;
+	}
+
+	return VK_NULL_HANDLE;
+}
+
+PipelineState VulkanApplicationPipelineRegistry::getState(PipelineHandle handle) {
+	resolve(*pipelines[handle.index]);
+	return this->pipelines[handle.index]->state;
+}
+
+uint32_t VulkanApplicationPipelineRegistry::getPipelineCount() {
+	return static_cast<uint32_t>(this->pipelines.size());
+}
+
+PipelineRegistryStats VulkanApplicationPipelineRegistry::getStats() {
+	return this->stats;
+}
+
+// runs in a job, everything it reads was set before the job was scheduled
+void VulkanApplicationPipelineRegistry::compile(RegisteredPipeline& registered) {
+	const PipelineDescription& description = registered.description;
+	auto compileStart = std::chrono::high_resolution_clock::now();
+	auto vertexShaderCode = readFile(description.vertexShaderPath);
+	auto fragmentShaderCode = readFile(description.fragmentShaderPath);
+
+	VkShaderModule vertexShaderModule = createShaderModule(vertexShaderCode);
+	VkShaderModule fragmentShaderModule;
+
+	// a failed compile isn't fatal here, the vertex module can't be left behind
+	try {
+		fragmentShaderModule = createShaderModule(fragmentShaderCode);
+	}
+	catch (const std::exception&) {
+		vkDestroyShaderModule(logicalDevice, vertexShaderModule, nullptr);
+		throw;
+	}
+
+	VkPipelineShaderStageCreateInfo vertexShaderStageInfo{};
+	vertexShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertexShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertexShaderStageInfo.module = vertexShaderModule;
+	vertexShaderStageInfo.pName = "main";
+
+	VkPipelineShaderStageCreateInfo fragmentShaderStageInfo{};
+	fragmentShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	fragmentShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	fragmentShaderStageInfo.module = fragmentShaderModule;
+	fragmentShaderStageInfo.pName = "main";
+
+	// toggles and loop counts are folded in when the driver compiles the fragment shader
+	VkSpecializationInfo specializationInfo{};
+	specializationInfo.mapEntryCount = static_cast<uint32_t>(kSHADER_PERMUTATION_ENTRIES.size());
+	specializationInfo.pMapEntries = kSHADER_PERMUTATION_ENTRIES.data();
+	specializationInfo.dataSize = sizeof(ShaderPermutation);
+	specializationInfo.pData = &description.permutation;
+	fragmentShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
+	VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderStageInfo, fragmentShaderStageInfo };
+
+	// the mesh's vertex format decides the layout, the shaders read every format the same way
+	VertexInputDescription vertexInput = getVertexInputDescription(description.vertexFormat);
+	std::vector<VkVertexInputBindingDescription> bindings = { vertexInput.binding };
+	std::vector<VkVertexInputAttributeDescription> attributes(vertexInput.attributes.begin(), vertexInput.attributes.begin() + vertexInput.attributeCount);
+
+	if (description.instanced) {
+		// the instance binding steps once per instance instead of once per vertex
+		InstanceInputDescription instanceInput = getInstanceInputDescription();
+		bindings.push_back(instanceInput.binding);
+		attributes.insert(attributes.end(), instanceInput.attributes.begin(), instanceInput.attributes.end());
+	}
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+	vertexInputInfo.pVertexBindingDescriptions = bindings.data();
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+	vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssmebly{};
+	inputAssmebly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssmebly.topology = description.topology;
+	inputAssmebly.primitiveRestartEnable = VK_FALSE;
+
+	VkPipelineViewportStateCreateInfo viewportState{};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer{};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE; // could be used as true during shadow map passes
+	rasterizer.rasterizerDiscardEnable = VK_FALSE; // true disabled output from being sent to framebuffer
+	rasterizer.polygonMode = description.polygonMode; // fill polygon with fragments, point and line as read
+	// rasterizer.lineWidth = 1.0f; if the other modes are used, maybe a point weight too?
+	rasterizer.cullMode = description.cullMode;
+	rasterizer.frontFace = description.frontFace;
+	// below could be used for shadow mapping
+	rasterizer.depthBiasEnable = VK_FALSE; // enable bias, adds constant factor or can bias based on slope
+	rasterizer.depthBiasConstantFactor = 0.0f;
+	rasterizer.depthBiasClamp = 0.0f;
+	rasterizer.depthBiasSlopeFactor = 0.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisampling{};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.sampleShadingEnable = VK_FALSE;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisampling.minSampleShading = 1.0f;
+	multisampling.pSampleMask = nullptr;
+	multisampling.alphaToCoverageEnable = VK_FALSE;
+	multisampling.alphaToOneEnable = VK_FALSE;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+		VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+		VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.blendEnable = description.blendEnable ? VK_TRUE : VK_FALSE;
+	colorBlendAttachment.srcColorBlendFactor = description.srcColorBlendFactor;
+	colorBlendAttachment.dstColorBlendFactor = description.dstColorBlendFactor;
+	colorBlendAttachment.colorBlendOp = description.colorBlendOp;
+	colorBlendAttachment.srcAlphaBlendFactor = description.srcAlphaBlendFactor;
+	colorBlendAttachment.dstAlphaBlendFactor = description.dstAlphaBlendFactor;
+	colorBlendAttachment.alphaBlendOp = description.alphaBlendOp;
+
+	VkPipelineColorBlendStateCreateInfo colorBlending{};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.logicOpEnable = VK_FALSE;
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil{};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = description.depthTest ? VK_TRUE : VK_FALSE;
+	depthStencil.depthWriteEnable = description.depthWrite ? VK_TRUE : VK_FALSE;
+	depthStencil.depthCompareOp = description.depthCompareOp;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = VK_FALSE;
+
+	std::vector<VkDynamicState> dynamicStates = {
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+
+	VkPipelineDynamicStateCreateInfo dynamicState{};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicState.pDynamicStates = dynamicStates.data();
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = shaderStages;
+
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssmebly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.pDynamicState = &dynamicState;
+	pipelineInfo.layout = pipelineLayout;
+
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+
+	// the cache is internally synchronized, jobs compiling side by side can share it
+	VkResult result = vkCreateGraphicsPipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &registered.pipeline);
+
+	vkDestroyShaderModule(logicalDevice, vertexShaderModule, nullptr);
+	vkDestroyShaderModule(logicalDevice, fragmentShaderModule, nullptr);
+
+	if (result != VK_SUCCESS) {
+		registered.pipeline = VK_NULL_HANDLE;
+		throw std::runtime_error("Failed to Create Graphics Pipeline");
+	}
+
+	registered.compileSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - compileStart).count();
+}
+
+VkShaderModule VulkanApplicationPipelineRegistry::createShaderModule(const std::vector<char>& code) {
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = code.size();
+	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(logicalDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		throw std::runtime_error("Shader Module Creation Failed");
+	}
+
+	return shaderModule;
+}
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include "headers/VulkanApplicationSceneGraph.h"
+#include <cstring>
+
+VulkanApplicationSceneGraph::VulkanApplicationSceneGraph(VulkanApplicationJobSystem* jobSystem) {
+	this->jobSystem = jobSystem;
+	levelStarts.push_back(0);
+}
+
+VulkanApplicationSceneGraph::~VulkanApplicationSceneGraph() {}
+
+uint32_t VulkanApplicationSceneGraph::createNode(uint32_t parent, const glm::mat4& local, uint32_t objectIndex) {
+	if (parent != kSCENE_GRAPH_NONE && parent >= handleSlots.size()) {
+		throw std::runtime_error("Scene Graph Parent Does Not Exist");
+	}
+
+	uint32_t handle = static_cast<uint32_t>(handleSlots.size());
+	uint32_t slot = static_cast<uint32_t>(parents.size());
+	uint32_t parentSlot = parent == kSCENE_GRAPH_NONE ? kSCENE_GRAPH_NONE : handleSlots[parent];
+	uint32_t depth = parentSlot == kSCENE_GRAPH_NONE ? 0 : depths[parentSlot] + 1;
+
+	handleSlots.push_back(slot);
+	slotHandles.push_back(handle);
+	parents.push_back(parentSlot);
+	locals.push_back(local);
+	worlds.push_back(local);
+	objectIndices.push_back(objectIndex);
+	depths.push_back(depth);
+	dirty.push_back(1);
+	currentOutputs.push_back(0);
+	changedPass.push_back(0);
+
+	if (depth >= levelDirtyCounts.size()) {
+		levelDirtyCounts.resize(depth + 1, 0);
+	}
+
+	levelDirtyCounts[depth]++;
+	sorted = false;
+
+	return handle;
+}
+
+// stable counting sort by depth, parents keep pointing at the right slot
+void VulkanApplicationSceneGraph::sortByDepth() {
+	uint32_t nodeCount = static_cast<uint32_t>(parents.size());
+	uint32_t levelCount = static_cast<uint32_t>(levelDirtyCounts.size());
+
+	levelStarts.assign(levelCount + 1, 0);
+
+	for (uint32_t depth : depths) {
+		levelStarts[depth + 1]++;
+	}
+
+	for (uint32_t level = 0; level < levelCount; level++) {
+		levelStarts[level + 1] += levelStarts[level];
+	}
+
+	sorted = true;
+
+	if (std::is_sorted(depths.begin(), depths.end())) {
+		return;
+	}
+
+	std::vector<uint32_t> newSlots(nodeCount);
+	std::vector<uint32_t> next(levelStarts.begin(), levelStarts.end() - 1);
+
+	for (uint32_t slot = 0; slot < nodeCount; slot++) {
+		newSlots[slot] = next[depths[slot]]++;
+	}
+
+	auto permute = [&](auto& values) {
+		std::remove_reference_t<decltype(values)> sortedValues(values.size());
+
+		for (uint32_t slot = 0; slot < nodeCount; slot++) {
+			sortedValues[newSlots[slot]] = values[slot];
+		}
+
+		values.swap(sortedValues);
+	};
+
+	for (uint32_t& parent : parents) {
+		if (parent != kSCENE_GRAPH_NONE) {
+			parent = newSlots[parent];
+		}
+	}
+
+	permute(parents);
+	permute(locals);
+	permute(worlds);
+	permute(objectIndices);
+	permute(depths);
+	permute(dirty);
+	permute(currentOutputs);
+	permute(changedPass);
+	permute(slotHandles);
+
+	for (uint32_t slot = 0; slot < nodeCount; slot++) {
+		handleSlots[slotHandles[slot]] = slot;
+	}
+}
+
+void VulkanApplicationSceneGraph::setLocalTransform(uint32_t node, const glm::mat4& local) {
+	uint32_t slot = handleSlots[node];
+	locals[slot] = local;
+
+	if (!dirty[slot]) {
+		dirty[slot] = 1;
+		levelDirtyCounts[depths[slot]]++;
+	}
+}
+
+// one level's worth of slots, reads parents from the level above which is finished by now
+uint32_t VulkanApplicationSceneGraph::propagateRange(uint32_t first, uint32_t last, const std::vector<SceneGraphOutput>& outputs, uint8_t outputMask, SceneGraphStats& rangeStats) {
+	uint32_t changedCount = 0;
+
+	for (uint32_t slot = first; slot < last; slot++) {
+		uint32_t parent = parents[slot];
+		bool changed = dirty[slot] || (parent != kSCENE_GRAPH_NONE && changedPass[parent] == pass);
+
+		if (changed) {
+			worlds[slot] = parent == kSCENE_GRAPH_NONE ? locals[slot] : worlds[parent] * locals[slot];
+			dirty[slot] = 0;
+			changedPass[slot] = pass;
+			changedCount++;
+		}
+
+		uint32_t objectIndex = objectIndices[slot];
+
+		if (objectIndex == kSCENE_GRAPH_NONE) {
+			continue;
+		}
+
+		uint8_t current = changed ? 0 : currentOutputs[slot];
+
+		if ((current & outputMask) != outputMask) {
+			for (const SceneGraphOutput& output : outputs) {
+				if (!(current & (1u << output.slot))) {
+					memcpy(static_cast<char*>(output.base) + objectIndex * output.stride, &worlds[slot], sizeof(glm::mat4));
+					rangeStats.matricesWritten++;
+				}
+			}
+		}
+
+		currentOutputs[slot] = current | outputMask;
+	}
+
+	rangeStats.nodesVisited += last - first;
+	rangeStats.nodesUpdated += changedCount;
+	return changedCount;
+}
+
+void VulkanApplicationSceneGraph::propagate(const std::vector<SceneGraphOutput>& outputs) {
+	if (!sorted) {
+		sortByDepth();
+	}
+
+	uint8_t outputMask = 0;
+
+	for (const SceneGraphOutput& output : outputs) {
+		if (output.slot >= kSCENE_GRAPH_MAX_OUTPUTS) {
+			throw std::runtime_error("Scene Graph Output Slot Out of Range");
+		}
+
+		outputMask |= 1u << output.slot;
+	}
+
+	pass++;
+	stats = SceneGraphStats{};
+
+	// a stale output needs every object visited, even the ones that didn't move
+	bool visitAll = (staleOutputs & outputMask) != 0;
+	uint32_t changedAbove = 0;
+
+	for (uint32_t level = 0; level + 1 < levelStarts.size(); level++) {
+		if (!visitAll && levelDirtyCounts[level] == 0 && changedAbove == 0) {
+			continue;
+		}
+
+		uint32_t first = levelStarts[level];
+		uint32_t last = levelStarts[level + 1];
+		uint32_t chunkCount = (last - first + kSCENE_GRAPH_NODES_PER_JOB - 1) / kSCENE_GRAPH_NODES_PER_JOB;
+		stats.levelsVisited++;
+		levelDirtyCounts[level] = 0;
+
+		if (!jobSystem || chunkCount <= 1) {
+			changedAbove = propagateRange(first, last, outputs, outputMask, stats);
+			continue;
+		}
+
+		// chunks only write their own slots, each one adds its counts in once it's done
+		std::mutex statsMutex;
+		SceneGraphStats levelStats;
+		changedAbove = 0;
+
+		jobSystem->parallelFor(last - first, kSCENE_GRAPH_NODES_PER_JOB, [&](uint32_t chunkFirst, uint32_t chunkLast) {
+			SceneGraphStats chunkStats;
+			uint32_t changed = propagateRange(first + chunkFirst, first + chunkLast, outputs, outputMask, chunkStats);
+
+			std::lock_guard<std::mutex> lock(statsMutex);
+			changedAbove += changed;
+			levelStats.nodesVisited += chunkStats.nodesVisited;
+			levelStats.nodesUpdated += chunkStats.nodesUpdated;
+			levelStats.matricesWritten += chunkStats.matricesWritten;
+		});
+
+		stats.nodesVisited += levelStats.nodesVisited;
+		stats.nodesUpdated += levelStats.nodesUpdated;
+		stats.matricesWritten += levelStats.matricesWritten;
+		stats.chunksUsed = std::max(stats.chunksUsed, chunkCount);
+	}
+
+	// every output written this pass is current, the rest missed whatever moved
+	if (stats.nodesUpdated > 0) {
+		staleOutputs = 0xFF;
+	}
+
+	staleOutputs &= ~outputMask;
+}
+
+void VulkanApplicationSceneGraph::invalidateOutput(uint32_t slot) {
+	uint8_t bit = static_cast<uint8_t>(1u << slot);
+
+	for (uint8_t& current : currentOutputs) {
+		current &= ~bit;
+	}
+
+	staleOutputs |= bit;
+}
+
+glm::mat4 VulkanApplicationSceneGraph::getWorldTransform(uint32_t node) {
+	return this->worlds[handleSlots[node]];
+}
+
+uint32_t VulkanApplicationSceneGraph::getNodeCount() {
+	return static_cast<uint32_t>(this->parents.size());
+}
+
+uint32_t VulkanApplicationSceneGraph::getLevelCount() {
+	return static_cast<uint32_t>(this->levelDirtyCounts.size());
+}
+
+SceneGraphStats VulkanApplicationSceneGraph::getStats() {
+	return this->stats;
+}
+
+/***** BENCHMARK *****/
+
+static void printPropagationResult(const std::string& name, double seconds, const SceneGraphStats& stats) {
+	cout << "  " << name << ": " << seconds * 1e3 << " ms, " << stats.levelsVisited << " levels, " << stats.nodesVisited << " nodes visited, "
+		<< stats.nodesUpdated << " updated, " << stats.matricesWritten << " matrices written, " << stats.chunksUsed << " chunks" << endl;
+}
+
+// root, a few hundred groups, objects under the groups, and a leaf under each object, written into an instance buffer shaped array
+void runSceneGraphBenchmark(uint32_t objectCount) {
+	struct BenchmarkInstance {
+		glm::mat4 model;
+		glm::vec4 tint;
+	};
+
+	uint32_t groupCount = std::max(1u, static_cast<uint32_t>(std::sqrt(static_cast<float>(objectCount))));
+	std::vector<BenchmarkInstance> serialInstances(objectCount);
+	std::vector<BenchmarkInstance> parallelInstances(objectCount);
+	std::vector<SceneGraphOutput> serialOutputs = { { serialInstances.data(), sizeof(BenchmarkInstance), 0 } };
+	std::vector<SceneGraphOutput> parallelOutputs = { { parallelInstances.data(), sizeof(BenchmarkInstance), 0 } };
+
+	VulkanApplicationSceneGraph serial;
+	VulkanApplicationSceneGraph parallel(&getJobSystem());
+	std::vector<uint32_t> groups;
+	std::vector<uint32_t> objects;
+
+	for (VulkanApplicationSceneGraph* graph : { &serial, &parallel }) {
+		groups.clear();
+		objects.clear();
+		uint32_t root = graph->createNode(kSCENE_GRAPH_NONE, glm::mat4(1.0f));
+
+		for (uint32_t i = 0; i < groupCount; i++) {
+			groups.push_back(graph->createNode(root, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, i * 2.0f, 0.0f))));
+		}
+
+		// created in object order rather than depth order so the first propagate has to sort
+		for (uint32_t i = 0; i < objectCount; i++) {
+			uint32_t object = graph->createNode(groups[i % groupCount], glm::translate(glm::mat4(1.0f), glm::vec3(i * 0.01f, 0.0f, 0.0f)));
+			graph->createNode(object, glm::mat4(1.0f), i);
+			objects.push_back(object);
+		}
+	}
+
+	cout << "Scene Graph Benchmark: " << serial.getNodeCount() << " nodes in " << serial.getLevelCount() << " levels, " << getJobSystem().getThreadCount() << " job threads" << endl;
+
+	float angle = 0.0f;
+	auto spinObjects = [&](VulkanApplicationSceneGraph& graph) {
+		angle += 0.01f;
+
+		for (uint32_t i = 0; i < objectCount; i++) {
+			graph.setLocalTransform(objects[i], glm::rotate(glm::mat4(1.0f), angle + i, glm::vec3(0.0f, 0.0f, 1.0f)));
+		}
+	};
+
+	double serialSeconds = timeBenchmark([&]() {
+		spinObjects(serial);
+		serial.propagate(serialOutputs);
+	});
+	printPropagationResult("Every object moved, calling thread only", serialSeconds, serial.getStats());
+
+	double parallelSeconds = timeBenchmark([&]() {
+		spinObjects(parallel);
+		parallel.propagate(parallelOutputs);
+	});
+	printPropagationResult("Every object moved, levels split into jobs", parallelSeconds, parallel.getStats());
+
+	double groupSeconds = timeBenchmark([&]() {
+		angle += 0.01f;
+		parallel.setLocalTransform(groups[0], glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f)));
+		parallel.propagate(parallelOutputs);
+	});
+	printPropagationResult("One group moved", groupSeconds, parallel.getStats());
+
+	double staticSeconds = timeBenchmark([&]() { parallel.propagate(parallelOutputs); });
+	printPropagationResult("Nothing moved", staticSeconds, parallel.getStats());
+
+	// both graphs see the same transforms, then the instance arrays have to match exactly
+	serial.setLocalTransform(groups[0], parallel.getWorldTransform(groups[0]));
+	parallel.setLocalTransform(groups[0], parallel.getWorldTransform(groups[0]));
+	spinObjects(serial);
+	angle -= 0.01f;
+	spinObjects(parallel);
+	serial.propagate(serialOutputs);
+	parallel.propagate(parallelOutputs);
+
+	for (uint32_t i = 0; i < objectCount; i++) {
+		if (memcmp(&serialInstances[i].model, &parallelInstances[i].model, sizeof(glm::mat4)) != 0) {
+			throw std::runtime_error("Parallel Scene Graph Results Differ From the Serial Ones");
+		}
+	}
+}
\ No newline at end of file
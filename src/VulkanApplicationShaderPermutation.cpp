@@ -0,0 +1,41 @@
+#include "headers/VulkanApplicationShaderPermutation.h"
+
+bool ShaderPermutation::operator==(const ShaderPermutation& other) const {
+	return textured == other.textured && vertexColor == other.vertexColor && alphaTest == other.alphaTest &&
+		alphaCutoff == other.alphaCutoff && textureTaps == other.textureTaps;
+}
+
+// what S cycles through, the first is the default every pipeline starts with
+std::vector<ShaderPermutation> getShaderPermutationPresets() {
+	std::vector<ShaderPermutation> presets(5);
+
+	presets[1].textured = VK_FALSE;
+
+	presets[2].vertexColor = VK_FALSE;
+
+	presets[3].alphaTest = VK_TRUE;
+
+	presets[4].textureTaps = kMAX_TEXTURE_TAPS;
+
+	return presets;
+}
+
+std::string getShaderPermutationName(const ShaderPermutation& permutation) {
+	std::string name = permutation.textured ? "textured" : "untextured";
+
+	if (permutation.vertexColor) {
+		name += ", vertex color";
+	}
+
+	if (permutation.alphaTest) {
+		char cutoff[16];
+		snprintf(cutoff, sizeof(cutoff), "%.2f", permutation.alphaCutoff);
+		name += ", alpha test " + std::string(cutoff);
+	}
+
+	if (permutation.textured && permutation.textureTaps > 1) {
+		name += ", " + std::to_string(permutation.textureTaps) + " taps";
+	}
+
+	return name;
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "headers/VulkanApplicationStagingRing.h"
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+VulkanApplicationStagingRing::VulkanApplicationStagingRing(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkDeviceSize capacity) {
+	this->logicalDevice = logicalDevice;
+	this->allocator = &allocator;
+	this->capacity = capacity;
+
+	createBuffer(logicalDevice, allocator, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, ringBuffer, ringAllocation);
+}
+
+VulkanApplicationStagingRing::~VulkanApplicationStagingRing() {}
+
+void VulkanApplicationStagingRing::cleanup() {
+	if (debug) { printStats(); }
+
+	for (const PendingBatch& batch : pendingBatches) {
+		vkDestroyFence(logicalDevice, batch.fence, nullptr);
+	}
+	pendingBatches.clear();
+
+	for (VkFence fence : freeFences) {
+		vkDestroyFence(logicalDevice, fence, nullptr);
+	}
+	freeFences.clear();
+
+	for (OversizedBuffer& oversized : oversizedBuffers) {
+		destroyBuffer(logicalDevice, *allocator, oversized.buffer, oversized.allocation);
+	}
+	oversizedBuffers.clear();
+
+	destroyBuffer(logicalDevice, *allocator, ringBuffer, ringAllocation);
+}
+
+StagingRegion VulkanApplicationStagingRing::reserve(VkDeviceSize size, VkDeviceSize alignment) {
+	if (size > capacity) {
+		return reserveOversized(size);
+	}
+
+	if (capacity % alignment != 0) {
+		throw std::invalid_argument("Staging Alignment Must Divide the Ring Capacity");
+	}
+
+	retire();
+
+	while (true) {
+		// nothing staged or in flight, restart at the top of the buffer so a large region can't be stuck behind the wrap
+		if (head == tail) {
+			head = alignUp(head, capacity);
+			tail = head;
+			committedHead = head;
+		}
+
+		uint64_t start = findStart(size, alignment);
+
+		if (start + size - tail <= capacity) {
+			head = start + size;
+
+			stats.reservations++;
+			stats.bytesStaged += size;
+			stats.peakBytesInFlight = std::max<VkDeviceSize>(stats.peakBytesInFlight, head - tail);
+
+			VkDeviceSize offset = start % capacity;
+			return { ringBuffer, offset, size, static_cast<char*>(ringAllocation.mapped) + offset };
+		}
+
+		if (pendingBatches.empty()) {
+			throw std::runtime_error("Staging Ring Full, Commit Pending Uploads Before Reserving More");
+		}
+
+		stats.stalls++;
+		waitForOldestBatch();
+	}
+}
+
+uint64_t VulkanApplicationStagingRing::findStart(VkDeviceSize size, VkDeviceSize alignment) {
+	uint64_t start = alignUp(head, alignment);
+
+	// a region never straddles the end of the buffer, skip to the start of the next lap instead
+	if ((start % capacity) + size > capacity) {
+		start = alignUp(start + 1, capacity);
+	}
+
+	return start;
+}
+
+bool VulkanApplicationStagingRing::canReserve(VkDeviceSize size, VkDeviceSize alignment) {
+	if (size > capacity || head == committedHead) {
+		return true;
+	}
+
+	// space held by committed batches always comes back, only the open batch can block a reservation forever
+	return findStart(size, alignment) + size - committedHead <= capacity;
+}
+
+StagingRegion VulkanApplicationStagingRing::reserveOversized(VkDeviceSize size) {
+	OversizedBuffer oversized{};
+	oversized.batchId = nextBatchId;
+
+	createBuffer(logicalDevice, *allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, oversized.buffer, oversized.allocation);
+	oversizedBuffers.push_back(oversized);
+
+	stats.oversizedUploads++;
+	stats.reservations++;
+	stats.bytesStaged += size;
+
+	return { oversized.buffer, 0, size, oversized.allocation.mapped };
+}
+
+StagingBatch VulkanApplicationStagingRing::commit() {
+	VkFence fence;
+
+	if (!freeFences.empty()) {
+		fence = freeFences.back();
+		freeFences.pop_back();
+	} else {
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (vkCreateFence(logicalDevice, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to Create Staging Fence");
+		}
+	}
+
+	PendingBatch batch{ nextBatchId++, fence, head };
+	committedHead = head;
+	pendingBatches.push_back(batch);
+	stats.batchesCommitted++;
+
+	return { batch.id, batch.fence };
+}
+
+void VulkanApplicationStagingRing::retire() {
+	// batches are submitted in order, so the first unsignaled fence ends the scan
+	while (!pendingBatches.empty() && vkGetFenceStatus(logicalDevice, pendingBatches.front().fence) == VK_SUCCESS) {
+		PendingBatch& batch = pendingBatches.front();
+		tail = std::max(tail, batch.end);
+		completedBatchId = batch.id;
+
+		vkResetFences(logicalDevice, 1, &batch.fence);
+		freeFences.push_back(batch.fence);
+		pendingBatches.pop_front();
+	}
+
+	for (size_t i = 0; i < oversizedBuffers.size();) {
+		if (oversizedBuffers[i].batchId <= completedBatchId) {
+			destroyBuffer(logicalDevice, *allocator, oversizedBuffers[i].buffer, oversizedBuffers[i].allocation);
+			oversizedBuffers.erase(oversizedBuffers.begin() + i);
+		} else {
+			i++;
+		}
+	}
+}
+
+void VulkanApplicationStagingRing::waitForOldestBatch() {
+	vkWaitForFences(logicalDevice, 1, &pendingBatches.front().fence, VK_TRUE, UINT64_MAX);
+	retire();
+}
+
+bool VulkanApplicationStagingRing::isBatchComplete(uint64_t batchId) {
+	retire();
+	return batchId <= completedBatchId;
+}
+
+void VulkanApplicationStagingRing::waitForBatch(uint64_t batchId) {
+	while (completedBatchId < batchId && !pendingBatches.empty()) {
+		waitForOldestBatch();
+	}
+}
+
+VkDeviceSize VulkanApplicationStagingRing::getCapacity() {
+	return this->capacity;
+}
+
+VkBuffer VulkanApplicationStagingRing::getBuffer() {
+	return this->ringBuffer;
+}
+
+StagingRingStats VulkanApplicationStagingRing::getStats() {
+	return this->stats;
+}
+
+void VulkanApplicationStagingRing::printStats() {
+	cout << "Staging Ring: " << stats.bytesStaged / 1024 << " KiB staged in " << stats.reservations << " reservations, "
+		<< stats.batchesCommitted << " batches" << endl;
+	cout << "  peak in flight: " << stats.peakBytesInFlight / 1024 << " KiB of " << capacity / 1024 << " KiB" << endl;
+	cout << "  stalls: " << stats.stalls << ", oversized uploads: " << stats.oversizedUploads << endl;
+}
\ No newline at end of file
@@ -0,0 +1,495 @@
+#include "headers/VulkanApplicationStreamingTexture.h"
+#include <cmath>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define MIPMAP_SSE
+#include <immintrin.h>
+#endif
+
+VulkanApplicationStreamingTexture::VulkanApplicationStreamingTexture(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, const std::string& path,
+	bool gpuMipmaps, bool blockCompression, VkDeviceSize budget) {
+	this->logicalDevice = logicalDevice;
+	this->allocator = &allocator;
+	this->path = path;
+	this->format = VK_FORMAT_UNDEFINED;
+	this->gpuMipmaps = gpuMipmaps;
+	this->blockCompression = blockCompression;
+	this->budget = std::max(budget, kMIN_TEXTURE_STREAMING_BUDGET);
+	startTime = std::chrono::high_resolution_clock::now();
+
+	// everything the job touches stays alive until cleanup() waited for it
+	decodeJob = getJobSystem().scheduleBackground([this]() { decode(); });
+}
+
+VulkanApplicationStreamingTexture::~VulkanApplicationStreamingTexture() {}
+
+void VulkanApplicationStreamingTexture::cleanup() {
+	// a failed decode has nothing to clean up, and cleanup shouldn't throw
+	if (decodeJob.job && !decoded) {
+		try {
+			getJobSystem().wait(decodeJob);
+		}
+		catch (const std::exception&) {}
+	}
+
+	destroyResidency(resident);
+	destroyResidency(pending);
+
+	for (TextureResidency& residency : retired) {
+		destroyResidency(residency);
+	}
+
+	retired.clear();
+}
+
+void VulkanApplicationStreamingTexture::decode() {
+	auto decodeStart = std::chrono::high_resolution_clock::now();
+
+	if (isTextureContainerPath(path)) {
+		TextureContainer container = loadTextureContainer(path);
+		format = container.format;
+		mips = std::move(container.mips);
+
+		// without device support the blocks are expanded here, 4 to 8 times the memory but it still draws
+		if (isBlockCompressed(format) && !blockCompression) {
+			for (TextureMip& mip : mips) {
+				mip = decompressMip(format, mip);
+			}
+
+			format = getDecompressedFormat(format);
+		}
+
+		if (!isBlockCompressed(format) && mips.size() == 1) {
+			TextureMip top = std::move(mips[0]);
+			mips = generateMipChain(top.pixels.data(), top.width, top.height, getDecompressedFormat(format) == VK_FORMAT_R8G8B8A8_SRGB);
+		}
+
+		decodeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - decodeStart).count();
+		return;
+	}
+
+	format = VK_FORMAT_R8G8B8A8_SRGB;
+
+	int texWidth, texHeight, texChannels;
+	stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+	if (!pixels) {
+		throw std::runtime_error("Failed to Load Texture");
+	}
+
+	mips = generateMipChain(pixels, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), true);
+	stbi_image_free(pixels);
+
+	decodeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - decodeStart).count();
+}
+
+// srgb bytes to 16 bit linear light and back, the nearest byte for every linear value. round trips exactly
+struct SrgbTables {
+	std::array<uint16_t, 256> toLinear;
+	std::vector<uint8_t> toSrgb;
+};
+
+static const SrgbTables& getSrgbTables() {
+	static const SrgbTables tables = []() {
+		SrgbTables built;
+
+		for (uint32_t i = 0; i < 256; i++) {
+			float encoded = i / 255.0f;
+			float linear = encoded <= 0.04045f ? encoded / 12.92f : std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+			built.toLinear[i] = static_cast<uint16_t>(std::lround(linear * 65535.0f));
+		}
+
+		built.toSrgb.resize(65536);
+		uint32_t encoded = 0;
+
+		for (uint32_t linear = 0; linear < 65536; linear++) {
+			// past the midpoint to the next byte's linear value, that one is closer
+			while (encoded < 255 && linear * 2 >= static_cast<uint32_t>(built.toLinear[encoded]) + built.toLinear[encoded + 1]) {
+				encoded++;
+			}
+
+			built.toSrgb[linear] = static_cast<uint8_t>(encoded);
+		}
+
+		return built;
+	}();
+
+	return tables;
+}
+
+// rounded average of the 2x2 block above each texel, a side of 1 repeats its only row or column
+static void downsampleMipScalar(const TextureMip& source, TextureMip& mip, uint32_t firstX, uint32_t y) {
+	uint32_t y0 = std::min(y * 2, source.height - 1);
+	uint32_t y1 = std::min(y * 2 + 1, source.height - 1);
+
+	for (uint32_t x = firstX; x < mip.width; x++) {
+		uint32_t x0 = std::min(x * 2, source.width - 1);
+		uint32_t x1 = std::min(x * 2 + 1, source.width - 1);
+
+		const uint8_t* a = &source.pixels[(static_cast<size_t>(y0) * source.width + x0) * 4];
+		const uint8_t* b = &source.pixels[(static_cast<size_t>(y0) * source.width + x1) * 4];
+		const uint8_t* c = &source.pixels[(static_cast<size_t>(y1) * source.width + x0) * 4];
+		const uint8_t* d = &source.pixels[(static_cast<size_t>(y1) * source.width + x1) * 4];
+		uint8_t* out = &mip.pixels[(static_cast<size_t>(y) * mip.width + x) * 4];
+
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			out[channel] = static_cast<uint8_t>((a[channel] + b[channel] + c[channel] + d[channel] + 2) / 4);
+		}
+	}
+}
+
+// same block in linear light, alpha isn't srgb encoded and averages as it is
+static void downsampleMipSrgb(const TextureMip& source, TextureMip& mip, uint32_t y) {
+	const SrgbTables& tables = getSrgbTables();
+	uint32_t y0 = std::min(y * 2, source.height - 1);
+	uint32_t y1 = std::min(y * 2 + 1, source.height - 1);
+
+	for (uint32_t x = 0; x < mip.width; x++) {
+		uint32_t x0 = std::min(x * 2, source.width - 1);
+		uint32_t x1 = std::min(x * 2 + 1, source.width - 1);
+
+		const uint8_t* a = &source.pixels[(static_cast<size_t>(y0) * source.width + x0) * 4];
+		const uint8_t* b = &source.pixels[(static_cast<size_t>(y0) * source.width + x1) * 4];
+		const uint8_t* c = &source.pixels[(static_cast<size_t>(y1) * source.width + x0) * 4];
+		const uint8_t* d = &source.pixels[(static_cast<size_t>(y1) * source.width + x1) * 4];
+		uint8_t* out = &mip.pixels[(static_cast<size_t>(y) * mip.width + x) * 4];
+
+		for (uint32_t channel = 0; channel < 3; channel++) {
+			uint32_t sum = tables.toLinear[a[channel]] + tables.toLinear[b[channel]] + tables.toLinear[c[channel]] + tables.toLinear[d[channel]];
+			out[channel] = tables.toSrgb[(sum + 2) / 4];
+		}
+
+		out[3] = static_cast<uint8_t>((a[3] + b[3] + c[3] + d[3] + 2) / 4);
+	}
+}
+
+#if defined(MIPMAP_SSE)
+// 4 output texels per step, returns the first one it didn't write
+static uint32_t downsampleRowSse(const TextureMip& source, TextureMip& mip, uint32_t y) {
+	const uint8_t* row0 = &source.pixels[static_cast<size_t>(y) * 2 * source.width * 4];
+	const uint8_t* row1 = row0 + static_cast<size_t>(source.width) * 4;
+	uint8_t* out = &mip.pixels[static_cast<size_t>(y) * mip.width * 4];
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rounding = _mm_set1_epi16(2);
+	uint32_t x = 0;
+
+	for (; x + 4 <= mip.width; x += 4) {
+		__m128i top0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+		__m128i top1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8 + 16));
+		__m128i bottom0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+		__m128i bottom1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8 + 16));
+
+		// widened to 16 bits and summed vertically, each register holds one horizontal pair
+		__m128i pair0 = _mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero));
+		__m128i pair1 = _mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero));
+		__m128i pair2 = _mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero));
+		__m128i pair3 = _mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero));
+
+		// the right texel of each pair added onto the left one
+		pair0 = _mm_add_epi16(pair0, _mm_srli_si128(pair0, 8));
+		pair1 = _mm_add_epi16(pair1, _mm_srli_si128(pair1, 8));
+		pair2 = _mm_add_epi16(pair2, _mm_srli_si128(pair2, 8));
+		pair3 = _mm_add_epi16(pair3, _mm_srli_si128(pair3, 8));
+
+		__m128i sums01 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(pair0, pair1), rounding), 2);
+		__m128i sums23 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(pair2, pair3), rounding), 2);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(sums01, sums23));
+	}
+
+	return x;
+}
+#endif
+
+// same result with or without simd, odd sizes round down and drop the last row or column
+void downsampleMip(const TextureMip& source, TextureMip& mip, bool srgb, bool useSimd) {
+	mip.width = std::max(source.width / 2, 1u);
+	mip.height = std::max(source.height / 2, 1u);
+	mip.pixels.resize(static_cast<size_t>(mip.width) * mip.height * 4);
+
+	// the simd rows always read a full 2x2 block, sides of 1 go through the scalar path
+	useSimd = useSimd && source.width >= 2 && source.height >= 2;
+
+	for (uint32_t y = 0; y < mip.height; y++) {
+		if (srgb) {
+			downsampleMipSrgb(source, mip, y);
+			continue;
+		}
+
+		uint32_t firstX = 0;
+
+#if defined(MIPMAP_SSE)
+		if (useSimd) {
+			firstX = downsampleRowSse(source, mip, y);
+		}
+#endif
+
+		downsampleMipScalar(source, mip, firstX, y);
+	}
+}
+
+std::vector<TextureMip> generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, bool useSimd) {
+	uint32_t mipCount = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+	std::vector<TextureMip> chain(mipCount);
+
+	chain[0].width = width;
+	chain[0].height = height;
+	chain[0].pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+	for (uint32_t level = 1; level < mipCount; level++) {
+		downsampleMip(chain[level - 1], chain[level], srgb, useSimd);
+	}
+
+	return chain;
+}
+
+const char* getMipmapSimdName() {
+#if defined(MIPMAP_SSE)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
+
+VkDeviceSize VulkanApplicationStreamingTexture::getChainBytes(uint32_t topMip) {
+	VkDeviceSize bytes = 0;
+
+	for (uint32_t level = topMip; level < mips.size(); level++) {
+		bytes += mips[level].pixels.size();
+	}
+
+	return bytes;
+}
+
+// biggest level that still fits, a level also has to fit in the staging ring on its own
+uint32_t VulkanApplicationStreamingTexture::getTargetTopMip() {
+	uint32_t lastMip = static_cast<uint32_t>(mips.size()) - 1;
+
+	for (uint32_t level = 0; level < lastMip; level++) {
+		if (getChainBytes(level) <= budget && mips[level].pixels.size() <= kSTAGING_RING_SIZE) {
+			return level;
+		}
+	}
+
+	return lastMip;
+}
+
+void VulkanApplicationStreamingTexture::upload(uint32_t topMip, VulkanApplicationUploadContext& uploadContext) {
+	uint32_t mipCount = static_cast<uint32_t>(mips.size()) - topMip;
+	// blocks can't be blitted, compressed levels always come from the file
+	bool blitMips = gpuMipmaps && !isBlockCompressed(format) && mipCount > 1;
+
+	pending.topMip = topMip;
+	pending.bytes = getChainBytes(topMip);
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | (blitMips ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+	createImage(mips[topMip].width, mips[topMip].height, format, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		pending.image, pending.allocation, logicalDevice, *allocator, mipCount);
+	pending.view = createImageView(pending.image, format, logicalDevice, VK_IMAGE_ASPECT_COLOR_BIT, mipCount);
+
+	if (blitMips) {
+		const TextureMip& mip = mips[topMip];
+		StagingRegion staging = uploadContext.stage(mip.pixels.data(), mip.pixels.size(), 16);
+		uploadContext.copyBufferToImage(staging, pending.image, mip.width, mip.height, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		uploadContext.generateMipmaps(pending.image, mip.width, mip.height, mipCount, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	} else {
+		// level 0 of the new image is level topMip of the chain
+		for (uint32_t level = 0; level < mipCount; level++) {
+			const TextureMip& mip = mips[topMip + level];
+			StagingRegion staging = uploadContext.stage(mip.pixels.data(), mip.pixels.size(), 16);
+			uploadContext.copyBufferToImage(staging, pending.image, mip.width, mip.height, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, level);
+		}
+	}
+
+	// batches retire in order, the last ticket covers any batch stage() had to flush early
+	pending.ticket = uploadContext.submit();
+	stats.uploads++;
+}
+
+void VulkanApplicationStreamingTexture::destroyResidency(TextureResidency& residency) {
+	if (residency.view != VK_NULL_HANDLE) {
+		vkDestroyImageView(logicalDevice, residency.view, nullptr);
+		residency.view = VK_NULL_HANDLE;
+	}
+
+	if (residency.image != VK_NULL_HANDLE) {
+		destroyImage(logicalDevice, *allocator, residency.image, residency.allocation);
+		residency.image = VK_NULL_HANDLE;
+	}
+}
+
+// call once per frame after its fence wait, returns true when getImageView() changed
+bool VulkanApplicationStreamingTexture::update(VulkanApplicationUploadContext& uploadContext, uint64_t frameNumber) {
+	// every frame that could sample a retired image has finished by now
+	for (size_t i = 0; i < retired.size();) {
+		if (frameNumber >= retired[i].retireFrame + kMAX_FRAMES_IN_FLIGHT) {
+			destroyResidency(retired[i]);
+			retired[i] = retired.back();
+			retired.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+
+	if (failed) {
+		return false;
+	}
+
+	if (!decoded) {
+		// with a single thread there's no worker to pick the decode up, it runs here
+		if (!getJobSystem().isFinished(decodeJob) && getJobSystem().getThreadCount() > 1) {
+			return false;
+		}
+
+		// a bad file shouldn't take the renderer down, the placeholder stays bound instead
+		try {
+			getJobSystem().wait(decodeJob);
+		}
+		catch (const std::exception& error) {
+			failed = true;
+			cerr << "Texture Streaming: " << path << " failed to load, " << error.what() << endl;
+			return false;
+		}
+
+		decoded = true;
+		stats.decodeSeconds = decodeSeconds;
+	}
+
+	bool changed = false;
+
+	if (pending.image != VK_NULL_HANDLE) {
+		if (!uploadContext.isComplete(pending.ticket)) {
+			return false;
+		}
+
+		if (resident.image != VK_NULL_HANDLE) {
+			resident.retireFrame = frameNumber;
+			retired.push_back(resident);
+
+			if (pending.topMip > resident.topMip) {
+				stats.evictions++;
+			}
+		}
+		else {
+			stats.firstResidentSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+			if (debug) {
+				cout << "Texture Streaming: " << path << " (" << getFormatName(format) << ") decoded in " << stats.decodeSeconds * 1000.0 << " ms, first mips resident after "
+					<< stats.firstResidentSeconds * 1000.0 << " ms" << endl;
+			}
+		}
+
+		resident = pending;
+		pending = TextureResidency{};
+		changed = true;
+
+		if (resident.topMip == 0 && stats.fullResidentSeconds == 0.0) {
+			stats.fullResidentSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+			if (debug) {
+				cout << "Texture Streaming: " << path << " full resolution after " << stats.fullResidentSeconds * 1000.0 << " ms" << endl;
+			}
+		}
+	}
+
+	uint32_t targetMip = getTargetTopMip();
+	uint32_t nextMip;
+
+	if (resident.image == VK_NULL_HANDLE) {
+		// the first upload only takes the small levels so it lands quickly
+		nextMip = 0;
+
+		while (nextMip + 1 < mips.size() && std::max(mips[nextMip].width, mips[nextMip].height) > kSTREAMING_FIRST_MIP_SIZE) {
+			nextMip++;
+		}
+
+		nextMip = std::max(nextMip, targetMip);
+	}
+	else if (resident.topMip > targetMip) {
+		// one level per upload, each one is four times the last
+		nextMip = resident.topMip - 1;
+	}
+	else {
+		// over budget drops straight to what fits
+		nextMip = targetMip;
+	}
+
+	if (resident.image == VK_NULL_HANDLE || nextMip != resident.topMip) {
+		upload(nextMip, uploadContext);
+	}
+
+	return changed;
+}
+
+VkImageView VulkanApplicationStreamingTexture::getImageView() {
+	return this->resident.view;
+}
+
+bool VulkanApplicationStreamingTexture::isResident() {
+	return this->resident.view != VK_NULL_HANDLE;
+}
+
+bool VulkanApplicationStreamingTexture::isFailed() {
+	return this->failed;
+}
+
+// no decode running and no upload the transfer queue could still be writing, cleanup() won't wait on anything
+bool VulkanApplicationStreamingTexture::isIdle(VulkanApplicationUploadContext& uploadContext) {
+	return getJobSystem().isFinished(decodeJob) && (pending.image == VK_NULL_HANDLE || uploadContext.isComplete(pending.ticket));
+}
+
+uint32_t VulkanApplicationStreamingTexture::getResidentMip() {
+	return this->resident.topMip;
+}
+
+uint32_t VulkanApplicationStreamingTexture::getMipCount() {
+	return decoded ? static_cast<uint32_t>(this->mips.size()) : 0;
+}
+
+VkDeviceSize VulkanApplicationStreamingTexture::getResidentBytes() {
+	return this->resident.bytes;
+}
+
+VkDeviceSize VulkanApplicationStreamingTexture::getBudget() {
+	return this->budget;
+}
+
+void VulkanApplicationStreamingTexture::setBudget(VkDeviceSize budget) {
+	this->budget = std::max(budget, kMIN_TEXTURE_STREAMING_BUDGET);
+}
+
+StreamingTextureStats VulkanApplicationStreamingTexture::getStats() {
+	return this->stats;
+}
+
+/***** BENCHMARK *****/
+
+// full chain of a random rgba8 image, with and without simd, results have to match exactly. srgb is scalar only and timed on its own
+void runMipmapBenchmark(uint32_t size) {
+	// odd so the last column of every level takes the scalar tail
+	uint32_t width = size + 1;
+	uint32_t height = size;
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+	std::mt19937 random(42);
+
+	for (uint8_t& value : pixels) {
+		value = static_cast<uint8_t>(random());
+	}
+
+	std::vector<TextureMip> scalarChain = generateMipChain(pixels.data(), width, height, false, false);
+	std::vector<TextureMip> simdChain = generateMipChain(pixels.data(), width, height, false, true);
+
+	for (size_t level = 0; level < scalarChain.size(); level++) {
+		if (scalarChain[level].pixels != simdChain[level].pixels) {
+			throw std::runtime_error("Mipmap Benchmark Results Differ");
+		}
+	}
+
+	double scalarSeconds = timeBenchmark([&]() { scalarChain = generateMipChain(pixels.data(), width, height, false, false); });
+	double simdSeconds = timeBenchmark([&]() { simdChain = generateMipChain(pixels.data(), width, height, false, true); });
+	double srgbSeconds = timeBenchmark([&]() { scalarChain = generateMipChain(pixels.data(), width, height, true); });
+
+	cout << "Mipmap Benchmark: " << width << "x" << height << ", " << scalarChain.size() << " levels" << endl;
+	cout << "  Scalar: " << scalarSeconds * 1e3 << " ms" << endl;
+	cout << "  " << getMipmapSimdName() << ": " << simdSeconds * 1e3 << " ms (" << scalarSeconds / simdSeconds << "x)" << endl;
+	cout << "  sRGB, linear space: " << srgbSeconds * 1e3 << " ms" << endl;
+}
\ No newline at end of file
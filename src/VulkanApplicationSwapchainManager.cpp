@@ -7,10 +7,9 @@ VulkanApplicationSwapchainManager::VulkanApplicationSwapchainManager(VkPhysicalD
 
 VulkanApplicationSwapchainManager::~VulkanApplicationSwapchainManager() {}
 
-void VulkanApplicationSwapchainManager::cleanup(VkDevice logicalDevice) {
+void VulkanApplicationSwapchainManager::cleanup(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator) {
 	vkDestroyImageView(logicalDevice, depthImageView, nullptr);
-	vkDestroyImage(logicalDevice, depthImage, nullptr);
-	vkFreeMemory(logicalDevice, depthImageMemory, nullptr);
+	destroyImage(logicalDevice, allocator, depthImage, depthImageAllocation);
 	for (size_t i = 0; i < swapchainFramebuffers.size(); i++) {
 		vkDestroyFramebuffer(logicalDevice, swapchainFramebuffers[i], nullptr);
 	}
@@ -46,7 +45,7 @@ std::vector<VkFramebuffer> VulkanApplicationSwapchainManager::getSwapchainFrameb
 	return this->swapchainFramebuffers;
 }
 
-void VulkanApplicationSwapchainManager::recreateSwapchain(VkPhysicalDevice physicalDevice, VkDevice logicalDevice, VkSurfaceKHR surface, GLFWwindow* window, VkRenderPass renderPass, VkQueue graphicsQueue, VkCommandPool commandPool) {
+void VulkanApplicationSwapchainManager::recreateSwapchain(VkPhysicalDevice physicalDevice, VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkSurfaceKHR surface, GLFWwindow* window, VkRenderPass renderPass, VulkanApplicationUploadContext& uploadContext) {
 	int width = 0, height = 0;
 	glfwGetFramebufferSize(window, &width, &height);
 
@@ -57,23 +56,23 @@ void VulkanApplicationSwapchainManager::recreateSwapchain(VkPhysicalDevice physi
 
 	vkDeviceWaitIdle(logicalDevice);
 
-	cleanup(logicalDevice);
+	cleanup(logicalDevice, allocator);
 
 	createSwapchain(physicalDevice, logicalDevice, surface, window);
 	createImageViews(logicalDevice);
-	createDepthResources(logicalDevice, physicalDevice, graphicsQueue, commandPool);
+	createDepthResources(logicalDevice, physicalDevice, allocator, uploadContext);
 	createFrameBuffer(logicalDevice, renderPass);
+	uploadContext.submit();
 }
 
-void VulkanApplicationSwapchainManager::createDepthResources(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool) {
+void VulkanApplicationSwapchainManager::createDepthResources(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext) {
 	VkFormat depthFormat = findDepthFormat(physicalDevice);
 	createImage(swapchainExtent.width, swapchainExtent.height, depthFormat,
 		VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		depthImage, depthImageMemory, logicalDevice, physicalDevice);
+		depthImage, depthImageAllocation, logicalDevice, allocator);
 
 	depthImageView = createImageView(depthImage, depthFormat, logicalDevice, VK_IMAGE_ASPECT_DEPTH_BIT);
-	transitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-		commandPool, logicalDevice, graphicsQueue);
+	uploadContext.transitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 }
 
 void VulkanApplicationSwapchainManager::createImageViews(VkDevice logicalDevice) {
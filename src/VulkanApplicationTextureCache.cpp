@@ -0,0 +1,254 @@
+#include "headers/VulkanApplicationTextureCache.h"
+
+VulkanApplicationTextureCache::VulkanApplicationTextureCache(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator,
+	VkImageView placeholderView, bool gpuMipmaps, bool blockCompression) {
+	this->logicalDevice = logicalDevice;
+	this->allocator = &allocator;
+	this->placeholderView = placeholderView;
+	this->gpuMipmaps = gpuMipmaps;
+	this->blockCompression = blockCompression;
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+}
+
+VulkanApplicationTextureCache::~VulkanApplicationTextureCache() {}
+
+// the caller has waited for the device, released textures don't have to wait out any frames
+void VulkanApplicationTextureCache::cleanup() {
+	for (uint32_t index : releasedTextures) {
+		destroyTexture(index);
+	}
+
+	// whatever is left is still held by someone
+	for (CachedImage& image : images) {
+		if (image.texture) {
+			if (debug) {
+				cout << "Texture Cache: " << image.path << " still referenced at cleanup" << endl;
+			}
+
+			image.texture->cleanup();
+		}
+	}
+
+	for (auto& [key, sampler] : samplers) {
+		vkDestroySampler(logicalDevice, sampler, nullptr);
+	}
+
+	images.clear();
+	textures.clear();
+	imagesByPath.clear();
+	texturesByKey.clear();
+	samplers.clear();
+	releasedTextures.clear();
+}
+
+// the same file reached through different relative paths or links is still one key
+std::string getCanonicalTexturePath(const std::string& path) {
+	std::error_code error;
+	std::filesystem::path canonicalPath = std::filesystem::weakly_canonical(path, error);
+
+	// still has to key something, a missing file fails once its decode runs
+	if (error) {
+		return std::filesystem::path(path).lexically_normal().generic_string();
+	}
+
+	return canonicalPath.generic_string();
+}
+
+std::string getSamplingKey(const TextureSampling& sampling) {
+	return std::to_string(sampling.filter) + ":" + std::to_string(sampling.addressMode) + ":" + (sampling.anisotropy ? "1" : "0");
+}
+
+VkSampler VulkanApplicationTextureCache::acquireSampler(const TextureSampling& sampling) {
+	std::string key = getSamplingKey(sampling);
+	auto found = samplers.find(key);
+
+	if (found != samplers.end()) {
+		return found->second;
+	}
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = sampling.filter; // linear helps with oversampling
+	samplerInfo.minFilter = sampling.filter; // and undersampling
+
+	// UVW = XYZ, what to do with image once we hit the bounds of it
+	samplerInfo.addressModeU = sampling.addressMode;
+	samplerInfo.addressModeV = sampling.addressMode;
+	samplerInfo.addressModeW = sampling.addressMode;
+
+	samplerInfo.anisotropyEnable = sampling.anisotropy ? VK_TRUE : VK_FALSE;
+	samplerInfo.maxAnisotropy = sampling.anisotropy ? maxAnisotropy : 1.0f;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+	samplerInfo.compareEnable = VK_FALSE; // mainly used for percentage-closer filtering on shadow maps
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = sampling.filter == VK_FILTER_NEAREST ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE; // the image view decides how many levels there are
+
+	VkSampler sampler;
+
+	if (vkCreateSampler(logicalDevice, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Texture Sampler");
+	}
+
+	samplers[key] = sampler;
+	return sampler;
+}
+
+// one streaming texture per file, its decode job starts right away
+uint32_t VulkanApplicationTextureCache::acquireImage(const std::string& path, const std::string& canonicalPath) {
+	auto found = imagesByPath.find(canonicalPath);
+
+	if (found != imagesByPath.end()) {
+		stats.imageShares++;
+		images[found->second].references++;
+		return found->second;
+	}
+
+	uint32_t index;
+
+	if (!freeImages.empty()) {
+		index = freeImages.back();
+		freeImages.pop_back();
+	} else {
+		index = static_cast<uint32_t>(images.size());
+		images.emplace_back();
+	}
+
+	CachedImage& image = images[index];
+	image.path = canonicalPath;
+	image.texture = std::make_unique<VulkanApplicationStreamingTexture>(logicalDevice, *allocator, path, gpuMipmaps, blockCompression);
+	image.references = 1;
+
+	imagesByPath[canonicalPath] = index;
+	stats.imageLoads++;
+	return index;
+}
+
+TextureHandle VulkanApplicationTextureCache::acquire(const std::string& path, const TextureSampling& sampling) {
+	std::string canonicalPath = getCanonicalTexturePath(path);
+	std::string key = canonicalPath + "|" + getSamplingKey(sampling);
+	stats.requests++;
+
+	auto found = texturesByKey.find(key);
+
+	if (found != texturesByKey.end()) {
+		CachedTexture& texture = textures[found->second];
+
+		// picked up again before it was destroyed
+		if (texture.references == 0) {
+			releasedTextures.erase(std::find(releasedTextures.begin(), releasedTextures.end(), found->second));
+		}
+
+		texture.references++;
+		stats.hits++;
+		return TextureHandle{ found->second };
+	}
+
+	uint32_t index;
+
+	if (!freeTextures.empty()) {
+		index = freeTextures.back();
+		freeTextures.pop_back();
+	} else {
+		index = static_cast<uint32_t>(textures.size());
+		textures.emplace_back();
+	}
+
+	CachedTexture& texture = textures[index];
+	texture.key = key;
+	texture.image = acquireImage(path, canonicalPath);
+	texture.sampler = acquireSampler(sampling);
+	texture.references = 1;
+
+	texturesByKey[key] = index;
+	return TextureHandle{ index };
+}
+
+void VulkanApplicationTextureCache::release(TextureHandle handle) {
+	CachedTexture& texture = textures[handle.index];
+
+	if (--texture.references == 0) {
+		texture.retireFrame = frameNumber;
+		releasedTextures.push_back(handle.index);
+	}
+}
+
+// the image goes with the last texture sampling it, it can't go while the transfer queue might still write into it
+bool VulkanApplicationTextureCache::canDestroyTexture(uint32_t index, VulkanApplicationUploadContext& uploadContext) {
+	CachedTexture& texture = textures[index];
+	CachedImage& image = images[texture.image];
+
+	return frameNumber >= texture.retireFrame + kMAX_FRAMES_IN_FLIGHT && (image.references > 1 || image.texture->isIdle(uploadContext));
+}
+
+void VulkanApplicationTextureCache::destroyTexture(uint32_t index) {
+	CachedTexture& texture = textures[index];
+	CachedImage& image = images[texture.image];
+
+	if (--image.references == 0) {
+		image.texture->cleanup();
+		image.texture.reset();
+		imagesByPath.erase(image.path);
+		freeImages.push_back(texture.image);
+	}
+
+	texturesByKey.erase(texture.key);
+	texture = CachedTexture{};
+	freeTextures.push_back(index);
+	stats.evictions++;
+}
+
+// call once per frame after its fence wait, returns true when any texture's view changed
+bool VulkanApplicationTextureCache::update(VulkanApplicationUploadContext& uploadContext, uint64_t frameNumber) {
+	this->frameNumber = frameNumber;
+
+	for (size_t i = 0; i < releasedTextures.size();) {
+		if (canDestroyTexture(releasedTextures[i], uploadContext)) {
+			destroyTexture(releasedTextures[i]);
+			releasedTextures[i] = releasedTextures.back();
+			releasedTextures.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+
+	bool changed = false;
+
+	for (CachedImage& image : images) {
+		if (image.texture && image.texture->update(uploadContext, frameNumber)) {
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+// changes as levels stream in, descriptors have to be checked against it every frame
+VkImageView VulkanApplicationTextureCache::getImageView(TextureHandle handle) {
+	VulkanApplicationStreamingTexture& texture = getStreamingTexture(handle);
+	return texture.isResident() ? texture.getImageView() : this->placeholderView;
+}
+
+VkSampler VulkanApplicationTextureCache::getSampler(TextureHandle handle) {
+	return this->textures[handle.index].sampler;
+}
+
+VulkanApplicationStreamingTexture& VulkanApplicationTextureCache::getStreamingTexture(TextureHandle handle) {
+	return *this->images[this->textures[handle.index].image].texture;
+}
+
+uint32_t VulkanApplicationTextureCache::getImageCount() {
+	return static_cast<uint32_t>(this->imagesByPath.size());
+}
+
+TextureCacheStats VulkanApplicationTextureCache::getStats() {
+	return this->stats;
+}
\ No newline at end of file
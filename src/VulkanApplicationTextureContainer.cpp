@@ -0,0 +1,449 @@
+#include "headers/VulkanApplicationTextureContainer.h"
+#include "headers/VulkanApplicationStreamingTexture.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+static const uint8_t kKTX2_IDENTIFIER[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+static const uint32_t kDDS_MAGIC = 0x20534444; // "DDS "
+
+struct Ktx2Header {
+	uint8_t identifier[12];
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+};
+
+struct Ktx2Level {
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+};
+
+struct DdsPixelFormat {
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t bitMasks[4];
+};
+
+struct DdsHeader {
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth;
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];
+	DdsPixelFormat pixelFormat;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+
+struct DdsHeaderDx10 {
+	uint32_t dxgiFormat;
+	uint32_t resourceDimension;
+	uint32_t miscFlag;
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+};
+
+static_assert(sizeof(Ktx2Header) == 80, "KTX2 header has to match the file layout");
+static_assert(sizeof(DdsHeader) == 124, "DDS header has to match the file layout");
+
+static bool isContainerFormat(VkFormat format) {
+	return isBlockCompressed(format) || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+static constexpr uint32_t makeFourCC(char a, char b, char c, char d) {
+	return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+static VkFormat getDxgiFormat(uint32_t dxgiFormat) {
+	switch (dxgiFormat) {
+		case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+		case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+		case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+		case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+		case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+		case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+		case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+		default: return VK_FORMAT_UNDEFINED;
+	}
+}
+
+bool isTextureContainerPath(const std::string& path) {
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return extension == kKTX2_EXTENSION || extension == kDDS_EXTENSION;
+}
+
+// levels after the first are whatever the file says is there, a chain can stop early
+static void readLevel(const std::vector<char>& file, uint64_t offset, uint64_t length, VkFormat format, uint32_t width, uint32_t height, TextureMip& mip) {
+	mip.width = width;
+	mip.height = height;
+	uint64_t size = getMipBytes(format, width, height);
+
+	if (length < size || offset > file.size() || size > file.size() - offset) {
+		throw std::runtime_error("Texture File Is Truncated");
+	}
+
+	mip.pixels.assign(file.begin() + offset, file.begin() + offset + size);
+}
+
+// floor(log2(max(width, height))) + 1, a file claiming more levels than that is broken
+static uint32_t getFullMipCount(uint32_t width, uint32_t height) {
+	uint32_t levels = 1;
+
+	for (uint32_t size = std::max(width, height); size > 1; size >>= 1) {
+		levels++;
+	}
+
+	return levels;
+}
+
+static TextureContainer loadKtx2(const std::vector<char>& file) {
+	Ktx2Header header;
+
+	if (file.size() < sizeof(header)) {
+		throw std::runtime_error("Texture File Is Truncated");
+	}
+
+	memcpy(&header, file.data(), sizeof(header));
+
+	TextureContainer container;
+	container.format = static_cast<VkFormat>(header.vkFormat);
+
+	if (header.supercompressionScheme != 0) {
+		throw std::runtime_error("Unsupported KTX2 Supercompression");
+	}
+
+	if (!isContainerFormat(container.format) || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.pixelWidth == 0 || header.pixelHeight == 0) {
+		throw std::runtime_error("Unsupported KTX2 Texture");
+	}
+
+	// 0 asks the loader to build the chain, the streaming texture does that for uncompressed formats
+	uint32_t levelCount = std::max(header.levelCount, 1u);
+
+	if (levelCount > getFullMipCount(header.pixelWidth, header.pixelHeight)) {
+		throw std::runtime_error("Unsupported KTX2 Texture");
+	}
+
+	if (file.size() < sizeof(header) + levelCount * sizeof(Ktx2Level)) {
+		throw std::runtime_error("Texture File Is Truncated");
+	}
+
+	container.mips.resize(levelCount);
+
+	for (uint32_t level = 0; level < levelCount; level++) {
+		Ktx2Level levelIndex;
+		memcpy(&levelIndex, file.data() + sizeof(header) + level * sizeof(Ktx2Level), sizeof(levelIndex));
+		readLevel(file, levelIndex.byteOffset, levelIndex.byteLength, container.format,
+			std::max(header.pixelWidth >> level, 1u), std::max(header.pixelHeight >> level, 1u), container.mips[level]);
+	}
+
+	return container;
+}
+
+static TextureContainer loadDds(const std::vector<char>& file) {
+	DdsHeader header;
+	uint64_t offset = sizeof(uint32_t) + sizeof(header);
+
+	if (file.size() < offset) {
+		throw std::runtime_error("Texture File Is Truncated");
+	}
+
+	memcpy(&header, file.data() + sizeof(uint32_t), sizeof(header));
+
+	TextureContainer container;
+	const uint32_t kDDPF_FOURCC = 0x4;
+	const uint32_t kDDSCAPS2_CUBEMAP = 0x200;
+	const uint32_t kDDSCAPS2_VOLUME = 0x200000;
+
+	if (!(header.pixelFormat.flags & kDDPF_FOURCC)) {
+		throw std::runtime_error("Unsupported DDS Texture");
+	}
+
+	switch (header.pixelFormat.fourCC) {
+		case makeFourCC('D', 'X', 'T', '1'):
+			container.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			break;
+		case makeFourCC('D', 'X', 'T', '5'):
+			container.format = VK_FORMAT_BC3_UNORM_BLOCK;
+			break;
+		case makeFourCC('A', 'T', 'I', '2'):
+		case makeFourCC('B', 'C', '5', 'U'):
+			container.format = VK_FORMAT_BC5_UNORM_BLOCK;
+			break;
+		case makeFourCC('D', 'X', '1', '0'): {
+			DdsHeaderDx10 headerDx10;
+
+			if (file.size() < offset + sizeof(headerDx10)) {
+				throw std::runtime_error("Texture File Is Truncated");
+			}
+
+			memcpy(&headerDx10, file.data() + offset, sizeof(headerDx10));
+			offset += sizeof(headerDx10);
+
+			const uint32_t kDIMENSION_TEXTURE2D = 3;
+			const uint32_t kMISC_TEXTURECUBE = 0x4;
+
+			if (headerDx10.resourceDimension != kDIMENSION_TEXTURE2D || headerDx10.arraySize > 1 || (headerDx10.miscFlag & kMISC_TEXTURECUBE)) {
+				throw std::runtime_error("Unsupported DDS Texture");
+			}
+
+			container.format = getDxgiFormat(headerDx10.dxgiFormat);
+			break;
+		}
+		default:
+			break;
+	}
+
+	if (container.format == VK_FORMAT_UNDEFINED || (header.caps2 & (kDDSCAPS2_CUBEMAP | kDDSCAPS2_VOLUME)) || header.width == 0 || header.height == 0) {
+		throw std::runtime_error("Unsupported DDS Texture");
+	}
+
+	if (header.mipMapCount > getFullMipCount(header.width, header.height)) {
+		throw std::runtime_error("Unsupported DDS Texture");
+	}
+
+	// levels are stored back to back, largest first
+	container.mips.resize(std::max(header.mipMapCount, 1u));
+
+	for (uint32_t level = 0; level < container.mips.size(); level++) {
+		uint32_t width = std::max(header.width >> level, 1u);
+		uint32_t height = std::max(header.height >> level, 1u);
+		uint64_t size = getMipBytes(container.format, width, height);
+		readLevel(file, offset, size, container.format, width, height, container.mips[level]);
+		offset += size;
+	}
+
+	return container;
+}
+
+TextureContainer loadTextureContainer(const std::string& path) {
+	std::vector<char> file = readFile(path);
+	uint32_t magic = 0;
+
+	if (file.size() >= sizeof(kKTX2_IDENTIFIER) && memcmp(file.data(), kKTX2_IDENTIFIER, sizeof(kKTX2_IDENTIFIER)) == 0) {
+		return loadKtx2(file);
+	}
+
+	if (file.size() >= sizeof(magic)) {
+		memcpy(&magic, file.data(), sizeof(magic));
+	}
+
+	if (magic == kDDS_MAGIC) {
+		return loadDds(file);
+	}
+
+	throw std::runtime_error("Unknown Texture Container");
+}
+
+// KHR basic data format descriptor, KTX2 requires one even though vkFormat already says everything
+static std::vector<uint32_t> buildDataFormatDescriptor(VkFormat format) {
+	struct Sample {
+		uint32_t bitOffset;
+		uint32_t bitLength;
+		uint32_t channel;
+	};
+
+	const uint32_t kMODEL_RGBSDA = 1;
+	const uint32_t kMODEL_BC1A = 128;
+	const uint32_t kMODEL_BC3 = 130;
+	const uint32_t kMODEL_BC5 = 132;
+	const uint32_t kMODEL_BC7 = 134;
+	const uint32_t kCHANNEL_ALPHA = 15;
+	const uint32_t kSAMPLE_LINEAR = 0x10; // alpha of an srgb format isn't srgb encoded
+
+	bool srgb = getDecompressedFormat(format) == VK_FORMAT_R8G8B8A8_SRGB;
+	uint32_t model;
+	std::vector<Sample> samples;
+
+	switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			model = kMODEL_BC1A;
+			samples = { { 0, 64, 0 } };
+			break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			model = kMODEL_BC1A;
+			samples = { { 0, 64, 1 } };
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			model = kMODEL_BC3;
+			samples = { { 0, 64, kCHANNEL_ALPHA | (srgb ? kSAMPLE_LINEAR : 0) }, { 64, 64, 0 } };
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			model = kMODEL_BC5;
+			samples = { { 0, 64, 0 }, { 64, 64, 1 } };
+			break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			model = kMODEL_BC7;
+			samples = { { 0, 128, 0 } };
+			break;
+		default:
+			model = kMODEL_RGBSDA;
+			samples = { { 0, 8, 0 }, { 8, 8, 1 }, { 16, 8, 2 }, { 24, 8, kCHANNEL_ALPHA | (srgb ? kSAMPLE_LINEAR : 0) } };
+			break;
+	}
+
+	uint32_t blockDimension = isBlockCompressed(format) ? 3 : 0; // stored minus one
+	uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+
+	std::vector<uint32_t> dfd = {
+		4 + blockSize,
+		0, // khronos vendor, basic descriptor type
+		2 | (blockSize << 16), // version 2 of the basic descriptor
+		model | (1u << 8) | ((srgb ? 2u : 1u) << 16), // bt709 primaries, srgb or linear transfer, straight alpha
+		blockDimension | (blockDimension << 8),
+		getBlockBytes(format),
+		0
+	};
+
+	for (const Sample& sample : samples) {
+		dfd.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+		dfd.push_back(0);
+		dfd.push_back(0);
+		dfd.push_back(sample.bitLength >= 32 ? UINT32_MAX : (1u << sample.bitLength) - 1);
+	}
+
+	return dfd;
+}
+
+void writeKtx2(const std::string& path, const TextureContainer& container) {
+	std::vector<uint32_t> dfd = buildDataFormatDescriptor(container.format);
+	uint32_t levelCount = static_cast<uint32_t>(container.mips.size());
+
+	Ktx2Header header{};
+	memcpy(header.identifier, kKTX2_IDENTIFIER, sizeof(kKTX2_IDENTIFIER));
+	header.vkFormat = static_cast<uint32_t>(container.format);
+	header.typeSize = 1;
+	header.pixelWidth = container.mips[0].width;
+	header.pixelHeight = container.mips[0].height;
+	header.faceCount = 1;
+	header.levelCount = levelCount;
+	header.dfdByteOffset = static_cast<uint32_t>(sizeof(header) + levelCount * sizeof(Ktx2Level));
+	header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+	// every level starts on a block, blocks are 8 or 16 bytes so that covers the 4 byte rule too
+	uint64_t alignment = getBlockBytes(container.format);
+	uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+	std::vector<Ktx2Level> levels(levelCount);
+
+	// smallest level first, a partial download can show something before the end
+	for (uint32_t level = levelCount; level-- > 0;) {
+		offset = (offset + alignment - 1) / alignment * alignment;
+		levels[level].byteOffset = offset;
+		levels[level].byteLength = container.mips[level].pixels.size();
+		levels[level].uncompressedByteLength = levels[level].byteLength;
+		offset += levels[level].byteLength;
+	}
+
+	std::vector<char> file(offset, 0);
+	memcpy(file.data(), &header, sizeof(header));
+	memcpy(file.data() + sizeof(header), levels.data(), levels.size() * sizeof(Ktx2Level));
+	memcpy(file.data() + header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+
+	for (uint32_t level = 0; level < levelCount; level++) {
+		memcpy(file.data() + levels[level].byteOffset, container.mips[level].pixels.data(), container.mips[level].pixels.size());
+	}
+
+	if (!writeFileAtomically(path, file.data(), file.size())) {
+		throw std::runtime_error("Failed to Write Texture");
+	}
+}
+
+// jpeg/png in, ktx2 with a full chain out, bc5 is linear and everything else srgb
+void runTextureConverter(const std::string& inputPath, const std::string& outputPath, const std::string& formatName) {
+	VkFormat format;
+
+	if (formatName == "bc1") {
+		format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+	} else if (formatName == "bc3") {
+		format = VK_FORMAT_BC3_SRGB_BLOCK;
+	} else if (formatName == "bc5") {
+		format = VK_FORMAT_BC5_UNORM_BLOCK;
+	} else if (formatName == "bc7") {
+		format = VK_FORMAT_BC7_SRGB_BLOCK;
+	} else if (formatName == "rgba8") {
+		format = VK_FORMAT_R8G8B8A8_SRGB;
+	} else {
+		throw std::runtime_error("Unknown Texture Format " + formatName);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	int texWidth, texHeight, texChannels;
+	stbi_uc* pixels = stbi_load(inputPath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+	if (!pixels) {
+		throw std::runtime_error("Failed to Load Texture");
+	}
+
+	std::vector<TextureMip> chain = generateMipChain(pixels, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), getDecompressedFormat(format) == VK_FORMAT_R8G8B8A8_SRGB);
+	stbi_image_free(pixels);
+
+	TextureContainer container;
+	container.format = format;
+	VkDeviceSize uncompressedBytes = 0;
+	VkDeviceSize compressedBytes = 0;
+
+	for (const TextureMip& mip : chain) {
+		container.mips.push_back(isBlockCompressed(format) ? compressMip(format, mip) : mip);
+		uncompressedBytes += mip.pixels.size();
+		compressedBytes += container.mips.back().pixels.size();
+	}
+
+	writeKtx2(outputPath, container);
+
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// error of the top level after a round trip, over the channels the format keeps
+	TextureMip decoded = isBlockCompressed(format) ? decompressMip(format, container.mips[0]) : container.mips[0];
+	uint32_t channels = format == VK_FORMAT_BC5_UNORM_BLOCK ? 2 : (format == VK_FORMAT_BC1_RGB_SRGB_BLOCK ? 3 : 4);
+	double squaredError = 0.0;
+
+	for (size_t i = 0; i < decoded.pixels.size(); i++) {
+		if (i % 4 < channels) {
+			double difference = static_cast<double>(decoded.pixels[i]) - chain[0].pixels[i];
+			squaredError += difference * difference;
+		}
+	}
+
+	double meanSquaredError = squaredError / (static_cast<double>(chain[0].width) * chain[0].height * channels);
+
+	cout << "Converted " << inputPath << " to " << outputPath << " as " << getFormatName(format) << ", " << chain.size() << " levels in "
+		<< seconds * 1000.0 << " ms" << endl;
+	cout << "  " << uncompressedBytes / 1024 << " KiB as RGBA8, " << compressedBytes / 1024 << " KiB written ("
+		<< static_cast<double>(uncompressedBytes) / compressedBytes << "x smaller), top level PSNR ";
+
+	if (meanSquaredError > 0.0) {
+		cout << 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) << " dB" << endl;
+	} else {
+		cout << "lossless" << endl;
+	}
+}
\ No newline at end of file
@@ -1,105 +1,79 @@
 #include "headers/VulkanApplicationTextureManager.h"
 
-VulkanApplicationTextureManager::VulkanApplicationTextureManager(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue) {
-	createTextureImage(logicalDevice, physicalDevice, commandPool, graphicsQueue);
-	createTextureImageView(logicalDevice);
-	createTextureSampler(logicalDevice, physicalDevice);
+VulkanApplicationTextureManager::VulkanApplicationTextureManager(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext, bool blockCompression) {
+	createPlaceholderImage(logicalDevice, allocator, uploadContext);
+	textureCache = std::make_unique<VulkanApplicationTextureCache>(logicalDevice, physicalDevice, allocator, placeholderImageView,
+		supportsLinearBlit(physicalDevice, VK_FORMAT_R8G8B8A8_SRGB) && supportsLinearBlit(physicalDevice, VK_FORMAT_R8G8B8A8_UNORM), blockCompression);
+
+	// the converted texture when there is one, --convert-texture makes it from the jpeg
+	std::string path = std::filesystem::exists(kTEXTURE_PATH) ? kTEXTURE_PATH : kTEXTURE_SOURCE_PATH;
+
+	// decodes in the background, nothing here waits on the file
+	for (const TextureSampling& sampling : kMATERIAL_SAMPLINGS) {
+		materialTextures.push_back(textureCache->acquire(path, sampling));
+	}
+
+	if (debug) {
+		TextureCacheStats stats = textureCache->getStats();
+		cout << "Texture Cache: " << stats.requests << " requests, " << stats.hits << " hits, " << stats.imageLoads << " files loaded, "
+			<< stats.imageShares << " samplers sharing a loaded file" << endl;
+	}
 }
 
 VulkanApplicationTextureManager::~VulkanApplicationTextureManager() {}
 
-void VulkanApplicationTextureManager::cleanup(VkDevice logicalDevice) {
-	vkDestroySampler(logicalDevice, textureSampler, nullptr);
-	vkDestroyImageView(logicalDevice, textureImageView, nullptr);
-	vkDestroyImage(logicalDevice, textureImage, nullptr);
-	vkFreeMemory(logicalDevice, textureImageMemory, nullptr);
-}
+void VulkanApplicationTextureManager::cleanup(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator) {
+	for (TextureHandle texture : materialTextures) {
+		textureCache->release(texture);
+	}
 
-VkImage VulkanApplicationTextureManager::getTextureImage() {
-	return this->textureImage;
+	materialTextures.clear();
+	textureCache->cleanup();
+	vkDestroyImageView(logicalDevice, placeholderImageView, nullptr);
+	destroyImage(logicalDevice, allocator, placeholderImage, placeholderImageAllocation);
 }
 
-VkDeviceMemory VulkanApplicationTextureManager::getTextureImageMemory() {
-	return this->textureImageMemory;
+bool VulkanApplicationTextureManager::update(VulkanApplicationUploadContext& uploadContext, uint64_t frameNumber) {
+	return textureCache->update(uploadContext, frameNumber);
 }
 
-VkImageView VulkanApplicationTextureManager::getTextureImageView() {
-	return this->textureImageView;
+VulkanApplicationTextureCache& VulkanApplicationTextureManager::getTextureCache() {
+	return *this->textureCache;
 }
 
-VkSampler VulkanApplicationTextureManager::getTextureSampler() {
-	return this->textureSampler;
+uint32_t VulkanApplicationTextureManager::getMaterialCount() {
+	return static_cast<uint32_t>(this->materialTextures.size());
 }
 
-void VulkanApplicationTextureManager::createTextureImageView(VkDevice logicalDevice) {
-	textureImageView = createImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, logicalDevice, VK_IMAGE_ASPECT_COLOR_BIT);
+TextureHandle VulkanApplicationTextureManager::getMaterialTexture(uint32_t materialIndex) {
+	return this->materialTextures[materialIndex];
 }
 
-void VulkanApplicationTextureManager::createTextureSampler(VkDevice logicalDevice, VkPhysicalDevice physicalDevice) {
-	VkSamplerCreateInfo samplerInfo{};
-	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-	samplerInfo.magFilter = VK_FILTER_LINEAR; // helps with oversampling
-	samplerInfo.minFilter = VK_FILTER_LINEAR; // helps with undersampling
-
-	// UVW = XYZ, what to do with image once we hit the bounds of it
-	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-
-	VkPhysicalDeviceProperties properties{};
-	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
-
-	samplerInfo.anisotropyEnable = VK_TRUE;
-	samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-	samplerInfo.unnormalizedCoordinates = VK_FALSE;
-
-	samplerInfo.compareEnable = VK_FALSE; // mainly used for percentage-closer filtering on shadow maps
-	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-	samplerInfo.mipLodBias = 0.0f;
-	samplerInfo.minLod = 0.0f;
-	samplerInfo.maxLod = 0.0f;
-
-	if (vkCreateSampler(logicalDevice, &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to Create Texture Sampler");
-	}
+// the first material's, what binding 1 samples without the bindless table and what the budget key changes
+VulkanApplicationStreamingTexture& VulkanApplicationTextureManager::getStreamingTexture() {
+	return textureCache->getStreamingTexture(materialTextures[0]);
 }
 
-void VulkanApplicationTextureManager::createTextureImage(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue) {
-	int texWidth, texHeight, texChannels;
-	stbi_uc* pixels = stbi_load("textures/Statue_Image.jpg", &texWidth, &texHeight, &texChannels,
-		STBI_rgb_alpha);
-
-	VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-	if (!pixels) {
-		throw std::runtime_error("Failed to Load Texture");
-	}
-
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
+VkImageView VulkanApplicationTextureManager::getTextureImageView() {
+	return textureCache->getImageView(materialTextures[0]);
+}
 
-	createBuffer(logicalDevice, physicalDevice, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+VkSampler VulkanApplicationTextureManager::getTextureSampler() {
+	return textureCache->getSampler(materialTextures[0]);
+}
 
-	void* data;
-	vkMapMemory(logicalDevice, stagingBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, pixels, (size_t)imageSize);
-	vkUnmapMemory(logicalDevice, stagingBufferMemory);
+void VulkanApplicationTextureManager::createPlaceholderImage(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext) {
+	// one grey texel, close enough to the average of most textures to not flash
+	const std::array<uint8_t, 4> pixel = { 128, 128, 128, 255 };
 
-	stbi_image_free(pixels);
+	StagingRegion staging = uploadContext.stage(pixel.data(), pixel.size(), 16);
 
-	createImage(static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
+	createImage(1, 1, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
 		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		textureImage, textureImageMemory, logicalDevice, physicalDevice);
+		placeholderImage, placeholderImageAllocation, logicalDevice, allocator);
 
-	transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, commandPool, logicalDevice, graphicsQueue);
-	copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), logicalDevice, commandPool, graphicsQueue);
-	transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandPool, logicalDevice, graphicsQueue);
+	// only recorded here, the caller decides when the batch is submitted
+	uploadContext.copyBufferToImage(staging, placeholderImage, 1, 1, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-	vkDestroyBuffer(logicalDevice, stagingBuffer, nullptr);
-	vkFreeMemory(logicalDevice, stagingBufferMemory, nullptr);
+	placeholderImageView = createImageView(placeholderImage, VK_FORMAT_R8G8B8A8_SRGB, logicalDevice, VK_IMAGE_ASPECT_COLOR_BIT);
 }
\ No newline at end of file
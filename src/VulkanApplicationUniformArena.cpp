@@ -0,0 +1,73 @@
+#include "headers/VulkanApplicationUniformArena.h"
+
+VulkanApplicationUniformArena::VulkanApplicationUniformArena(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator, VkDeviceSize capacity) {
+	this->logicalDevice = logicalDevice;
+	this->allocator = &allocator;
+	this->capacity = capacity;
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	// the spec guarantees a power of two
+	alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+
+	buffers.resize(kMAX_FRAMES_IN_FLIGHT);
+	allocations.resize(kMAX_FRAMES_IN_FLIGHT);
+
+	for (size_t i = 0; i < kMAX_FRAMES_IN_FLIGHT; i++) {
+		createBuffer(logicalDevice, allocator, capacity, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffers[i], allocations[i]);
+	}
+}
+
+VulkanApplicationUniformArena::~VulkanApplicationUniformArena() {}
+
+void VulkanApplicationUniformArena::cleanup() {
+	if (debug) {
+		cout << "Uniform Arena: peak " << stats.peakBytesUsed / 1024 << " KiB of " << capacity / 1024 << " KiB per frame, "
+			<< alignment << " byte alignment" << endl;
+	}
+
+	for (size_t i = 0; i < kMAX_FRAMES_IN_FLIGHT; i++) {
+		destroyBuffer(logicalDevice, *allocator, buffers[i], allocations[i]);
+	}
+}
+
+void VulkanApplicationUniformArena::beginFrame(uint32_t frameIndex) {
+	currentFrame = frameIndex;
+	head = 0;
+	stats.allocations = 0;
+	stats.bytesUsed = 0;
+}
+
+uint32_t VulkanApplicationUniformArena::allocate(VkDeviceSize size, void** mapped) {
+	VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+
+	if (offset + size > capacity) {
+		throw std::runtime_error("Uniform Arena Out of Space");
+	}
+
+	head = offset + size;
+	*mapped = static_cast<char*>(allocations[currentFrame].mapped) + offset;
+
+	stats.allocations++;
+	stats.bytesUsed = head;
+	stats.peakBytesUsed = std::max(stats.peakBytesUsed, head);
+
+	return static_cast<uint32_t>(offset);
+}
+
+VkBuffer VulkanApplicationUniformArena::getBuffer(uint32_t frameIndex) {
+	return this->buffers[frameIndex];
+}
+
+VkDeviceSize VulkanApplicationUniformArena::getAlignment() {
+	return this->alignment;
+}
+
+VkDeviceSize VulkanApplicationUniformArena::getCapacity() {
+	return this->capacity;
+}
+
+UniformArenaStats VulkanApplicationUniformArena::getStats() {
+	return this->stats;
+}
\ No newline at end of file
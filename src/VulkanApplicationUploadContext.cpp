@@ -0,0 +1,416 @@
+#include "headers/VulkanApplicationUploadContext.h"
+
+VulkanApplicationUploadContext::VulkanApplicationUploadContext(VkDevice logicalDevice, VkQueue graphicsQueue, uint32_t graphicsFamily,
+	VkQueue transferQueue, uint32_t transferFamily, VulkanApplicationStagingRing& stagingRing) {
+	this->logicalDevice = logicalDevice;
+	this->graphicsQueue = graphicsQueue;
+	this->graphicsFamily = graphicsFamily;
+	this->transferQueue = transferQueue;
+	this->transferFamily = transferFamily;
+	this->stagingRing = &stagingRing;
+	this->dedicatedTransfer = graphicsFamily != transferFamily;
+
+	graphicsCommandPool = createCommandPool(graphicsFamily);
+	transferCommandPool = dedicatedTransfer ? createCommandPool(transferFamily) : graphicsCommandPool;
+}
+
+VulkanApplicationUploadContext::~VulkanApplicationUploadContext() {}
+
+void VulkanApplicationUploadContext::cleanup() {
+	if (debug) { printStats(); }
+
+	if (isRecording) {
+		vkEndCommandBuffer(recording.transferCommandBuffer);
+		if (dedicatedTransfer) { vkEndCommandBuffer(recording.graphicsCommandBuffer); }
+		freeCommands.push_back(recording);
+		isRecording = false;
+	}
+
+	wait({ lastSubmittedBatch });
+
+	for (const UploadCommands& commands : inFlightCommands) {
+		freeCommands.push_back(commands);
+	}
+	inFlightCommands.clear();
+
+	for (const UploadCommands& commands : freeCommands) {
+		if (commands.transferComplete != VK_NULL_HANDLE) {
+			vkDestroySemaphore(logicalDevice, commands.transferComplete, nullptr);
+		}
+	}
+	freeCommands.clear();
+
+	// destroying the pools frees every command buffer allocated from them
+	if (dedicatedTransfer) {
+		vkDestroyCommandPool(logicalDevice, transferCommandPool, nullptr);
+	}
+	vkDestroyCommandPool(logicalDevice, graphicsCommandPool, nullptr);
+}
+
+VkCommandPool VulkanApplicationUploadContext::createCommandPool(uint32_t queueFamilyIndex) {
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+	VkCommandPool commandPool;
+
+	if (vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Create Upload Command Pool");
+	}
+
+	return commandPool;
+}
+
+VulkanApplicationUploadContext::UploadCommands& VulkanApplicationUploadContext::getRecordingCommands() {
+	if (isRecording) {
+		return recording;
+	}
+
+	recycleCommands();
+
+	if (!freeCommands.empty()) {
+		recording = freeCommands.back();
+		freeCommands.pop_back();
+		vkResetCommandBuffer(recording.transferCommandBuffer, 0);
+		if (dedicatedTransfer) { vkResetCommandBuffer(recording.graphicsCommandBuffer, 0); }
+	} else {
+		recording = UploadCommands{};
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = transferCommandPool;
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &recording.transferCommandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to Allocate Upload Command Buffer");
+		}
+
+		recording.graphicsCommandBuffer = recording.transferCommandBuffer;
+
+		if (dedicatedTransfer) {
+			allocInfo.commandPool = graphicsCommandPool;
+
+			VkSemaphoreCreateInfo semaphoreInfo{};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+			if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &recording.graphicsCommandBuffer) != VK_SUCCESS ||
+				vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &recording.transferComplete) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to Allocate Upload Command Buffer");
+			}
+		}
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(recording.transferCommandBuffer, &beginInfo) != VK_SUCCESS ||
+		(dedicatedTransfer && vkBeginCommandBuffer(recording.graphicsCommandBuffer, &beginInfo) != VK_SUCCESS)) {
+		throw std::runtime_error("Failed to Begin Recording Upload Command Buffer");
+	}
+
+	recording.hasTransferWork = false;
+	isRecording = true;
+
+	return recording;
+}
+
+void VulkanApplicationUploadContext::recycleCommands() {
+	while (!inFlightCommands.empty() && stagingRing->isBatchComplete(inFlightCommands.front().batchId)) {
+		freeCommands.push_back(inFlightCommands.front());
+		inFlightCommands.pop_front();
+	}
+}
+
+void VulkanApplicationUploadContext::getLayoutUsage(VkImageLayout layout, VkAccessFlags& accessMask, VkPipelineStageFlags& stageMask) {
+	if (layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+		accessMask = VK_ACCESS_SHADER_READ_BIT;
+		stageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	} else if (layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+		accessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		stageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	} else if (layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+		accessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		stageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	} else {
+		throw std::invalid_argument("Unsupported Upload Layout");
+	}
+}
+
+StagingRegion VulkanApplicationUploadContext::stage(const void* data, VkDeviceSize size, VkDeviceSize alignment) {
+	if (!stagingRing->canReserve(size, alignment)) {
+		stats.forcedSubmits++;
+		submit();
+	}
+
+	StagingRegion region = stagingRing->reserve(size, alignment);
+
+	// null data just reserves the space, the caller writes into region.mapped
+	if (data != nullptr) {
+		memcpy(region.mapped, data, (size_t)size);
+	}
+
+	return region;
+}
+
+void VulkanApplicationUploadContext::copyBuffer(const StagingRegion& source, VkBuffer dstBuffer, VkDeviceSize dstOffset,
+	VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask) {
+	UploadCommands& commands = getRecordingCommands();
+
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = source.offset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = source.size;
+	vkCmdCopyBuffer(commands.transferCommandBuffer, source.buffer, dstBuffer, 1, &copyRegion);
+
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = dstAccessMask;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = dstBuffer;
+	barrier.offset = dstOffset;
+	barrier.size = source.size;
+
+	if (dedicatedTransfer) {
+		// release, the dst side of the barrier is ignored on this queue
+		barrier.srcQueueFamilyIndex = transferFamily;
+		barrier.dstQueueFamilyIndex = graphicsFamily;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(commands.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		// acquire, the semaphore wait already covers the src side
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccessMask;
+		vkCmdPipelineBarrier(commands.graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStageMask,
+			0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		stats.ownershipTransfers++;
+	} else {
+		vkCmdPipelineBarrier(commands.graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask,
+			0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	commands.hasTransferWork = true;
+	stats.copies++;
+}
+
+// width and height are the mip level's own, every level is transitioned on its own so levels can be uploaded separately
+void VulkanApplicationUploadContext::copyBufferToImage(const StagingRegion& source, VkImage image, uint32_t width, uint32_t height, VkImageLayout finalLayout, uint32_t mipLevel) {
+	UploadCommands& commands = getRecordingCommands();
+
+	// the transfer queue can do the first transition itself, only transfer stages are involved
+	recordImageLayoutTransition(commands.transferCommandBuffer, image, VK_FORMAT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevel);
+	recordCopyBufferToImage(commands.transferCommandBuffer, source.buffer, source.offset, image, width, height, mipLevel);
+
+	VkAccessFlags dstAccessMask;
+	VkPipelineStageFlags dstStageMask;
+	getLayoutUsage(finalLayout, dstAccessMask, dstStageMask);
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = finalLayout;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = dstAccessMask;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = mipLevel;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	if (dedicatedTransfer) {
+		// release and acquire must describe the same layout transition, it only happens once
+		barrier.srcQueueFamilyIndex = transferFamily;
+		barrier.dstQueueFamilyIndex = graphicsFamily;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(commands.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccessMask;
+		vkCmdPipelineBarrier(commands.graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStageMask,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		stats.ownershipTransfers++;
+	} else {
+		vkCmdPipelineBarrier(commands.graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	commands.hasTransferWork = true;
+	stats.copies++;
+	stats.transitions += 2;
+}
+
+// level 0 must already hold the image in transfer src layout, every level ends up in finalLayout
+void VulkanApplicationUploadContext::generateMipmaps(VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, VkImageLayout finalLayout) {
+	VkCommandBuffer commandBuffer = getRecordingCommands().graphicsCommandBuffer;
+
+	VkAccessFlags dstAccessMask;
+	VkPipelineStageFlags dstStageMask;
+	getLayoutUsage(finalLayout, dstAccessMask, dstStageMask);
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	// every level below the first becomes a blit target in one barrier
+	if (mipLevels > 1) {
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.subresourceRange.baseMipLevel = 1;
+		barrier.subresourceRange.levelCount = mipLevels - 1;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+		stats.transitions++;
+	}
+
+	int32_t mipWidth = static_cast<int32_t>(width);
+	int32_t mipHeight = static_cast<int32_t>(height);
+
+	for (uint32_t level = 1; level < mipLevels; level++) {
+		int32_t nextWidth = std::max(mipWidth / 2, 1);
+		int32_t nextHeight = std::max(mipHeight / 2, 1);
+
+		VkImageBlit blit{};
+		blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = level;
+		blit.dstSubresource.baseArrayLayer = 0;
+		blit.dstSubresource.layerCount = 1;
+
+		vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit, VK_FILTER_LINEAR);
+
+		// the level just written is the source of the next blit, one barrier per level
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.subresourceRange.baseMipLevel = level;
+		barrier.subresourceRange.levelCount = 1;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		mipWidth = nextWidth;
+		mipHeight = nextHeight;
+		stats.blits++;
+		stats.transitions++;
+	}
+
+	// all levels are in transfer src now, one barrier takes the whole chain to its final layout
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.newLayout = finalLayout;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.dstAccessMask = dstAccessMask;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+	stats.transitions++;
+}
+
+void VulkanApplicationUploadContext::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
+	// runs on the graphics queue, some transitions (depth) use stages a transfer queue doesn't have
+	recordImageLayoutTransition(getRecordingCommands().graphicsCommandBuffer, image, format, oldLayout, newLayout);
+
+	stats.transitions++;
+}
+
+UploadTicket VulkanApplicationUploadContext::submit() {
+	if (!isRecording) {
+		return { lastSubmittedBatch };
+	}
+
+	if (vkEndCommandBuffer(recording.transferCommandBuffer) != VK_SUCCESS ||
+		(dedicatedTransfer && vkEndCommandBuffer(recording.graphicsCommandBuffer) != VK_SUCCESS)) {
+		throw std::runtime_error("Failed to Record Upload Command Buffer");
+	}
+
+	StagingBatch batch = stagingRing->commit();
+	bool waitOnTransfer = dedicatedTransfer && recording.hasTransferWork;
+
+	if (waitOnTransfer) {
+		VkSubmitInfo transferSubmitInfo{};
+		transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmitInfo.commandBufferCount = 1;
+		transferSubmitInfo.pCommandBuffers = &recording.transferCommandBuffer;
+		transferSubmitInfo.signalSemaphoreCount = 1;
+		transferSubmitInfo.pSignalSemaphores = &recording.transferComplete;
+
+		if (vkQueueSubmit(transferQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to Submit Upload Command Buffer");
+		}
+	}
+
+	// the graphics submit carries the fence, it can't finish before the transfer submit it waits on
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &recording.graphicsCommandBuffer;
+
+	if (waitOnTransfer) {
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &recording.transferComplete;
+		submitInfo.pWaitDstStageMask = &waitStage;
+	}
+
+	if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to Submit Upload Command Buffer");
+	}
+
+	recording.batchId = batch.id;
+	inFlightCommands.push_back(recording);
+	isRecording = false;
+	lastSubmittedBatch = batch.id;
+	stats.submits++;
+
+	return { batch.id };
+}
+
+bool VulkanApplicationUploadContext::isComplete(UploadTicket ticket) {
+	return ticket.id == 0 || stagingRing->isBatchComplete(ticket.id);
+}
+
+void VulkanApplicationUploadContext::wait(UploadTicket ticket) {
+	if (ticket.id != 0) {
+		stagingRing->waitForBatch(ticket.id);
+	}
+}
+
+bool VulkanApplicationUploadContext::hasDedicatedTransferQueue() {
+	return this->dedicatedTransfer;
+}
+
+UploadContextStats VulkanApplicationUploadContext::getStats() {
+	return this->stats;
+}
+
+void VulkanApplicationUploadContext::printStats() {
+	cout << "Upload Context: " << stats.copies << " copies and " << stats.transitions << " transitions in "
+		<< stats.submits << " submits (" << stats.forcedSubmits << " forced by a full staging ring), " << stats.blits << " mip blits" << endl;
+	cout << "  " << (dedicatedTransfer ? "dedicated transfer queue, " : "shared graphics queue, ")
+		<< stats.ownershipTransfers << " queue family ownership transfers" << endl;
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "headers/VulkanApplicationVertexFormats.h"
+
+// calls function with a default constructed layout matching format, the only place VertexFormat turns back into a type
+template<typename Function>
+static auto visitVertexLayout(VertexFormat format, Function&& function) {
+	switch (format) {
+		case VertexFormat::kFloat:
+			return function(VertexLayoutFloat{});
+		case VertexFormat::kCompact:
+			return function(VertexLayoutCompact{});
+		case VertexFormat::kQuantizedPosition:
+			return function(VertexLayoutQuantizedPosition{});
+		case VertexFormat::kQuantized:
+			return function(VertexLayoutQuantized{});
+		default:
+			throw std::invalid_argument("Unknown Vertex Format");
+	}
+}
+
+VertexQuantization getVertexQuantization(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+	VertexQuantization quantization;
+	quantization.positionOffset = boundsMin;
+	// flat meshes still need a non zero scale on the flat axis
+	quantization.positionScale = glm::max(boundsMax - boundsMin, glm::vec3(1e-6f));
+	return quantization;
+}
+
+VertexInputDescription getVertexInputDescription(VertexFormat format) {
+	return visitVertexLayout(format, [](auto layout) {
+		using Layout = decltype(layout);
+		static_assert(Layout::kATTRIBUTE_COUNT <= std::tuple_size<decltype(VertexInputDescription::attributes)>::value,
+			"VertexInputDescription is too small for this layout");
+
+		VertexInputDescription description{};
+		description.binding = Layout::getBindingDescription();
+		auto attributes = Layout::getAttributeDescriptions();
+		std::copy(attributes.begin(), attributes.end(), description.attributes.begin());
+		description.attributeCount = Layout::kATTRIBUTE_COUNT;
+		return description;
+	});
+}
+
+uint32_t getVertexStride(VertexFormat format) {
+	return visitVertexLayout(format, [](auto layout) { return decltype(layout)::kSTRIDE; });
+}
+
+const char* getVertexFormatName(VertexFormat format) {
+	switch (format) {
+		case VertexFormat::kFloat:
+			return "Float";
+		case VertexFormat::kCompact:
+			return "Compact";
+		case VertexFormat::kQuantizedPosition:
+			return "Quantized Position";
+		case VertexFormat::kQuantized:
+			return "Quantized";
+		default:
+			return "Unknown";
+	}
+}
+
+// takes 0..1 positions back into mesh space, applied as part of the model matrix
+glm::mat4 getPositionDequantization(VertexFormat format, const VertexQuantization& quantization) {
+	bool boundsRelative = visitVertexLayout(format, [](auto layout) { return decltype(layout)::kBOUNDS_RELATIVE; });
+
+	if (!boundsRelative) {
+		return glm::mat4(1.0f);
+	}
+
+	return glm::scale(glm::translate(glm::mat4(1.0f), quantization.positionOffset), quantization.positionScale);
+}
+
+void encodeVertices(const std::vector<Vertex>& vertices, VertexFormat format, const VertexQuantization& quantization, void* output) {
+	visitVertexLayout(format, [&](auto layout) {
+		using Layout = decltype(layout);
+		char* cursor = static_cast<char*>(output);
+
+		for (const Vertex& vertex : vertices) {
+			Layout::encode(vertex, quantization, cursor);
+			cursor += Layout::kSTRIDE;
+		}
+	});
+}
+
+VertexFormat selectVertexFormat(const std::vector<Vertex>& vertices, const VertexQuantization& quantization) {
+	std::array<VertexFormat, static_cast<size_t>(VertexFormat::kCount)> formats{};
+	for (size_t i = 0; i < formats.size(); i++) {
+		formats[i] = static_cast<VertexFormat>(i);
+	}
+
+	std::stable_sort(formats.begin(), formats.end(), [](VertexFormat a, VertexFormat b) { return getVertexStride(a) < getVertexStride(b); });
+
+	for (VertexFormat format : formats) {
+		bool withinTolerance = visitVertexLayout(format, [&](auto layout) {
+			for (const Vertex& vertex : vertices) {
+				if (decltype(layout)::getError(vertex, quantization) > 1.0f) {
+					return false;
+				}
+			}
+			return true;
+		});
+
+		if (withinTolerance) {
+			return format;
+		}
+	}
+
+	return VertexFormat::kFloat;
+}
+
+InstanceInputDescription getInstanceInputDescription() {
+	InstanceInputDescription description{};
+	description.binding.binding = kINSTANCE_BINDING;
+	description.binding.stride = sizeof(InstanceData);
+	description.binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	for (uint32_t column = 0; column < 4; column++) {
+		description.attributes[column] = { kINSTANCE_FIRST_LOCATION + column, kINSTANCE_BINDING, VK_FORMAT_R32G32B32A32_SFLOAT,
+			static_cast<uint32_t>(offsetof(InstanceData, model) + column * sizeof(glm::vec4)) };
+	}
+
+	description.attributes[4] = { kINSTANCE_FIRST_LOCATION + 4, kINSTANCE_BINDING, VK_FORMAT_R32G32B32A32_SFLOAT,
+		static_cast<uint32_t>(offsetof(InstanceData, tint)) };
+
+	return description;
+}
\ No newline at end of file
@@ -3,10 +3,17 @@
 
 #include "VulkanApplicationInstanceManager.h"
 #include "VulkanApplicationDeviceManager.h"
+#include "VulkanApplicationMemoryAllocator.h"
+#include "VulkanApplicationStagingRing.h"
+#include "VulkanApplicationUploadContext.h"
 #include "VulkanApplicationSwapchainManager.h"
 #include "VulkanApplicationGraphicsManager.h"
 #include "VulkanApplicationTextureManager.h"
 #include "VulkanApplicationBufferManager.h"
+#include "VulkanApplicationGpuCuller.h"
+#include "VulkanApplicationCommandRecorder.h"
+#include "VulkanApplicationBindlessTextures.h"
+#include "VulkanApplicationPipelineCache.h"
 
 #include <chrono>
 
@@ -22,6 +29,10 @@ class HelloTriangleApplication {
 		std::unique_ptr<VulkanApplicationInstanceManager> instanceManager;
 		VkSurfaceKHR surface; // Could use platform specific stuff here if I wanted
 		std::unique_ptr<VulkanApplicationDeviceManager> deviceManager;
+		std::unique_ptr<VulkanApplicationPipelineCache> pipelineCache; // saved to disk in cleanup
+		std::unique_ptr<VulkanApplicationMemoryAllocator> memoryAllocator;
+		std::unique_ptr<VulkanApplicationStagingRing> stagingRing;
+		std::unique_ptr<VulkanApplicationUploadContext> uploadContext;
 		std::unique_ptr<VulkanApplicationSwapchainManager> swapchainManager;
 		std::unique_ptr<VulkanApplicationGraphicsManager> graphicsManager;
 		std::unique_ptr<VulkanApplicationTextureManager> textureManager;
@@ -29,19 +40,39 @@ class HelloTriangleApplication {
 		// command file
 		VkCommandPool commandPool;
 		std::vector<VkCommandBuffer> commandBuffers;
+		std::unique_ptr<VulkanApplicationCommandRecorder> commandRecorder;
+		uint32_t recordingThreads = 0; // T cycles it, 0 records inline on the main thread
 		// sync object file
 		std::vector<VkSemaphore> imageAvailableSemaphores;
 		std::vector<VkSemaphore> renderFinishedSemaphores;
 		std::vector<VkFence> inFlightFences;
 		// this one (for now)
 		uint32_t currentFrame = 0;
+		uint64_t frameNumber = 0; // frames submitted so far, streaming uses it to know when an image is no longer in flight
 		bool framebufferResized = false;
+		// draw path comparison, P cycles through the paths
+		DrawPath drawPath = DrawPath::kUniformBuffer;
+		double drawPathCpuTime = 0.0; // seconds spent updating uniforms + recording since the last report
+		uint32_t drawPathFrames = 0;
+		uint64_t drawPathDrawCalls = 0; // vkCmdDrawIndexed calls recorded over the same frames
+		uint64_t lodTrianglesSubmitted = 0; // summed over the same frames, L toggles lod selection
+		uint64_t lodTrianglesWithoutLod = 0;
+		double cullingCpuTime = 0.0; // C toggles cpu frustum culling, its time is part of drawPathCpuTime too
+		uint64_t cullingVisibleObjects = 0;
+		double sceneGraphCpuTime = 0.0; // transform propagation, also part of drawPathCpuTime
+		uint64_t sceneGraphMatricesWritten = 0;
+		double recordingCpuTime = 0.0; // render pass contents only, also part of drawPathCpuTime
+		uint32_t shaderPermutationIndex = 0; // S cycles getShaderPermutationPresets()
 		// buffer file
 		std::unique_ptr<VulkanApplicationBufferManager> bufferManager;
+		std::unique_ptr<VulkanApplicationGpuCuller> gpuCuller; // null when the device can't run the gpu driven path
 		// descriptor file
 		VkDescriptorSetLayout descriptorSetLayout;
 		VkDescriptorPool descriptorPool;
 		std::vector<VkDescriptorSet> descriptorSets;
+		std::vector<VkImageView> descriptorImageViews; // what binding 1 of each set points at, the streamed texture swaps images
+		std::unique_ptr<VulkanApplicationBindlessTextures> bindlessTextures; // null without descriptor indexing, the shaders sample binding 1 then
+		std::vector<TextureHandle> slotTextures; // cached texture in each slot of the bindless table
 
 	public:
 		HelloTriangleApplication();
@@ -54,18 +85,28 @@ class HelloTriangleApplication {
 
 		void createCommandBuffer();
 		void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void recordDrawState(VkCommandBuffer commandBuffer, VkPipeline pipeline);
+		uint32_t recordObjectDraws(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last);
 		void createCommandPool();
 
 		void createDescriptorSetLayout();
 
+		void createBindlessTextures();
+		void createGpuCuller();
+		void recordGpuCull(VkCommandBuffer commandBuffer);
+
 		void mainLoop();
 		void drawFrame();
 		void cleanup();
 
 		static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
+		static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+		void setDrawPath(DrawPath newDrawPath);
+		void reportDrawPathTiming();
 
 		void createDescriptorPool();
 		void createDescriptorSets();
+		void updateTextureDescriptor(uint32_t frameIndex);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef VULKAN_APPLICATION_BINDLESS_TEXTURES
+#define VULKAN_APPLICATION_BINDLESS_TEXTURES
+
+/*	One big array of textures at set 1, indexed in the fragment shader by
+	the material index of the object being drawn.
+
+	A texture is registered once and keeps its slot, draws only bind the
+	set at the start of a command buffer and never again, however many
+	materials they go through. The binding is partially bound, so slots
+	nobody registered yet can stay empty, and update after bind, so a new
+	texture can go into a slot while a frame that doesn't sample it is
+	still in flight.
+
+	Changing what an existing slot points at isn't allowed while a
+	submitted frame may sample it, so there is one set per frame in flight
+	and flush() writes the slots that changed into a frame's set once its
+	fence has signalled, the same way binding 1 of the regular sets is
+	kept up to date.
+
+	Needs VK_EXT_descriptor_indexing, the device manager only enables it
+	with every feature this uses.
+*/
+
+#include "VulkanApplicationHelpers.h"
+
+const uint32_t kBINDLESS_TEXTURE_CAPACITY = 4096; // lowered to what the device allows
+const uint32_t kBINDLESS_TEXTURE_SET = 1;
+
+class VulkanApplicationBindlessTextures {
+	private:
+		VkDevice logicalDevice;
+		uint32_t capacity;
+		VkDescriptorSetLayout descriptorSetLayout;
+		VkDescriptorPool descriptorPool;
+		std::vector<VkDescriptorSet> descriptorSets; // one per frame in flight
+		std::vector<VkDescriptorImageInfo> textures; // what each registered slot should point at
+		std::vector<std::vector<VkImageView>> writtenViews; // [frame in flight][slot], what that frame's set points at
+
+		void writeSlot(uint32_t frameIndex, uint32_t slot);
+	public:
+		VulkanApplicationBindlessTextures(VkDevice logicalDevice, VkPhysicalDevice physicalDevice);
+		~VulkanApplicationBindlessTextures();
+		void cleanup();
+		uint32_t registerTexture(VkImageView imageView, VkSampler sampler);
+		void setTexture(uint32_t slot, VkImageView imageView);
+		void flush(uint32_t frameIndex);
+		VkDescriptorSetLayout getDescriptorSetLayout();
+		VkDescriptorSet getDescriptorSet(uint32_t frameIndex);
+		uint32_t getCapacity();
+		uint32_t getTextureCount();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef VULKAN_APPLICATION_BLOCK_COMPRESSION
+#define VULKAN_APPLICATION_BLOCK_COMPRESSION
+
+/*	BC1, BC3, BC5 and BC7 blocks, encoded for the offline converter and
+	decoded for devices without textureCompressionBC.
+
+	Every format stores 4x4 texels per block, BC1 in 8 bytes and the others
+	in 16, so a level is ceil(width / 4) * ceil(height / 4) blocks no matter
+	how small it gets. Decoding handles everything the formats can hold,
+	BC7 included, since containers from other tools use all eight modes.
+
+	Encoding is the simple, fast kind: endpoints along the principal axis
+	of the block's colors, BC1 refines them once with least squares. BC7
+	only writes mode 6, one subset with 16 weights and rgba endpoints, which
+	is already well ahead of BC1 and BC3 on quality. Good enough for the
+	converter, a dedicated encoder will beat it.
+
+	Both run over rows of blocks with the job system.
+*/
+
+#include "VulkanApplicationHelpers.h"
+
+const uint32_t kBLOCK_ROWS_PER_JOB = 16;
+
+bool isBlockCompressed(VkFormat format);
+uint32_t getBlockBytes(VkFormat format); // bytes per 4x4 block, or per texel for rgba8
+VkDeviceSize getMipBytes(VkFormat format, uint32_t width, uint32_t height);
+VkFormat getDecompressedFormat(VkFormat format);
+const char* getFormatName(VkFormat format);
+TextureMip decompressMip(VkFormat format, const TextureMip& mip);
+TextureMip compressMip(VkFormat format, const TextureMip& mip);
+
+#endif
\ No newline at end of file
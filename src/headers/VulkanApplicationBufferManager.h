@@ -2,52 +2,123 @@
 #define VULKAN_APPLICATION_BUFFER_MANAGER
 
 #include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationMemoryAllocator.h"
+#include "VulkanApplicationUploadContext.h"
+#include "VulkanApplicationUniformArena.h"
+#include "VulkanApplicationMeshLoader.h"
+#include "VulkanApplicationMeshCache.h"
+#include "VulkanApplicationMeshOptimizer.h"
+#include "VulkanApplicationMeshSimplifier.h"
+#include "VulkanApplicationCullingBvh.h"
+#include "VulkanApplicationSceneGraph.h"
 #include <chrono>
+#include <cmath>
 #include <glm/glm.hpp>
 
+const uint32_t kOBJECT_MODELS_OUTPUT = kMAX_FRAMES_IN_FLIGHT; // scene graph output slot of objectModels, the instance buffers use their frame index
+
+// what the lod selection did in the last updateUniformBuffer
+struct LodFrameStats {
+	uint64_t trianglesSubmitted = 0;
+	uint64_t trianglesWithoutLod = 0; // every visible object at full detail
+	std::array<uint32_t, kMAX_MESH_LODS> objectsPerLod{};
+};
+
+// objects drawn with one instanced draw, all at the same lod
+struct InstanceBatch {
+	uint32_t lod;
+	uint32_t firstInstance;
+	uint32_t instanceCount;
+};
+
 class VulkanApplicationBufferManager {
 	private:
 		VkBuffer vertexBuffer;
-		VkDeviceMemory vertexBufferMemory;
+		MemoryAllocation vertexBufferAllocation;
 		VkBuffer indexBuffer;
-		VkDeviceMemory indexBufferMemory;
-		std::vector<VkBuffer> uniformBuffers;
-		std::vector<VkDeviceMemory> uniformBuffersMemories;
-		std::vector<void*> uniformBuffersMapped;
-
-		const std::vector<Vertex> vertices = {
-			{{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-			{{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-			{{0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
-			{{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}},
-
-			{{-0.5f, -0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-			{{0.5f, -0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-			{{0.5f, 0.5f, -0.5f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
-			{{-0.5f, 0.5f, -0.5f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}}
-		};
+		MemoryAllocation indexBufferAllocation;
+		std::unique_ptr<VulkanApplicationUniformArena> uniformArena;
+		std::vector<uint32_t> objectUniformOffsets; // dynamic offset of each object's ubo in the current frame
+		uint32_t cameraUniformOffset = 0; // dynamic offset of the shared camera ubo, push constant path only
+		std::vector<glm::mat4> objectModels;
+		std::vector<uint32_t> objectLods; // index into mesh.lods for each object in the current frame
+		std::vector<uint32_t> objectMaterials; // slot of each object's texture in the bindless table
+		bool lodEnabled = true;
+		LodFrameStats lodStats;
+		std::vector<VkBuffer> instanceBuffers; // one persistently mapped buffer per frame in flight, instanced path only
+		std::vector<MemoryAllocation> instanceBufferAllocations;
+		std::vector<InstanceBatch> instanceBatches; // batches of this frame's instance buffer, in lod order
+		std::vector<bool> instanceBuffersInObjectOrder; // instance i is object i, what the gpu driven path needs and the scene graph writes into
+		std::unique_ptr<VulkanApplicationSceneGraph> sceneGraph;
+		std::vector<uint32_t> objectNodes; // scene graph node of each object
+		std::vector<SceneGraphOutput> sceneGraphOutputs; // reused every frame
+		double sceneGraphSeconds = 0.0;
+		glm::mat4 viewProjection = glm::mat4(1.0f); // camera of the last updateUniformBuffer, for culling
+		glm::vec3 eye = glm::vec3(0.0f);
+		float pixelsPerUnit = 1.0f;
+		glm::vec4 boundingSphere; // see getBoundingSphere()
+		CullingBvh cullingBvh; // built once, objects never leave their grid cell
+		std::vector<uint32_t> visibleObjects; // what the cpu paths draw this frame, every object when culling is off
+		bool cullingEnabled = true;
+		CullingStats cullingStats;
+		double cullingSeconds = 0.0;
 
-		const std::vector<uint16_t> indices = {
-			0, 1, 2, 2, 3, 0,
-			4, 5, 6, 6, 7, 4
-		};
+		Mesh mesh; // vertices and indices stay empty when the mesh came from the cache
+		MeshCacheView meshCache; // only mapped while the buffers are being created
+		uint32_t indexCount = 0;
+		glm::mat4 positionDequantization = glm::mat4(1.0f); // identity unless the vertex format stores positions relative to the bounds
 	public:
-		VulkanApplicationBufferManager(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool);
+		VulkanApplicationBufferManager(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext);
 		~VulkanApplicationBufferManager();
-		void cleanup(VkDevice logicalDevice);
-		void createVertexBuffer(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool);
-		void createIndexBuffer(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool);
-		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDevice logicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool);
-		void createUniformBuffers(VkDevice logicalDevice, VkPhysicalDevice physicalDevice);
-		void updateUniformBuffer(uint32_t currentImage, VkExtent2D swapchainExtent);
+		void cleanup(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator);
+		void loadMesh();
+		void createVertexBuffer(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext);
+		void createIndexBuffer(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext);
+		void createUniformBuffers(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator);
+		void createInstanceBuffers(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator);
+		void updateInstanceBuffer(uint32_t currentImage);
+		void fillInstanceTints(uint32_t currentImage);
+		void createSceneGraph();
+		void createCullingBvh();
+		void updateUniformBuffer(uint32_t currentImage, VkExtent2D swapchainExtent, DrawPath drawPath);
+		glm::vec3 getObjectPosition(uint32_t objectIndex);
+		glm::mat4 getObjectLocal(uint32_t objectIndex, float time);
+		glm::vec4 getObjectTint(uint32_t objectIndex);
+		void setObjectMaterial(uint32_t objectIndex, uint32_t materialIndex);
+		std::vector<uint32_t>& getObjectMaterials();
+		glm::vec4 computeBoundingSphere();
+		glm::vec4 getBoundingSphere();
+		uint32_t getGridSize();
+		uint32_t selectLod(const glm::mat4& model, const glm::vec3& eye, float pixelsPerUnit);
 		VkBuffer getVertexBuffer();
-		VkDeviceMemory getVertexBufferMemory();
+		MemoryAllocation getVertexBufferAllocation();
 		VkBuffer getIndexBuffer();
-		VkDeviceMemory getIndexBufferMemory();
-		std::vector<VkBuffer> getUniformBuffers();
-		std::vector<VkDeviceMemory> getUniformBuffersMemories();
-		std::vector<void*> getUniformBuffersMapped();
-		std::vector<uint16_t> getIndices();
+		MemoryAllocation getIndexBufferAllocation();
+		VulkanApplicationUniformArena& getUniformArena();
+		std::vector<uint32_t>& getObjectUniformOffsets();
+		uint32_t getCameraUniformOffset();
+		std::vector<glm::mat4>& getObjectModels();
+		VkBuffer getInstanceBuffer(uint32_t frameIndex);
+		std::vector<VkBuffer>& getInstanceBuffers();
+		std::vector<uint32_t>& getVisibleObjects();
+		CullingStats getCullingStats();
+		double getCullingSeconds();
+		bool getCullingEnabled();
+		void setCullingEnabled(bool enabled);
+		SceneGraphStats getSceneGraphStats();
+		double getSceneGraphSeconds();
+		std::vector<InstanceBatch>& getInstanceBatches();
+		std::vector<MeshLod>& getMeshLods();
+		std::vector<uint32_t>& getObjectLods();
+		LodFrameStats getLodStats();
+		bool getLodEnabled();
+		void setLodEnabled(bool enabled);
+		glm::mat4 getViewProjection();
+		glm::vec3 getEye();
+		float getPixelsPerUnit();
+		VertexFormat getVertexFormat();
+		VkIndexType getIndexType();
+		Mesh& getMesh();
 };
 
 #endif
\ No newline at end of file
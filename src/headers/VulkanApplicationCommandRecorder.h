@@ -0,0 +1,46 @@
+#ifndef VULKAN_APPLICATION_COMMAND_RECORDER
+#define VULKAN_APPLICATION_COMMAND_RECORDER
+
+/*	Splits a long list of draws into contiguous ranges, each recorded into
+	its own secondary command buffer by a job, which the main thread then
+	executes inside the render pass.
+
+	Command pools can't be touched by two threads at once, and a pool can
+	only be reset once the gpu is done with everything allocated from it,
+	so every range gets its own pool per frame in flight. Only one job
+	records a range, whichever worker it lands on. Resetting the
+	whole pool at the start of a frame is cheaper than resetting buffers
+	one by one, which is why the pools don't set the reset bit.
+
+	Secondaries inherit nothing but the render pass and framebuffer, the
+	callback has to bind the pipeline, buffers, dynamic state and
+	descriptors again before drawing.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationJobSystem.h"
+
+const uint32_t kMAX_RECORDING_THREADS = 16;
+
+// records draws [first, last) into commandBuffer and returns how many it recorded
+using RecordRangeFunction = std::function<uint32_t(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)>;
+
+class VulkanApplicationCommandRecorder {
+	private:
+		VkDevice logicalDevice;
+		uint32_t maxThreads;
+		std::vector<std::vector<VkCommandPool>> commandPools; // [frame in flight][range]
+		std::vector<std::vector<VkCommandBuffer>> secondaryCommandBuffers; // one per pool
+
+		void recordSecondary(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer,
+			uint32_t first, uint32_t last, const RecordRangeFunction& recordRange, uint32_t& drawCount);
+	public:
+		VulkanApplicationCommandRecorder(VkDevice logicalDevice, uint32_t queueFamilyIndex, uint32_t maxThreads = 0);
+		~VulkanApplicationCommandRecorder();
+		void cleanup();
+		uint32_t record(VkCommandBuffer primaryCommandBuffer, uint32_t frameIndex, uint32_t threadCount, VkRenderPass renderPass,
+			VkFramebuffer framebuffer, uint32_t drawCount, const RecordRangeFunction& recordRange);
+		uint32_t getMaxThreads();
+};
+
+#endif
\ No newline at end of file
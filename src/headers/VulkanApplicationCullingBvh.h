@@ -0,0 +1,71 @@
+#ifndef VULKAN_APPLICATION_CULLING_BVH
+#define VULKAN_APPLICATION_CULLING_BVH
+
+/*	CPU frustum culling over a 4 wide bounding volume hierarchy.
+
+	Boxes are stored as center and half extent, structure of arrays, so a
+	plane test is three multiply adds for the distance and three for the
+	projected extent, done for 4 (SSE) or 8 (AVX) boxes at once. A box is
+	outside when it's entirely behind any of the 6 planes.
+
+	Every node holds the bounds of its 4 children side by side, one SSE
+	test decides all of them. The build reorders the objects so every
+	subtree covers one contiguous range, which means a child that's fully
+	inside the frustum adds its whole range without testing anything below
+	it. Leaves are runs of up to kCULLING_BVH_LEAF_SIZE objects tested with
+	the widest SIMD available. Without SSE everything falls back to the same
+	math one box at a time.
+
+	The bvh is built once, moving objects would need a refit.
+*/
+
+#include "VulkanApplicationHelpers.h"
+
+const uint32_t kCULLING_BVH_LEAF_SIZE = 16;
+const uint32_t kCULLING_BVH_PADDING = 8; // boxes past the end so the widest leaf test can read a full register
+const uint32_t kCULLING_BENCHMARK_OBJECTS = 100000;
+
+struct CullingBox {
+	glm::vec3 center;
+	glm::vec3 extent;
+};
+
+// a child is a leaf when its child index is -1, empty slots have no objects and a negative extent so they always fail
+struct alignas(16) CullingBvhNode {
+	float centerX[4];
+	float centerY[4];
+	float centerZ[4];
+	float extentX[4];
+	float extentY[4];
+	float extentZ[4];
+	int32_t children[4];
+	uint32_t first[4]; // object range under each child, leaf or not
+	uint32_t count[4];
+};
+
+struct CullingBvh {
+	// boxes in bvh order, padded by kCULLING_BVH_PADDING
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+	std::vector<uint32_t> objectIndices; // bvh order to the caller's object index
+	std::vector<CullingBvhNode> nodes; // root first
+	uint32_t objectCount = 0;
+};
+
+struct CullingStats {
+	uint32_t visibleObjects = 0;
+	uint64_t boxesTested = 0;
+};
+
+CullingBvh buildCullingBvh(const std::vector<CullingBox>& boxes);
+void cullFrustumBvh(const CullingBvh& bvh, const Frustum& frustum, std::vector<uint32_t>& visibleObjects, CullingStats* stats = nullptr);
+void cullFrustumLinear(const CullingBvh& bvh, const Frustum& frustum, std::vector<uint32_t>& visibleObjects, CullingStats* stats = nullptr);
+bool isBoxInFrustum(const Frustum& frustum, const CullingBox& box);
+const char* getCullingSimdName();
+void runFrustumCullingBenchmark(uint32_t objectCount);
+
+#endif
\ No newline at end of file
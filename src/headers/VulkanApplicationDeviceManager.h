@@ -3,6 +3,7 @@
 
 #include "VulkanApplicationHelpers.h"
 #include <set>
+#include <cstring>
 
 class VulkanApplicationDeviceManager {
 	private:
@@ -10,6 +11,12 @@ class VulkanApplicationDeviceManager {
 		VkDevice logicalDevice;
 		VkQueue presentQueue;
 		VkQueue graphicsQueue;
+		VkQueue transferQueue;
+		QueueFamilyIndices queueFamilyIndices;
+		VkPhysicalDeviceFeatures enabledFeatures{};
+		bool drawIndirectCountEnabled = false; // VK_KHR_draw_indirect_count, only enabled when the device has it
+		bool graphicsComputeSupported = false; // the graphics queue can also run the culling compute pass
+		bool descriptorIndexingEnabled = false; // VK_EXT_descriptor_indexing with everything the bindless textures need
 		void pickPhysicalDevice(VkInstance instance, VkSurfaceKHR surface);
 	public:
 		VulkanApplicationDeviceManager(VkInstance instance, VkSurfaceKHR surface);
@@ -19,9 +26,17 @@ class VulkanApplicationDeviceManager {
 		VkDevice getLogicalDevice();
 		bool isDeviceSuitable(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
 		bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice);
+		bool checkOptionalExtensionSupport(VkPhysicalDevice physicalDevice, const char* extensionName);
+		bool checkDescriptorIndexingSupport(VkPhysicalDevice physicalDevice);
 		void createLogicalDevice(VkSurfaceKHR surface);
 		VkQueue getGraphicsQueue();
 		VkQueue getPresentQueue();
+		VkQueue getTransferQueue();
+		QueueFamilyIndices getQueueFamilyIndices();
+		VkPhysicalDeviceFeatures getEnabledFeatures();
+		bool getDrawIndirectCountEnabled();
+		bool getGraphicsComputeSupported();
+		bool getDescriptorIndexingEnabled();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef VULKAN_APPLICATION_GPU_CULLER
+#define VULKAN_APPLICATION_GPU_CULLER
+
+/*	Compute frustum culling and lod selection for the gpu driven path.
+
+	Model matrices come from the per frame instance buffer the instanced
+	path already fills, bound as a storage buffer this time. One thread per
+	object tests the mesh bounding sphere against the frustum, picks a lod
+	the same way VulkanApplicationBufferManager::selectLod() does and writes
+	a VkDrawIndexedIndirectCommand whose firstInstance is the object, so the
+	vertex shader still finds its model through the instance binding. The
+	cpu records the same handful of commands no matter how many objects
+	there are.
+
+	Draws go out the best way the device allows:
+	- kIndirectCount, visible draws are compacted with an atomic and
+	  vkCmdDrawIndexedIndirectCountKHR reads the count the gpu wrote
+	- kMultiDrawIndirect, every object keeps its own slot, culled ones get
+	  zero instances and one vkCmdDrawIndexedIndirect covers all of them
+	- kSingleDrawIndirect, same slots with one indirect draw per object
+
+	Visible object and triangle counts are read back once the frame's fence
+	has signalled. With debug on the cpu culls the same spheres and counts
+	the frames where the two disagree, which is how the path gets checked on
+	lavapipe without a gpu.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationMemoryAllocator.h"
+#include "VulkanApplicationMeshLoader.h"
+
+const uint32_t kCULL_GROUP_SIZE = 64; // must match local_size_x in cull.comp
+const uint32_t kCULL_FLAG_COMPACT = 1;
+const uint32_t kCULL_FLAG_LOD = 2;
+
+enum class IndirectDrawMode : uint32_t {
+	kIndirectCount,
+	kMultiDrawIndirect,
+	kSingleDrawIndirect
+};
+
+// must match cull.comp, 120 of the guaranteed 128 bytes
+struct CullPushConstants {
+	std::array<glm::vec4, 6> planes;
+	glm::vec4 eye; // w is pixels per unit over kLOD_PIXEL_ERROR, so a lod fits when error * w / distance <= 1
+	uint32_t objectCount;
+	uint32_t flags;
+};
+
+// start of the mesh buffer, the MeshLod table follows it
+struct CullMeshHeader {
+	glm::vec4 boundingSphere; // center in the space the vertex buffer is encoded in, radius in mesh units
+	uint32_t lodCount;
+	uint32_t padding[3];
+};
+
+// written by cull.comp, drawCount is also the count buffer for kIndirectCount
+struct CullResults {
+	uint32_t drawCount;
+	uint32_t triangleCount;
+};
+
+struct GpuCullStats {
+	uint32_t visibleObjects = 0;		// from the most recently read back frame
+	uint32_t trianglesSubmitted = 0;
+	uint64_t framesValidated = 0;		// debug only, frames the cpu culled as well
+	uint64_t framesMismatched = 0;
+};
+
+class VulkanApplicationGpuCuller {
+	private:
+		VkDevice logicalDevice;
+		VulkanApplicationMemoryAllocator* allocator;
+		IndirectDrawMode drawMode;
+		PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+		uint32_t objectCount;
+		glm::vec4 boundingSphere;
+
+		VkDescriptorSetLayout descriptorSetLayout;
+		VkDescriptorPool descriptorPool;
+		std::vector<VkDescriptorSet> descriptorSets;
+		VkPipelineLayout pipelineLayout;
+		VkPipeline pipeline;
+
+		VkBuffer meshBuffer;
+		MemoryAllocation meshBufferAllocation;
+		std::vector<VkBuffer> drawBuffers; // per frame in flight, one command per object
+		std::vector<MemoryAllocation> drawBufferAllocations;
+		std::vector<VkBuffer> resultBuffers; // per frame in flight, host visible so they can be read back
+		std::vector<MemoryAllocation> resultBufferAllocations;
+
+		std::vector<bool> framePending; // culled but not read back yet
+		std::vector<uint32_t> expectedDrawCounts; // cpu culled count of each frame, debug only
+		GpuCullStats stats;
+
+		void createMeshBuffer(const std::vector<MeshLod>& lods);
+		void createFrameBuffers();
+		void createDescriptorSets(const std::vector<VkBuffer>& instanceBuffers);
+		void createPipeline(VkPipelineCache pipelineCache);
+	public:
+		VulkanApplicationGpuCuller(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkPipelineCache pipelineCache, IndirectDrawMode drawMode, uint32_t objectCount,
+			const std::vector<MeshLod>& lods, const glm::vec4& boundingSphere, const std::vector<VkBuffer>& instanceBuffers);
+		~VulkanApplicationGpuCuller();
+		void cleanup();
+		void recordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex, const CullPushConstants& pushConstants);
+		uint32_t recordDraws(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		void collectResults(uint32_t frameIndex);
+		void validate(uint32_t frameIndex, const std::vector<glm::mat4>& models, const Frustum& frustum);
+		IndirectDrawMode getDrawMode();
+		GpuCullStats getStats();
+};
+
+bool isGpuCullingSupported(const VkPhysicalDeviceFeatures& features, bool graphicsComputeSupported);
+IndirectDrawMode selectIndirectDrawMode(const VkPhysicalDeviceFeatures& features, bool drawIndirectCountEnabled);
+const char* getIndirectDrawModeName(IndirectDrawMode drawMode);
+
+#endif
\ No newline at end of file
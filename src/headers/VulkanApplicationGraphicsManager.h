@@ -2,22 +2,32 @@
 #define VULKAN_APPLICATION_GRAPHICS_MANAGER
 
 #include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationVertexFormats.h"
+#include "VulkanApplicationPipelineRegistry.h"
 
 class VulkanApplicationGraphicsManager {
 	private:
 		VkRenderPass renderPass;
 		VkPipelineLayout pipelineLayout;
-		VkPipeline graphicsPipeline;
+		std::unique_ptr<VulkanApplicationPipelineRegistry> pipelineRegistry; // every pipeline shares the layout and render pass
+		std::vector<PipelineHandle> drawPathPipelines; // one per DrawPath
+		PipelineDescription baseDescription; // what the draw paths share, the vertex shader and instancing are set per path
+		ShaderPermutation shaderPermutation;
+
+		void requestDrawPathPipelines();
 	public:
 		VulkanApplicationGraphicsManager(VkFormat swapchainImageFormat, VkDevice logicalDevice, VkPhysicalDevice physicalDevice);
 		~VulkanApplicationGraphicsManager();
 		void cleanup(VkDevice logicalDevice);
 		VkRenderPass getRenderPass();
 		VkPipelineLayout getPipelineLayout();
-		VkPipeline getGraphicsPipeline();
+		VkPipeline getGraphicsPipeline(DrawPath drawPath);
+		VulkanApplicationPipelineRegistry& getPipelineRegistry();
+		void setShaderPermutation(const ShaderPermutation& permutation);
+		ShaderPermutation getShaderPermutation();
 		void createRenderPass(VkFormat swapchainImageFormat, VkDevice logicalDevice,  VkPhysicalDevice physicalDevice);
-		void createGraphicsPipeline(VkDevice logicalDevice, VkDescriptorSetLayout descriptorSetLayout);
-		VkShaderModule createShaderModule(const std::vector<char>& code, VkDevice logicalDevice);
+		void createGraphicsPipeline(VkDevice logicalDevice, VkPipelineCache pipelineCache, VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSetLayout bindlessSetLayout, VertexFormat vertexFormat);
+		void createPipelineLayout(VkDevice logicalDevice, VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSetLayout bindlessSetLayout);
 };
 
 #endif
\ No newline at end of file
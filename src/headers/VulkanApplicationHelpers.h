@@ -16,6 +16,7 @@
 #include <stdexcept>
 #include <cstdlib>
 #include <fstream>
+#include <string>
 
 #include <vector>
 #include <array>
@@ -23,6 +24,7 @@
 #include <limits>
 #include <algorithm>
 #include <memory>
+#include <chrono>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -38,6 +40,11 @@ const uint32_t kWIDTH = 800;
 const uint32_t kHEIGHT = 600;
 const bool debug = true;
 const int kMAX_FRAMES_IN_FLIGHT = 2;
+const VkDeviceSize kSTAGING_RING_SIZE = 32 * 1024 * 1024;
+const VkDeviceSize kUNIFORM_ARENA_SIZE = 4 * 1024 * 1024; // per frame in flight
+const uint32_t kOBJECT_COUNT = 1024;
+const float kLOD_PIXEL_ERROR = 1.0f; // largest simplification error allowed on screen
+const std::string kMODEL_PATH = "models/model.obj"; // optional, the built in quads are drawn when missing
 
 const std::vector<const char*> validationLayers = {
 	"VK_LAYER_KHRONOS_validation"
@@ -53,6 +60,7 @@ const std::vector<const char*> deviceExtensions = {
 struct QueueFamilyIndices {
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentFamily;
+	std::optional<uint32_t> transferFamily; // same as graphicsFamily when the device has no separate transfer family
 
 	bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
 };
@@ -63,45 +71,74 @@ struct SwapchainSupportDetails {
 	std::vector<VkPresentModeKHR> presentModes;
 };
 
+// cpu side vertex, see VulkanApplicationVertexFormats.h for what actually goes into vertex buffers
 struct Vertex {
 	glm::vec3 pos;
 	glm::vec3 color;
 	glm::vec2 texCoord;
 
-	static VkVertexInputBindingDescription getBindingDescription() {
-		VkVertexInputBindingDescription bindingDescription{};
-		bindingDescription.binding = 0;
-		bindingDescription.stride = sizeof(Vertex);
-		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-		return bindingDescription;
+	bool operator==(const Vertex& other) const {
+		return pos == other.pos && color == other.color && texCoord == other.texCoord;
 	}
+};
 
-	static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
-		std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
-
-		attributeDescriptions[0].binding = 0;
-		attributeDescriptions[0].location = 0;
-		attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-		attributeDescriptions[0].offset = offsetof(Vertex, pos);
-
-		attributeDescriptions[1].binding = 0;
-		attributeDescriptions[1].location = 1;
-		attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-		attributeDescriptions[1].offset = offsetof(Vertex, color);
+// a range of device memory handed out by VulkanApplicationMemoryAllocator
+struct MemoryAllocation {
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	void* mapped = nullptr; // only set for host visible memory, already offset to the start of the allocation
+	uint32_t memoryTypeIndex = 0;
+	uint32_t blockIndex = 0;
+};
 
-		attributeDescriptions[2].binding = 0;
-		attributeDescriptions[2].location = 2;
-		attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-		attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
+class VulkanApplicationMemoryAllocator;
 
-		return attributeDescriptions;
-	}
+// one level of a texture, rgba8 texels or whole 4x4 blocks for block compressed formats
+struct TextureMip {
+	uint32_t width;
+	uint32_t height;
+	std::vector<uint8_t> pixels;
 };
 
 struct UniformBufferObject {
 	glm::mat4 model;
 	glm::mat4 view;
 	glm::mat4 projection;
+	uint32_t materialIndex;
+};
+
+// shared by every draw on the push constant path, must match vert_push.vert
+struct CameraUniformObject {
+	glm::mat4 view;
+	glm::mat4 projection;
+};
+
+// per draw data on the push constant path, must stay within the guaranteed 128 bytes
+struct ObjectPushConstants {
+	glm::mat4 model;
+	uint32_t objectIndex;
+	uint32_t materialIndex;
+};
+
+// per instance vertex data on the instanced path, must match vert_instanced.vert
+struct InstanceData {
+	glm::mat4 model;
+	glm::vec4 tint; // rgb multiplied into the vertex color, w is the material index
+};
+
+// world space planes facing into the frustum, xyz is the unit normal and w the distance
+struct Frustum {
+	std::array<glm::vec4, 6> planes; // left, right, bottom, top, near, far
+};
+
+// how per object data reaches the vertex shader, switched at runtime to compare them
+enum class DrawPath : uint32_t {
+	kUniformBuffer,		// one ubo per object in the uniform arena, rebinds the set with a new dynamic offset per draw
+	kPushConstants,		// one camera ubo per frame, model matrix and indices pushed per draw
+	kInstanced,			// one camera ubo per frame, models in a per instance vertex buffer, one draw per lod in use
+	kGpuDriven,			// same instance buffer, a compute pass culls and picks lods and writes the indirect draws
+	kCount
 };
 
 /****************************************************
@@ -112,21 +149,41 @@ std::vector<const char*> getRequiredExtensions();
 bool checkValidationLayerSupport();
 QueueFamilyIndices findQueueFamilies(VkPhysicalDevice pDevice, VkSurfaceKHR surface);
 SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
-VkImageView createImageView(VkImage image, VkFormat format, VkDevice logicalDevice, VkImageAspectFlags aspectFlags);
+VkImageView createImageView(VkImage image, VkFormat format, VkDevice logicalDevice, VkImageAspectFlags aspectFlags, uint32_t mipLevels = 1);
 std::vector<char> readFile(const std::string& filename);
-void createBuffer(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage,
-	VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+bool writeFileAtomically(const std::string& path, const char* data, size_t size);
+void createBuffer(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& bufferAllocation);
+void destroyBuffer(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkBuffer& buffer, MemoryAllocation& bufferAllocation);
 void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
 	VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image,
-	VkDeviceMemory& imageMemory, VkDevice logicalDevice, VkPhysicalDevice physicalDevice);
+	MemoryAllocation& imageAllocation, VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, uint32_t mipLevels = 1);
+void destroyImage(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkImage& image, MemoryAllocation& imageAllocation);
 bool hasStencilComponent(VkFormat format);
-void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout,
-	VkCommandPool commandPool, VkDevice logicalDevice, VkQueue graphicsQueue);
-void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height,
-	VkDevice logicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
-void endSingleTimeCommands(VkCommandBuffer commandBuffer, VkCommandPool commandPool, VkDevice logicalDevice, VkQueue graphicsQueue);
-VkCommandBuffer beginSingleTimeCommands(VkDevice logicalDevice, VkCommandPool commandPool);
+const char* getDrawPathName(DrawPath drawPath);
+Frustum extractFrustum(const glm::mat4& viewProjection);
+bool isSphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
+void recordImageLayoutTransition(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevel = 0);
+void recordCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevel = 0);
 uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
 VkFormat findDepthFormat(VkPhysicalDevice physicalDevice);
+bool supportsLinearBlit(VkPhysicalDevice physicalDevice, VkFormat format);
 VkFormat findSupportedFormat(VkPhysicalDevice physicalDevice, const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+
+// average seconds per call over at least a quarter second and ten calls, for the benchmarks
+template <typename Function>
+double timeBenchmark(Function&& function) {
+	using clock = std::chrono::high_resolution_clock;
+	uint32_t iterations = 0;
+	auto start = clock::now();
+	double elapsed = 0.0;
+
+	do {
+		function();
+		iterations++;
+		elapsed = std::chrono::duration<double>(clock::now() - start).count();
+	} while (elapsed < 0.25 || iterations < 10);
+
+	return elapsed / iterations;
+}
 #endif
\ No newline at end of file
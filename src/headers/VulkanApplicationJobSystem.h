@@ -0,0 +1,108 @@
+#ifndef VULKAN_APPLICATION_JOB_SYSTEM
+#define VULKAN_APPLICATION_JOB_SYSTEM
+
+/*	Work stealing job scheduler.
+
+	Every worker owns a deque. Jobs a worker schedules go on the back of
+	its own deque and it takes work from the back too, so the most recent,
+	cache warm job runs first. An idle worker steals from the front of
+	somebody else's deque, which is where the oldest and usually biggest
+	pieces of work sit. The thread that created the system is worker 0,
+	anything scheduled from a thread that isn't a worker lands on its deque.
+
+	A job can depend on other jobs and only gets queued once all of them
+	finished. If one of them threw, the job is skipped and carries the
+	exception instead, wait() rethrows it. Threads that wait never block
+	while there's work, they run queued jobs until the one they wait for is
+	done, so jobs can wait on jobs without deadlocking the pool.
+
+	Long jobs that nobody waits for right away, pipeline compiles and
+	texture decodes, go through scheduleBackground() onto a queue of their
+	own. Idle workers take from it, a thread that waits only does when
+	it's waiting on a background job itself. Otherwise a frame's
+	parallelFor() could pick up a compile while waiting for its chunks and
+	hitch the frame. With a single thread there are no workers, so
+	background jobs only run when something waits for them.
+
+	Workers spin for a little while when they run dry and sleep on a
+	condition variable after that.
+
+	parallelFor() is the common case: it hands out chunks of grainSize
+	indices from an atomic counter to as many runner jobs as there are
+	threads, and the calling thread works through chunks as well.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+const uint32_t kJOB_SPIN_COUNT = 256; // failed steal rounds before a worker goes to sleep
+const uint32_t kJOB_BENCHMARK_JOBS = 1000000;
+
+struct Job {
+	std::function<void()> function;
+	std::atomic<uint32_t> unfinishedDependencies{ 1 }; // the extra 1 is released once scheduling is done
+	std::atomic<bool> finished{ false };
+	bool background = false; // queued on the background queue, set before it's scheduled
+	std::mutex mutex; // guards continuations and error
+	std::vector<std::shared_ptr<Job>> continuations;
+	std::exception_ptr error;
+};
+
+struct JobHandle {
+	std::shared_ptr<Job> job;
+};
+
+struct JobSystemStats {
+	uint64_t jobsExecuted = 0;
+	uint64_t jobsStolen = 0;
+};
+
+class VulkanApplicationJobSystem {
+	private:
+		struct WorkerQueue {
+			std::mutex mutex;
+			std::deque<std::shared_ptr<Job>> jobs;
+		};
+
+		uint32_t threadCount;
+		std::vector<std::unique_ptr<WorkerQueue>> queues; // one per thread, the creating thread's first
+		WorkerQueue backgroundQueue; // oldest first, only workers and whoever waits on one of its jobs take from it
+		std::vector<std::thread> workers;
+		std::atomic<bool> running{ true };
+		std::atomic<uint32_t> queuedJobs{ 0 };
+		std::atomic<uint32_t> sleepingWorkers{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable wakeCondition;
+		std::atomic<uint64_t> jobsExecuted{ 0 };
+		std::atomic<uint64_t> jobsStolen{ 0 };
+
+		void workerLoop(uint32_t workerIndex);
+		uint32_t getCurrentWorker();
+		void push(const std::shared_ptr<Job>& job);
+		std::shared_ptr<Job> pop(uint32_t workerIndex, bool background);
+		bool runOne(uint32_t workerIndex, bool background);
+		void execute(const std::shared_ptr<Job>& job);
+		JobHandle submit(const std::shared_ptr<Job>& job, const std::vector<JobHandle>& dependencies);
+	public:
+		VulkanApplicationJobSystem(uint32_t threadCount = 0);
+		~VulkanApplicationJobSystem();
+		void cleanup();
+		JobHandle schedule(std::function<void()> function, const std::vector<JobHandle>& dependencies = {});
+		JobHandle scheduleBackground(std::function<void()> function, const std::vector<JobHandle>& dependencies = {});
+		void wait(const JobHandle& handle);
+		bool isFinished(const JobHandle& handle);
+		void parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t first, uint32_t last)>& function);
+		uint32_t getThreadCount();
+		JobSystemStats getStats();
+};
+
+// shared by everything in the renderer, started on first use with a thread per core
+VulkanApplicationJobSystem& getJobSystem();
+void runJobSystemBenchmark(uint32_t jobCount);
+
+#endif
\ No newline at end of file
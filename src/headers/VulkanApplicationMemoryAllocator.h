@@ -0,0 +1,73 @@
+#ifndef VULKAN_APPLICATION_MEMORY_ALLOCATOR
+#define VULKAN_APPLICATION_MEMORY_ALLOCATOR
+
+/*	Sub-allocates buffers and images out of large per memory type
+	blocks so the program only calls vkAllocateMemory a handful of times
+	instead of once per resource (maxMemoryAllocationCount can be as low as 4096).
+
+	Each block keeps a list of ranges sorted by offset that covers the whole
+	block, free ranges included. Allocation is first fit, neighbouring free
+	ranges are merged on free. Buffers (linear) and optimal tiling images are
+	kept bufferImageGranularity apart when they would share a page.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include <mutex>
+
+struct MemoryAllocatorStats {
+	uint32_t blockCount = 0;
+	uint32_t dedicatedCount = 0;		// allocations too large to share a block
+	uint32_t allocationCount = 0;
+	uint32_t peakAllocationCount = 0;
+	uint32_t deviceAllocationCalls = 0;	// total vkAllocateMemory calls
+	VkDeviceSize bytesReserved = 0;		// memory owned by blocks and dedicated allocations
+	VkDeviceSize bytesInUse = 0;
+	VkDeviceSize peakBytesInUse = 0;
+};
+
+class VulkanApplicationMemoryAllocator {
+	private:
+		enum class RangeType : uint8_t { kFree, kLinear, kOptimal };
+
+		struct MemoryRange {
+			VkDeviceSize offset;
+			VkDeviceSize size;
+			RangeType type;
+		};
+
+		struct MemoryBlock {
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			VkDeviceSize freeBytes = 0;
+			void* mapped = nullptr;
+			uint32_t memoryTypeIndex = 0;
+			bool dedicated = false;
+			std::vector<MemoryRange> ranges;
+		};
+
+		static constexpr VkDeviceSize kDEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+		VkDevice logicalDevice;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		VkDeviceSize bufferImageGranularity;
+		// unique_ptr so block pointers stay valid when the vector grows, null entries are reusable slots
+		std::vector<std::unique_ptr<MemoryBlock>> blocks;
+		MemoryAllocatorStats stats;
+		std::mutex allocatorMutex;
+
+		VkDeviceSize getBlockSize(uint32_t memoryTypeIndex);
+		uint32_t createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated);
+		void destroyBlock(uint32_t blockIndex);
+		bool tryAllocateFromBlock(uint32_t blockIndex, const VkMemoryRequirements& requirements, RangeType type, MemoryAllocation& allocation);
+		bool conflictsWithGranularity(RangeType a, RangeType b);
+	public:
+		VulkanApplicationMemoryAllocator(VkDevice logicalDevice, VkPhysicalDevice physicalDevice);
+		~VulkanApplicationMemoryAllocator();
+		void cleanup();
+		MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool optimalTiling);
+		void free(MemoryAllocation& allocation);
+		MemoryAllocatorStats getStats();
+		void printStats();
+};
+
+#endif
\ No newline at end of file
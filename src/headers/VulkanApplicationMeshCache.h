@@ -0,0 +1,75 @@
+#ifndef VULKAN_APPLICATION_MESH_CACHE
+#define VULKAN_APPLICATION_MESH_CACHE
+
+/*	Binary mesh cache so a model only has to be parsed once.
+
+	A cache file is a MeshCacheHeader and the lod table followed by the
+	vertex and index blobs, each starting on a kMESH_CACHE_ALIGNMENT
+	boundary. Vertices are stored already encoded in the mesh's
+	VertexFormat and indices in the type the index buffer uses, so a
+	mapped cache goes into staging memory with a plain memcpy.
+
+	The header records a hash of the source file's bytes. A cache with a
+	different hash, version or vertex stride is ignored and rebuilt from
+	the source.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationMeshLoader.h"
+#include "VulkanApplicationMeshOptimizer.h"
+#include "VulkanApplicationMeshSimplifier.h"
+#include <string>
+
+const uint32_t kMESH_CACHE_VERSION = 4; // bump whenever the loader's output changes
+const VkDeviceSize kMESH_CACHE_ALIGNMENT = 64;
+
+struct MeshCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash;
+	uint32_t vertexStride;
+	uint32_t vertexFormat;	// VertexFormat
+	uint32_t indexType;		// VkIndexType
+	uint32_t lodCount;
+	uint64_t vertexCount;
+	uint64_t indexCount;
+	uint64_t lodOffset;		// from the start of the file
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+// read only mapping of a whole file
+struct MappedFile {
+	const char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int descriptor = -1;
+#endif
+};
+
+// everything points into the mapping and is only valid until closeMeshCache
+struct MeshCacheView {
+	MappedFile file;
+	const MeshCacheHeader* header = nullptr;
+	const void* vertices = nullptr;
+	const void* indices = nullptr;
+	const MeshLod* lods = nullptr;
+	VkDeviceSize vertexBytes = 0;
+	VkDeviceSize indexBytes = 0;
+};
+
+bool mapFile(const std::string& path, MappedFile& file);
+void unmapFile(MappedFile& file);
+uint64_t hashSourceFile(const std::string& path);
+std::string getMeshCachePath(const std::string& sourcePath);
+bool openMeshCache(const std::string& path, uint64_t sourceHash, MeshCacheView& cache);
+void closeMeshCache(MeshCacheView& cache);
+void writeMeshCache(const std::string& path, const Mesh& mesh, uint64_t sourceHash);
+void runMeshCacheBenchmark(const std::string& sourcePath);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef VULKAN_APPLICATION_MESH_LOADER
+#define VULKAN_APPLICATION_MESH_LOADER
+
+/*	Loads Wavefront OBJ files into an indexed Mesh.
+
+	The file is read in one go and split into chunks on line boundaries,
+	each chunk is parsed as its own job. Face indices are resolved
+	against the chunk's own vertex counts first and fixed up once every
+	chunk is done, so negative (relative) indices work across chunks.
+
+	Identical vertices are merged with an open addressing hash table over
+	the raw Vertex bytes, 16-bit indices are used whenever the vertex count
+	allows it. The vertex format is picked the same way.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationVertexFormats.h"
+#include <string>
+
+// a range of Mesh::indices, every lod draws from the same vertex buffer
+struct MeshLod {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error; // in mesh units, 0 for the full detail lod
+};
+
+struct Mesh {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices; // always 32 bit on the cpu, see indexType for what the gpu gets
+	std::vector<MeshLod> lods; // finest first, lods[0] is the mesh as loaded
+	VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+	VertexFormat vertexFormat = VertexFormat::kFloat; // layout the vertices are encoded in for the gpu
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+
+	VertexQuantization getVertexQuantization() const { return ::getVertexQuantization(boundsMin, boundsMax); }
+	VkDeviceSize getIndexSize() const { return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+};
+
+struct MeshLoadStats {
+	uint64_t fileBytes = 0;
+	uint32_t threads = 0;
+	uint64_t triangles = 0;
+	uint64_t sourceVertices = 0;	// face corners before deduplication
+	uint64_t uniqueVertices = 0;
+	VertexFormat vertexFormat = VertexFormat::kFloat;
+	double readSeconds = 0.0;
+	double parseSeconds = 0.0;
+	double dedupSeconds = 0.0;
+	double totalSeconds = 0.0;
+};
+
+// fills in indexType, bounds and the smallest vertexFormat within tolerance from the vertices and indices already in the mesh,
+// plus a single full detail lod if there are none yet
+void finalizeMesh(Mesh& mesh);
+Mesh loadObjMesh(const std::string& path, MeshLoadStats* stats = nullptr);
+void printMeshLoadStats(const std::string& path, const MeshLoadStats& stats);
+
+#endif
\ No newline at end of file
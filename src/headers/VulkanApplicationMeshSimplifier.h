@@ -0,0 +1,39 @@
+#ifndef VULKAN_APPLICATION_MESH_SIMPLIFIER
+#define VULKAN_APPLICATION_MESH_SIMPLIFIER
+
+/*	Quadric error edge collapse simplification (Garland and Heckbert 1997).
+
+	Collapses only ever move a vertex onto one of its neighbours, so a
+	simplified index list still points into the original vertex buffer and
+	every LOD of a mesh shares it. Each pass sorts the candidate edges by
+	quadric error and greedily collapses the cheapest ones whose
+	neighbourhoods haven't changed yet this pass, skipping any collapse
+	that would flip a triangle.
+
+	Vertices are welded by position first so uv seams don't tear the
+	surface. Seam vertices are locked in place, and vertices on an open
+	border may only slide along the border.
+
+	Errors are the square root of the area weighted quadric error, which
+	is roughly the distance in mesh units between the simplified surface
+	and the original.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationMeshLoader.h"
+
+const uint32_t kMAX_MESH_LODS = 6;
+const uint32_t kMIN_LOD_TRIANGLES = 64;
+
+struct MeshLodStats {
+	uint32_t lodCount = 0;
+	std::array<uint32_t, kMAX_MESH_LODS> triangles{};
+	std::array<float, kMAX_MESH_LODS> errors{};
+	double seconds = 0.0;
+};
+
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float& resultError);
+void generateMeshLods(Mesh& mesh, MeshLodStats* stats = nullptr);
+void printMeshLodStats(const MeshLodStats& stats);
+
+#endif
\ No newline at end of file
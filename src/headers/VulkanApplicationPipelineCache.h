@@ -0,0 +1,57 @@
+#ifndef VULKAN_APPLICATION_PIPELINE_CACHE
+#define VULKAN_APPLICATION_PIPELINE_CACHE
+
+/*	VkPipelineCache kept on disk between launches, so shaders only have to
+	be compiled by the driver the first time.
+
+	The file is a PipelineCacheFileHeader followed by whatever
+	vkGetPipelineCacheData returned. Our header records the driver version
+	and driver UUID, the blob starts with the driver's own
+	VkPipelineCacheHeaderVersionOne holding the vendor, device and cache
+	UUID. A file where any of those differ from the device we're running on
+	was written by another gpu or driver and is thrown away, the cache
+	starts empty and the next save() replaces it.
+
+	save() writes next to the real file and renames over it, a crash in the
+	middle of a write leaves the previous cache behind instead of half of
+	one.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include <cstring>
+#include <filesystem>
+
+const std::string kPIPELINE_CACHE_PATH = "pipeline.cache";
+const uint32_t kPIPELINE_CACHE_VERSION = 1;
+
+struct PipelineCacheFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t driverVersion;
+	uint8_t driverUUID[VK_UUID_SIZE]; // zero on 1.0 devices, the driver version still has to match
+	uint64_t dataSize;
+	uint64_t dataHash;
+};
+
+class VulkanApplicationPipelineCache {
+	private:
+		VkDevice logicalDevice;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+		std::string path;
+		VkPhysicalDeviceProperties properties;
+		uint8_t driverUUID[VK_UUID_SIZE] = {};
+		bool warm = false; // started from a file this device accepted
+
+		bool validate(const std::vector<char>& file);
+	public:
+		VulkanApplicationPipelineCache(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, const std::string& path = kPIPELINE_CACHE_PATH);
+		~VulkanApplicationPipelineCache();
+		void cleanup();
+		void save();
+		VkPipelineCache getPipelineCache();
+		bool isWarm();
+};
+
+uint64_t hashPipelineCacheData(const char* data, size_t size);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+#ifndef VULKAN_APPLICATION_PIPELINE_REGISTRY
+#define VULKAN_APPLICATION_PIPELINE_REGISTRY
+
+/*	Every graphics pipeline, keyed by the state it was built from.
+
+	A PipelineDescription is everything that differs between pipelines:
+	the shaders, the vertex layout, and the raster, depth and blend state.
+	request() hashes it and hands back the handle of the pipeline that
+	already exists for it, so two draw paths or materials that happen to
+	describe the same state share one pipeline. Everything else, the
+	viewport and scissor, the render pass and the layout, is the same for
+	every pipeline here.
+
+	Toggles inside the fragment shader are a ShaderPermutation, handed to
+	the driver as specialization constants, so each one is a description of
+	its own and compiles into a pipeline with its unused paths stripped.
+
+	A description seen for the first time is compiled in a background job,
+	the pipeline cache, while the frame loop keeps going. Until it's done
+	getPipeline() returns the fallback the caller named, or VK_NULL_HANDLE
+	if there is none or the fallback isn't ready either, and the caller
+	skips the draw. Nothing waits on a compile unless wait() is called,
+	which startup does for the pipelines it can't draw without.
+
+	A compile that throws leaves the pipeline on its fallback for good.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationVertexFormats.h"
+#include "VulkanApplicationShaderPermutation.h"
+#include "VulkanApplicationJobSystem.h"
+#include <unordered_map>
+
+struct PipelineDescription {
+	std::string vertexShaderPath;
+	std::string fragmentShaderPath;
+	VertexFormat vertexFormat = VertexFormat::kFloat;
+	bool instanced = false; // adds the per instance binding
+	VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	bool depthTest = true;
+	bool depthWrite = true;
+	VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+	bool blendEnable = false;
+	VkBlendFactor srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	VkBlendFactor dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	VkBlendOp colorBlendOp = VK_BLEND_OP_ADD;
+	VkBlendFactor srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	VkBlendFactor dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	VkBlendOp alphaBlendOp = VK_BLEND_OP_ADD;
+	ShaderPermutation permutation; // specializes the fragment shader
+
+	bool operator==(const PipelineDescription& other) const;
+};
+
+uint64_t hashPipelineDescription(const PipelineDescription& description);
+
+struct PipelineDescriptionHash {
+	size_t operator()(const PipelineDescription& description) const {
+		return static_cast<size_t>(hashPipelineDescription(description));
+	}
+};
+
+struct PipelineHandle {
+	uint32_t index = UINT32_MAX;
+
+	bool isValid() const {
+		return index != UINT32_MAX;
+	}
+};
+
+enum class PipelineState : uint32_t {
+	kCompiling,
+	kReady,
+	kFailed
+};
+
+struct PipelineRegistryStats {
+	uint32_t requests = 0;
+	uint32_t hits = 0; // asked for a description that was already registered
+	uint32_t compiled = 0;
+	uint32_t failed = 0;
+	double compileSeconds = 0.0; // summed over every job, they overlap with each other and the frame
+};
+
+class VulkanApplicationPipelineRegistry {
+	private:
+		struct RegisteredPipeline {
+			PipelineDescription description;
+			PipelineHandle fallback;
+			VkPipeline pipeline = VK_NULL_HANDLE; // written by the compile job, read once it finished
+			double compileSeconds = 0.0;
+			JobHandle job;
+			PipelineState state = PipelineState::kCompiling;
+		};
+
+		VkDevice logicalDevice;
+		VkPipelineCache pipelineCache;
+		VkRenderPass renderPass;
+		VkPipelineLayout pipelineLayout;
+
+		// entries never move, a running job holds a pointer to its own
+		std::vector<std::unique_ptr<RegisteredPipeline>> pipelines;
+		std::unordered_map<PipelineDescription, uint32_t, PipelineDescriptionHash> pipelinesByDescription;
+		PipelineRegistryStats stats;
+
+		void compile(RegisteredPipeline& registered);
+		void resolve(RegisteredPipeline& registered);
+		VkShaderModule createShaderModule(const std::vector<char>& code);
+	public:
+		VulkanApplicationPipelineRegistry(VkDevice logicalDevice, VkPipelineCache pipelineCache, VkRenderPass renderPass, VkPipelineLayout pipelineLayout);
+		~VulkanApplicationPipelineRegistry();
+		void cleanup();
+		PipelineHandle request(const PipelineDescription& description, PipelineHandle fallback = PipelineHandle{});
+		void wait(PipelineHandle handle);
+		VkPipeline getPipeline(PipelineHandle handle);
+		PipelineState getState(PipelineHandle handle);
+		uint32_t getPipelineCount();
+		PipelineRegistryStats getStats();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef VULKAN_APPLICATION_SCENE_GRAPH
+#define VULKAN_APPLICATION_SCENE_GRAPH
+
+/*	Transform hierarchy stored as flat arrays sorted by depth.
+
+	Every node lives in a slot, parents always sit in a shallower level than
+	their children, so one front to back sweep sees a parent's world matrix
+	before any child needs it. Handles stay valid while nodes are added, the
+	slots get resorted (stable, by depth) the next time the graph propagates.
+
+	setLocalTransform() only marks a node dirty. Propagation starts at the
+	shallowest level holding a dirty node, skips any level where nothing is
+	dirty and nothing above changed, and only multiplies the nodes that are
+	dirty or whose parent changed this pass. A level is independent work, so
+	big ones are split into parallelFor chunks on the job system.
+
+	Nodes that stand for a drawable object write their world matrix straight
+	to base + objectIndex * stride of each output, which can be a persistently
+	mapped instance buffer, so nothing gets copied afterwards. Outputs carry a
+	slot (one per frame in flight plus any cpu side copies), and a node
+	remembers which slots already hold its current world. A matrix that
+	didn't change still goes to a slot that hasn't seen it, so static objects
+	end up in every frame's buffer without being recomputed. Anything else
+	that writes an output's memory has to invalidateOutput() it.
+
+	World matrices are also kept on the cpu since children read them back,
+	mapped memory is often write combined and slow to read.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationJobSystem.h"
+
+const uint32_t kSCENE_GRAPH_NONE = std::numeric_limits<uint32_t>::max();
+const uint32_t kSCENE_GRAPH_MAX_OUTPUTS = 8; // output slots are bits in a byte per node
+const uint32_t kSCENE_GRAPH_NODES_PER_JOB = 4096; // chunk size when a level is split, smaller levels stay on the calling thread
+const uint32_t kSCENE_GRAPH_BENCHMARK_OBJECTS = 100000;
+
+struct SceneGraphOutput {
+	void* base;
+	size_t stride;
+	uint32_t slot; // below kSCENE_GRAPH_MAX_OUTPUTS
+};
+
+struct SceneGraphStats {
+	uint32_t levelsVisited = 0;
+	uint32_t nodesVisited = 0;
+	uint32_t nodesUpdated = 0; // world matrices recomputed
+	uint32_t matricesWritten = 0; // across every output
+	uint32_t chunksUsed = 1; // most chunks any level was split into
+};
+
+class VulkanApplicationSceneGraph {
+	private:
+		// by slot, sorted by depth once propagate() has run
+		std::vector<uint32_t> parents; // parent slot, kSCENE_GRAPH_NONE for roots
+		std::vector<glm::mat4> locals;
+		std::vector<glm::mat4> worlds;
+		std::vector<uint32_t> objectIndices; // kSCENE_GRAPH_NONE for nodes that only group others
+		std::vector<uint32_t> depths;
+		std::vector<uint8_t> dirty;
+		std::vector<uint8_t> currentOutputs; // bit per output slot that holds the node's current world
+		std::vector<uint32_t> changedPass; // pass the world last changed in
+		std::vector<uint32_t> slotHandles;
+
+		std::vector<uint32_t> handleSlots;
+		std::vector<uint32_t> levelStarts; // first slot of each depth, plus one past the end
+		std::vector<uint32_t> levelDirtyCounts;
+		bool sorted = true;
+		uint32_t pass = 0;
+		uint8_t staleOutputs = 0; // output slots some object hasn't been written to
+		VulkanApplicationJobSystem* jobSystem; // null propagates on the calling thread only
+		SceneGraphStats stats;
+
+		void sortByDepth();
+		uint32_t propagateRange(uint32_t first, uint32_t last, const std::vector<SceneGraphOutput>& outputs, uint8_t outputMask, SceneGraphStats& rangeStats);
+	public:
+		VulkanApplicationSceneGraph(VulkanApplicationJobSystem* jobSystem = nullptr);
+		~VulkanApplicationSceneGraph();
+		uint32_t createNode(uint32_t parent, const glm::mat4& local, uint32_t objectIndex = kSCENE_GRAPH_NONE);
+		void setLocalTransform(uint32_t node, const glm::mat4& local);
+		void propagate(const std::vector<SceneGraphOutput>& outputs);
+		void invalidateOutput(uint32_t slot);
+		glm::mat4 getWorldTransform(uint32_t node);
+		uint32_t getNodeCount();
+		uint32_t getLevelCount();
+		SceneGraphStats getStats();
+};
+
+void runSceneGraphBenchmark(uint32_t objectCount);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef VULKAN_APPLICATION_SHADER_PERMUTATION
+#define VULKAN_APPLICATION_SHADER_PERMUTATION
+
+/*	Feature toggles and loop counts baked into the fragment shaders as
+	specialization constants.
+
+	A ShaderPermutation is plain data with one member per constant_id. The
+	driver compiles every combination as its own program, so a branch on a
+	toggle folds away and a loop over a constant count gets unrolled
+	instead of being tested for every fragment. The permutation is part of
+	the PipelineDescription, so materials with the same toggles share one
+	pipeline.
+
+	kSHADER_PERMUTATION_ENTRIES is the map VkSpecializationInfo points at.
+	It's built from the member types and offsets at compile time, and a
+	static_assert checks it covers the whole struct, so a member added
+	without its entry doesn't build. Ids and defaults must match the
+	constant_id declarations in frag.frag and frag_bindless.frag, the
+	defaults being what the shaders did before they had any.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include <cstddef>
+#include <type_traits>
+
+const uint32_t kMAX_TEXTURE_TAPS = 4; // the shaders have this many offsets
+
+struct ShaderPermutation {
+	VkBool32 textured = VK_TRUE;	// samples the material's texture, off leaves the vertex color
+	VkBool32 vertexColor = VK_TRUE;	// multiplies in the interpolated vertex color
+	VkBool32 alphaTest = VK_FALSE;	// discards fragments whose texture alpha is under alphaCutoff
+	float alphaCutoff = 0.5f;
+	uint32_t textureTaps = 1;		// samples averaged across the pixel's footprint, 1 is a plain fetch
+
+	bool operator==(const ShaderPermutation& other) const;
+};
+
+// only 32 bit scalars, glsl bools are 32 bits wide as specialization constants
+template <typename T>
+constexpr VkSpecializationMapEntry makeSpecializationEntry(uint32_t constantID, size_t offset) {
+	static_assert(std::is_same<T, VkBool32>::value || std::is_same<T, int32_t>::value || std::is_same<T, float>::value,
+		"Specialization constants have to be VkBool32, int32_t, uint32_t or float");
+	return VkSpecializationMapEntry{ constantID, static_cast<uint32_t>(offset), sizeof(T) };
+}
+
+constexpr std::array<VkSpecializationMapEntry, 5> kSHADER_PERMUTATION_ENTRIES = { {
+	makeSpecializationEntry<decltype(ShaderPermutation::textured)>(0, offsetof(ShaderPermutation, textured)),
+	makeSpecializationEntry<decltype(ShaderPermutation::vertexColor)>(1, offsetof(ShaderPermutation, vertexColor)),
+	makeSpecializationEntry<decltype(ShaderPermutation::alphaTest)>(2, offsetof(ShaderPermutation, alphaTest)),
+	makeSpecializationEntry<decltype(ShaderPermutation::alphaCutoff)>(3, offsetof(ShaderPermutation, alphaCutoff)),
+	makeSpecializationEntry<decltype(ShaderPermutation::textureTaps)>(4, offsetof(ShaderPermutation, textureTaps))
+} };
+
+template <size_t Count>
+constexpr size_t getSpecializationDataSize(const std::array<VkSpecializationMapEntry, Count>& entries) {
+	size_t size = 0;
+	for (size_t i = 0; i < Count; i++) {
+		size += entries[i].size;
+	}
+	return size;
+}
+
+static_assert(std::is_standard_layout<ShaderPermutation>::value, "ShaderPermutation is handed to the driver as bytes");
+static_assert(getSpecializationDataSize(kSHADER_PERMUTATION_ENTRIES) == sizeof(ShaderPermutation), "Every ShaderPermutation member needs an entry");
+
+std::vector<ShaderPermutation> getShaderPermutationPresets();
+std::string getShaderPermutationName(const ShaderPermutation& permutation);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef VULKAN_APPLICATION_STAGING_RING
+#define VULKAN_APPLICATION_STAGING_RING
+
+/*	One persistently mapped, host visible buffer that every upload stages through.
+
+	reserve() hands out a region of the ring that can be written straight away,
+	commit() closes the current batch of reservations and returns the fence
+	that must be passed to the vkQueueSubmit that reads them. Space is given
+	back once that fence signals. Positions are monotonic byte counters, the
+	physical offset is position % capacity.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationMemoryAllocator.h"
+#include <deque>
+
+struct StagingRegion {
+	VkBuffer buffer;
+	VkDeviceSize offset;
+	VkDeviceSize size;
+	void* mapped;
+};
+
+struct StagingBatch {
+	uint64_t id;
+	VkFence fence;
+};
+
+struct StagingRingStats {
+	uint64_t bytesStaged = 0;
+	uint64_t reservations = 0;
+	uint64_t batchesCommitted = 0;
+	uint64_t stalls = 0;				// reserve() had to block on a fence to find space
+	uint64_t oversizedUploads = 0;		// requests larger than the ring, staged through a temporary buffer
+	VkDeviceSize peakBytesInFlight = 0;
+};
+
+class VulkanApplicationStagingRing {
+	private:
+		struct PendingBatch {
+			uint64_t id;
+			VkFence fence;
+			uint64_t end;
+		};
+
+		struct OversizedBuffer {
+			uint64_t batchId;
+			VkBuffer buffer;
+			MemoryAllocation allocation;
+		};
+
+		VkDevice logicalDevice;
+		VulkanApplicationMemoryAllocator* allocator;
+		VkBuffer ringBuffer;
+		MemoryAllocation ringAllocation;
+		VkDeviceSize capacity;
+		uint64_t head = 0; // next free byte
+		uint64_t tail = 0; // oldest byte still read by the gpu
+		uint64_t committedHead = 0; // end of the last committed batch, bytes past it belong to the open batch
+		uint64_t nextBatchId = 1;
+		uint64_t completedBatchId = 0;
+		std::deque<PendingBatch> pendingBatches;
+		std::vector<VkFence> freeFences;
+		std::vector<OversizedBuffer> oversizedBuffers;
+		StagingRingStats stats;
+
+		uint64_t findStart(VkDeviceSize size, VkDeviceSize alignment);
+		StagingRegion reserveOversized(VkDeviceSize size);
+		void waitForOldestBatch();
+	public:
+		VulkanApplicationStagingRing(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkDeviceSize capacity);
+		~VulkanApplicationStagingRing();
+		void cleanup();
+		StagingRegion reserve(VkDeviceSize size, VkDeviceSize alignment);
+		bool canReserve(VkDeviceSize size, VkDeviceSize alignment);
+		StagingBatch commit();
+		void retire();
+		bool isBatchComplete(uint64_t batchId);
+		void waitForBatch(uint64_t batchId);
+		VkDeviceSize getCapacity();
+		VkBuffer getBuffer();
+		StagingRingStats getStats();
+		void printStats();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+#ifndef VULKAN_APPLICATION_STREAMING_TEXTURE
+#define VULKAN_APPLICATION_STREAMING_TEXTURE
+
+/*	A texture that loads in the background and sharpens over several frames.
+
+	Decoding and the mip chain are a background job, only worker threads
+	pick it up and nothing waits on it. Once the chain is ready update()
+	uploads every level up to kSTREAMING_FIRST_MIP_SIZE pixels in one go, so
+	something close to right shows up after a few frames, then adds one
+	bigger level per upload until the top level is in or the next one would
+	go over the memory budget. Lowering the budget evicts from the top down
+	the same way.
+
+	Vulkan can't grow or shrink an image's mip chain, so every step creates
+	a new image holding levels [top, last] and uploads all of them again
+	from the decoded chain, which stays in memory for as long as the texture
+	lives. The levels below the new top add up to a third of it at most. The
+	new image only replaces the old one once its upload finished, the old
+	one is destroyed kMAX_FRAMES_IN_FLIGHT frames after that, when no frame
+	in flight can still sample it.
+
+	When the format can be blitted with linear filtering only the top level
+	of a residency is uploaded and the gpu blits the rest of the chain,
+	otherwise every level comes from the cpu chain. The cpu chain is built
+	either way since it holds the top level of every residency, it's a 2x2
+	box filter done 4 texels at a time with SSE2 where available. sRGB
+	levels are averaged in linear space like the blit does, through lookup
+	tables and without the simd path, otherwise every level gets darker
+	than the one above it.
+
+	KTX2 and DDS files bring their own chain, block compressed ones are
+	uploaded block for block and never blitted. A file with only its top
+	level gets the cpu chain like a jpeg does.
+
+	A file that's missing or doesn't decode only gets logged, the texture
+	never becomes resident and whoever samples it keeps the placeholder.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationMemoryAllocator.h"
+#include "VulkanApplicationUploadContext.h"
+#include "VulkanApplicationJobSystem.h"
+#include "VulkanApplicationTextureContainer.h"
+#include <stb_image.h>
+#include <chrono>
+
+const uint32_t kSTREAMING_FIRST_MIP_SIZE = 64; // largest side of the biggest level in the first upload
+const VkDeviceSize kTEXTURE_STREAMING_BUDGET = 64 * 1024 * 1024;
+const VkDeviceSize kMIN_TEXTURE_STREAMING_BUDGET = 64 * 1024;
+const uint32_t kMIPMAP_BENCHMARK_SIZE = 2048;
+
+struct TextureResidency {
+	VkImage image = VK_NULL_HANDLE;
+	MemoryAllocation allocation{};
+	VkImageView view = VK_NULL_HANDLE;
+	uint32_t topMip = 0;
+	VkDeviceSize bytes = 0;
+	UploadTicket ticket;
+	uint64_t retireFrame = 0; // frame it stopped being bound, destroyed kMAX_FRAMES_IN_FLIGHT frames later
+};
+
+struct StreamingTextureStats {
+	double decodeSeconds = 0.0;
+	double firstResidentSeconds = 0.0; // from construction until something could be sampled
+	double fullResidentSeconds = 0.0; // until the top level was in, 0 while it isn't
+	uint32_t uploads = 0;
+	uint32_t evictions = 0;
+};
+
+class VulkanApplicationStreamingTexture {
+	private:
+		VkDevice logicalDevice;
+		VulkanApplicationMemoryAllocator* allocator;
+		std::string path;
+		VkFormat format; // set by the decode job, the file decides it for KTX2 and DDS
+		VkDeviceSize budget;
+		bool gpuMipmaps; // blit the levels below the top one instead of uploading them
+		bool blockCompression; // the device samples BC formats, otherwise they're decoded to rgba8
+		std::chrono::high_resolution_clock::time_point startTime;
+
+		JobHandle decodeJob;
+		bool decoded = false;
+		bool failed = false; // the decode threw, nothing is ever uploaded
+		std::vector<TextureMip> mips; // written by the decode job, only read once it finished
+		double decodeSeconds = 0.0; // same, copied into stats once the job is done
+
+		TextureResidency resident; // what gets sampled, no image until the first upload lands
+		TextureResidency pending; // uploading, swapped in when its ticket completes
+		std::vector<TextureResidency> retired;
+		StreamingTextureStats stats;
+
+		void decode();
+		uint32_t getTargetTopMip();
+		VkDeviceSize getChainBytes(uint32_t topMip);
+		void upload(uint32_t topMip, VulkanApplicationUploadContext& uploadContext);
+		void destroyResidency(TextureResidency& residency);
+	public:
+		VulkanApplicationStreamingTexture(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, const std::string& path,
+			bool gpuMipmaps, bool blockCompression, VkDeviceSize budget = kTEXTURE_STREAMING_BUDGET);
+		~VulkanApplicationStreamingTexture();
+		void cleanup();
+		bool update(VulkanApplicationUploadContext& uploadContext, uint64_t frameNumber);
+		VkImageView getImageView();
+		bool isResident();
+		bool isFailed();
+		bool isIdle(VulkanApplicationUploadContext& uploadContext);
+		uint32_t getResidentMip();
+		uint32_t getMipCount();
+		VkDeviceSize getResidentBytes();
+		VkDeviceSize getBudget();
+		void setBudget(VkDeviceSize budget);
+		StreamingTextureStats getStats();
+};
+
+void downsampleMip(const TextureMip& source, TextureMip& mip, bool srgb, bool useSimd = true);
+std::vector<TextureMip> generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, bool useSimd = true);
+const char* getMipmapSimdName();
+void runMipmapBenchmark(uint32_t size);
+
+#endif
\ No newline at end of file
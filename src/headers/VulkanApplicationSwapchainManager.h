@@ -2,6 +2,8 @@
 #define VULKAN_APPLICATION_SWAPCHAIN_MANAGER
 
 #include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationMemoryAllocator.h"
+#include "VulkanApplicationUploadContext.h"
 
 class VulkanApplicationSwapchainManager {
 	private:
@@ -12,26 +14,26 @@ class VulkanApplicationSwapchainManager {
 		std::vector<VkImageView> swapchainImageViews;
 		std::vector<VkFramebuffer> swapchainFramebuffers;
 		VkImage depthImage;
-		VkDeviceMemory depthImageMemory;
+		MemoryAllocation depthImageAllocation;
 		VkImageView depthImageView;
 	public:
 		VulkanApplicationSwapchainManager(VkPhysicalDevice physicalDevice, VkDevice logicalDevice, VkSurfaceKHR surface, GLFWwindow* window);
 		~VulkanApplicationSwapchainManager();
-		void cleanup(VkDevice logicalDevice);
+		void cleanup(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator);
 		VkSwapchainKHR getSwapchain();
 		std::vector<VkImage> getSwapchainImages();
 		VkFormat getSwapchainImageFormat();
 		VkExtent2D getSwapchainExtent();
 		std::vector<VkImageView> getSwapchainImageViews();
 		std::vector<VkFramebuffer> getSwapchainFramebuffers();
-		void createDepthResources(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkQueue graphicsQueue, VkCommandPool commandPool);
+		void createDepthResources(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext);
 
 		void createImageViews(VkDevice logicalDevice);
 		void createSwapchain(VkPhysicalDevice physicalDevice, VkDevice logicalDevice, VkSurfaceKHR surface, GLFWwindow* window);
 		VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 		VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 		VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window);
-		void recreateSwapchain(VkPhysicalDevice physicalDevice, VkDevice logicalDevice, VkSurfaceKHR surface, GLFWwindow* window, VkRenderPass renderPass, VkQueue graphicsQueue, VkCommandPool commandPool);
+		void recreateSwapchain(VkPhysicalDevice physicalDevice, VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VkSurfaceKHR surface, GLFWwindow* window, VkRenderPass renderPass, VulkanApplicationUploadContext& uploadContext);
 		void createFrameBuffer(VkDevice logicalDevice, VkRenderPass renderPass);
 };
 
@@ -0,0 +1,110 @@
+#ifndef VULKAN_APPLICATION_TEXTURE_CACHE
+#define VULKAN_APPLICATION_TEXTURE_CACHE
+
+/*	Textures by file, shared by everything that asks for the same one.
+
+	A texture is keyed by the canonical path of its file plus how it's
+	sampled, and acquire() hands out a handle that counts as a reference.
+	Asking for a key again returns the same texture whether it's still
+	decoding or long done, so a file is only ever decoded and uploaded
+	once. Two samplings of one file are two textures sharing one image,
+	only the sampler differs.
+
+	Every file is a streaming texture, which decodes in a job, so a scene
+	asking for many files at once decodes them side by side on the workers
+	and nothing waits until update() uploads whatever is ready.
+
+	release() drops a reference. A texture nobody holds any more is
+	destroyed kMAX_FRAMES_IN_FLIGHT frames later, when no frame in flight
+	can still sample it, unless someone acquires it again before that. If
+	its file is still decoding or an upload into it hasn't landed, it waits
+	longer, until neither is true. Samplers are few and live as long as the
+	cache.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationMemoryAllocator.h"
+#include "VulkanApplicationUploadContext.h"
+#include "VulkanApplicationStreamingTexture.h"
+#include <filesystem>
+#include <unordered_map>
+
+struct TextureSampling {
+	VkFilter filter = VK_FILTER_LINEAR;
+	VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	bool anisotropy = true;
+};
+
+struct TextureHandle {
+	uint32_t index = UINT32_MAX;
+
+	bool isValid() const {
+		return index != UINT32_MAX;
+	}
+};
+
+struct TextureCacheStats {
+	uint32_t requests = 0;
+	uint32_t hits = 0; // handed back a texture that already existed
+	uint32_t imageLoads = 0; // files decoded and uploaded
+	uint32_t imageShares = 0; // new samplings of a file that was already loaded
+	uint32_t evictions = 0;
+};
+
+class VulkanApplicationTextureCache {
+	private:
+		struct CachedImage {
+			std::string path;
+			std::unique_ptr<VulkanApplicationStreamingTexture> texture; // null while the slot is free
+			uint32_t references = 0; // textures sampling it
+		};
+
+		struct CachedTexture {
+			std::string key;
+			uint32_t image = 0;
+			VkSampler sampler = VK_NULL_HANDLE;
+			uint32_t references = 0; // handles, the slot is free when the key is empty
+			uint64_t retireFrame = 0; // last release, destroyed kMAX_FRAMES_IN_FLIGHT frames later
+		};
+
+		VkDevice logicalDevice;
+		VulkanApplicationMemoryAllocator* allocator;
+		VkImageView placeholderView; // sampled until a texture's first levels are in
+		float maxAnisotropy;
+		bool gpuMipmaps;
+		bool blockCompression;
+		uint64_t frameNumber = 0; // of the last update, releases are timed with it
+
+		std::vector<CachedImage> images;
+		std::vector<CachedTexture> textures;
+		std::vector<uint32_t> freeImages;
+		std::vector<uint32_t> freeTextures;
+		std::unordered_map<std::string, uint32_t> imagesByPath;
+		std::unordered_map<std::string, uint32_t> texturesByKey;
+		std::unordered_map<std::string, VkSampler> samplers; // by getSamplingKey()
+		std::vector<uint32_t> releasedTextures; // no references left, waiting out the frames in flight
+		TextureCacheStats stats;
+
+		uint32_t acquireImage(const std::string& path, const std::string& canonicalPath);
+		VkSampler acquireSampler(const TextureSampling& sampling);
+		bool canDestroyTexture(uint32_t index, VulkanApplicationUploadContext& uploadContext);
+		void destroyTexture(uint32_t index);
+	public:
+		VulkanApplicationTextureCache(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator,
+			VkImageView placeholderView, bool gpuMipmaps, bool blockCompression);
+		~VulkanApplicationTextureCache();
+		void cleanup();
+		TextureHandle acquire(const std::string& path, const TextureSampling& sampling = TextureSampling{});
+		void release(TextureHandle handle);
+		bool update(VulkanApplicationUploadContext& uploadContext, uint64_t frameNumber);
+		VkImageView getImageView(TextureHandle handle);
+		VkSampler getSampler(TextureHandle handle);
+		VulkanApplicationStreamingTexture& getStreamingTexture(TextureHandle handle);
+		uint32_t getImageCount();
+		TextureCacheStats getStats();
+};
+
+std::string getCanonicalTexturePath(const std::string& path);
+std::string getSamplingKey(const TextureSampling& sampling);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef VULKAN_APPLICATION_TEXTURE_CONTAINER
+#define VULKAN_APPLICATION_TEXTURE_CONTAINER
+
+/*	Reads KTX2 and DDS files and writes KTX2.
+
+	Both keep every mip level as it goes to the gpu, so block compressed
+	levels are uploaded as they are. Only what the renderer can use is
+	accepted: 2d, one layer, one face, BC1/3/5/7 or rgba8, and for KTX2 no
+	supercompression. DDS files without the DX10 header only say DXT1, DXT5
+	or ATI2 and are treated as linear, DX10 ones carry the sRGB flag.
+
+	--convert-texture turns a jpeg/png into a KTX2 with a full chain, the
+	levels are box filtered before they're compressed.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationBlockCompression.h"
+
+const std::string kKTX2_EXTENSION = ".ktx2";
+const std::string kDDS_EXTENSION = ".dds";
+
+struct TextureContainer {
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	std::vector<TextureMip> mips; // largest first
+};
+
+bool isTextureContainerPath(const std::string& path);
+TextureContainer loadTextureContainer(const std::string& path);
+void writeKtx2(const std::string& path, const TextureContainer& container);
+void runTextureConverter(const std::string& inputPath, const std::string& outputPath, const std::string& formatName);
+
+#endif
\ No newline at end of file
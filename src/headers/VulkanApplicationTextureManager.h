@@ -2,23 +2,40 @@
 #define VULKAN_APPLICATION_TEXTURE_MANAGER
 
 #include "VulkanApplicationHelpers.h"
-#include <stb_image.h>
+#include "VulkanApplicationMemoryAllocator.h"
+#include "VulkanApplicationUploadContext.h"
+#include "VulkanApplicationTextureCache.h"
+
+const std::string kTEXTURE_PATH = "textures/Statue_Image.ktx2";
+const std::string kTEXTURE_SOURCE_PATH = "textures/Statue_Image.jpg";
+
+// how each material samples the texture, the way a scene would list them. There's only the one file so
+// they all share it, the first and last are the same texture and the cache loads the file once for all four
+const std::array<TextureSampling, 4> kMATERIAL_SAMPLINGS = {{
+	{ VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT, true },
+	{ VK_FILTER_NEAREST, VK_SAMPLER_ADDRESS_MODE_REPEAT, false },
+	{ VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT, true },
+	{ VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT, true }
+}};
 
 class VulkanApplicationTextureManager {
 	private:
-		VkImage textureImage;
-		VkDeviceMemory textureImageMemory;
-		VkImageView textureImageView;
-		VkSampler textureSampler;
+		// sampled until a streamed texture has its first levels in
+		VkImage placeholderImage;
+		MemoryAllocation placeholderImageAllocation;
+		VkImageView placeholderImageView;
+		std::unique_ptr<VulkanApplicationTextureCache> textureCache;
+		std::vector<TextureHandle> materialTextures; // one per kMATERIAL_SAMPLINGS entry
 	public:
-		VulkanApplicationTextureManager(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
+		VulkanApplicationTextureManager(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext, bool blockCompression);
 		~VulkanApplicationTextureManager();
-		void cleanup(VkDevice logicalDevice);
-		void createTextureImage(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, VkQueue graphicsQueue);
-		void createTextureImageView(VkDevice logicalDevice);
-		void createTextureSampler(VkDevice logicalDevice, VkPhysicalDevice physicalDevice);
-		VkImage getTextureImage();
-		VkDeviceMemory getTextureImageMemory();
+		void cleanup(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator);
+		void createPlaceholderImage(VkDevice logicalDevice, VulkanApplicationMemoryAllocator& allocator, VulkanApplicationUploadContext& uploadContext);
+		bool update(VulkanApplicationUploadContext& uploadContext, uint64_t frameNumber);
+		VulkanApplicationTextureCache& getTextureCache();
+		uint32_t getMaterialCount();
+		TextureHandle getMaterialTexture(uint32_t materialIndex);
+		VulkanApplicationStreamingTexture& getStreamingTexture();
 		VkImageView getTextureImageView();
 		VkSampler getTextureSampler();
 };
@@ -0,0 +1,55 @@
+#ifndef VULKAN_APPLICATION_UNIFORM_ARENA
+#define VULKAN_APPLICATION_UNIFORM_ARENA
+
+/*	Per frame linear allocator for uniform data.
+
+	Every frame in flight owns one large persistently mapped buffer that is
+	bound once as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC. Per draw data is
+	bump allocated out of it at minUniformBufferOffsetAlignment and the
+	returned offset is handed to vkCmdBindDescriptorSets, so any number of
+	objects can share one descriptor set. beginFrame() rewinds the arena,
+	which is only safe once that frame's fence has been waited on.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationMemoryAllocator.h"
+
+struct UniformArenaStats {
+	uint64_t allocations = 0;			// allocations made in the current frame
+	VkDeviceSize bytesUsed = 0;			// bytes used in the current frame, padding included
+	VkDeviceSize peakBytesUsed = 0;		// highest bytesUsed seen in any frame
+};
+
+class VulkanApplicationUniformArena {
+	private:
+		VkDevice logicalDevice;
+		VulkanApplicationMemoryAllocator* allocator;
+		std::vector<VkBuffer> buffers;
+		std::vector<MemoryAllocation> allocations;
+		VkDeviceSize capacity;
+		VkDeviceSize alignment;
+		VkDeviceSize head = 0;
+		uint32_t currentFrame = 0;
+		UniformArenaStats stats;
+	public:
+		VulkanApplicationUniformArena(VkDevice logicalDevice, VkPhysicalDevice physicalDevice, VulkanApplicationMemoryAllocator& allocator, VkDeviceSize capacity);
+		~VulkanApplicationUniformArena();
+		void cleanup();
+		void beginFrame(uint32_t frameIndex);
+		uint32_t allocate(VkDeviceSize size, void** mapped);
+
+		template<typename T>
+		uint32_t push(const T& data) {
+			void* mapped;
+			uint32_t offset = allocate(sizeof(T), &mapped);
+			memcpy(mapped, &data, sizeof(T));
+			return offset;
+		}
+
+		VkBuffer getBuffer(uint32_t frameIndex);
+		VkDeviceSize getAlignment();
+		VkDeviceSize getCapacity();
+		UniformArenaStats getStats();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef VULKAN_APPLICATION_UPLOAD_CONTEXT
+#define VULKAN_APPLICATION_UPLOAD_CONTEXT
+
+/*	Records copies and layout transitions into one command buffer and
+	submits them together, instead of a submit + vkQueueWaitIdle per command.
+
+	submit() returns a ticket that can be polled or waited on, tickets are
+	the staging ring batch ids so the fence that frees the staging memory
+	is the same one that tells the caller the upload landed. Work on the
+	same queue is ordered anyway, so the renderer never has to wait on a
+	ticket before drawing with what it uploaded.
+
+	When the device has a separate transfer family the copies run on that
+	queue and every destination is released to the graphics family. The
+	matching acquire barriers go into a second command buffer on the
+	graphics queue that waits on a semaphore from the transfer submit.
+	Without one both command buffers are the same and the release/acquire
+	pair collapses into a single barrier.
+
+	Mip chains are blitted on the graphics command buffer, transfer queues
+	can't blit. The first level has to be uploaded in transfer src layout.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include "VulkanApplicationStagingRing.h"
+#include <deque>
+
+struct UploadTicket {
+	uint64_t id = 0; // 0 means nothing was submitted, always complete
+};
+
+struct UploadContextStats {
+	uint64_t submits = 0;
+	uint64_t copies = 0;
+	uint64_t transitions = 0;
+	uint64_t ownershipTransfers = 0;
+	uint64_t blits = 0;
+	uint64_t forcedSubmits = 0; // the open batch filled the staging ring and had to be flushed early
+};
+
+class VulkanApplicationUploadContext {
+	private:
+		struct UploadCommands {
+			VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE; // same as transferCommandBuffer without a dedicated transfer queue
+			VkSemaphore transferComplete = VK_NULL_HANDLE;
+			uint64_t batchId = 0;
+			bool hasTransferWork = false;
+		};
+
+		VkDevice logicalDevice;
+		VkQueue graphicsQueue;
+		VkQueue transferQueue;
+		uint32_t graphicsFamily;
+		uint32_t transferFamily;
+		bool dedicatedTransfer;
+		VkCommandPool graphicsCommandPool;
+		VkCommandPool transferCommandPool;
+		VulkanApplicationStagingRing* stagingRing;
+		UploadCommands recording;
+		bool isRecording = false;
+		uint64_t lastSubmittedBatch = 0;
+		std::deque<UploadCommands> inFlightCommands;
+		std::vector<UploadCommands> freeCommands;
+		UploadContextStats stats;
+
+		UploadCommands& getRecordingCommands();
+		void recycleCommands();
+		VkCommandPool createCommandPool(uint32_t queueFamilyIndex);
+		void getLayoutUsage(VkImageLayout layout, VkAccessFlags& accessMask, VkPipelineStageFlags& stageMask);
+	public:
+		VulkanApplicationUploadContext(VkDevice logicalDevice, VkQueue graphicsQueue, uint32_t graphicsFamily,
+			VkQueue transferQueue, uint32_t transferFamily, VulkanApplicationStagingRing& stagingRing);
+		~VulkanApplicationUploadContext();
+		void cleanup();
+		StagingRegion stage(const void* data, VkDeviceSize size, VkDeviceSize alignment);
+		void copyBuffer(const StagingRegion& source, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask);
+		void copyBufferToImage(const StagingRegion& source, VkImage image, uint32_t width, uint32_t height, VkImageLayout finalLayout, uint32_t mipLevel = 0);
+		void generateMipmaps(VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, VkImageLayout finalLayout);
+		void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
+		UploadTicket submit();
+		bool isComplete(UploadTicket ticket);
+		void wait(UploadTicket ticket);
+		bool hasDedicatedTransferQueue();
+		UploadContextStats getStats();
+		void printStats();
+};
+
+#endif
\ No newline at end of file
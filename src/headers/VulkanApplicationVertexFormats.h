@@ -0,0 +1,234 @@
+#ifndef VULKAN_APPLICATION_VERTEX_FORMATS
+#define VULKAN_APPLICATION_VERTEX_FORMATS
+
+/*	GPU side vertex layouts built from attribute types.
+
+	Meshes are always processed as full float Vertex on the cpu and only
+	encoded into one of these layouts on the way into a vertex buffer or
+	the mesh cache. A layout is a list of attributes, and its stride,
+	offsets and VkVertexInputAttributeDescriptions are all worked out at
+	compile time from that list. Attributes keep the shader locations of
+	Vertex and the formats are all ones the vertex shaders can read without
+	changes, so every layout works with the same shaders.
+
+	PositionUnorm16 stores positions relative to the mesh bounds. The
+	matching dequantization is folded into the model matrix, see
+	getPositionDequantization().
+
+	selectVertexFormat() picks the smallest layout whose round trip error
+	stays within the kVERTEX_*_TOLERANCE constants for every vertex.
+*/
+
+#include "VulkanApplicationHelpers.h"
+#include <glm/gtc/packing.hpp>
+
+const float kVERTEX_POSITION_TOLERANCE = 0.001f;			// world units
+const float kVERTEX_COLOR_TOLERANCE = 1.0f / 255.0f;
+const float kVERTEX_TEXCOORD_TOLERANCE = 1.0f / 2048.0f;	// about half a texel on a 1024 texture
+
+// maps mesh space positions into 0..1 for bounds relative formats
+struct VertexQuantization {
+	glm::vec3 positionOffset = glm::vec3(0.0f);
+	glm::vec3 positionScale = glm::vec3(1.0f);
+};
+
+enum class VertexFormat : uint32_t {
+	kFloat,					// 32 bytes, exactly Vertex
+	kCompact,				// 20 bytes, unorm8 color and half uv
+	kQuantizedPosition,		// 20 bytes, unorm16 position and unorm8 color, for uvs that don't fit in a half
+	kQuantized,				// 16 bytes, unorm16 position, unorm8 color and half uv
+	kCount
+};
+
+inline float getMaxError(const glm::vec3& a, const glm::vec3& b) {
+	glm::vec3 difference = glm::abs(a - b);
+	return std::max(difference.x, std::max(difference.y, difference.z));
+}
+
+inline float getMaxError(const glm::vec2& a, const glm::vec2& b) {
+	return std::max(std::fabs(a.x - b.x), std::fabs(a.y - b.y));
+}
+
+inline uint16_t quantizeUnorm16(float value) {
+	return static_cast<uint16_t>(std::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+inline uint8_t quantizeUnorm8(float value) {
+	return static_cast<uint8_t>(std::round(glm::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+/*	Every attribute has its shader location and format, encodes itself from
+	a Vertex and reports its round trip error as a fraction of the
+	tolerance, so anything above 1 is out.
+*/
+
+struct PositionFloat3 {
+	glm::vec3 value;
+
+	static constexpr uint32_t kLOCATION = 0;
+	static constexpr VkFormat kFORMAT = VK_FORMAT_R32G32B32_SFLOAT;
+	static constexpr bool kBOUNDS_RELATIVE = false;
+
+	static PositionFloat3 encode(const Vertex& vertex, const VertexQuantization& quantization) { return { vertex.pos }; }
+	static float getError(const Vertex& vertex, const VertexQuantization& quantization) { return 0.0f; }
+};
+
+struct PositionUnorm16 {
+	uint16_t value[4]; // w is padding, three component 16 bit formats are rarely supported for vertex input
+
+	static constexpr uint32_t kLOCATION = 0;
+	static constexpr VkFormat kFORMAT = VK_FORMAT_R16G16B16A16_UNORM;
+	static constexpr bool kBOUNDS_RELATIVE = true;
+
+	static PositionUnorm16 encode(const Vertex& vertex, const VertexQuantization& quantization) {
+		glm::vec3 normalized = (vertex.pos - quantization.positionOffset) / quantization.positionScale;
+		return { { quantizeUnorm16(normalized.x), quantizeUnorm16(normalized.y), quantizeUnorm16(normalized.z), 0 } };
+	}
+
+	static float getError(const Vertex& vertex, const VertexQuantization& quantization) {
+		PositionUnorm16 encoded = encode(vertex, quantization);
+		glm::vec3 decoded = glm::vec3(encoded.value[0], encoded.value[1], encoded.value[2]) / 65535.0f * quantization.positionScale + quantization.positionOffset;
+		return getMaxError(vertex.pos, decoded) / kVERTEX_POSITION_TOLERANCE;
+	}
+};
+
+struct ColorFloat3 {
+	glm::vec3 value;
+
+	static constexpr uint32_t kLOCATION = 1;
+	static constexpr VkFormat kFORMAT = VK_FORMAT_R32G32B32_SFLOAT;
+	static constexpr bool kBOUNDS_RELATIVE = false;
+
+	static ColorFloat3 encode(const Vertex& vertex, const VertexQuantization& quantization) { return { vertex.color }; }
+	static float getError(const Vertex& vertex, const VertexQuantization& quantization) { return 0.0f; }
+};
+
+struct ColorUnorm8 {
+	uint8_t value[4]; // alpha is always 255, the shaders only read rgb
+
+	static constexpr uint32_t kLOCATION = 1;
+	static constexpr VkFormat kFORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+	static constexpr bool kBOUNDS_RELATIVE = false;
+
+	static ColorUnorm8 encode(const Vertex& vertex, const VertexQuantization& quantization) {
+		return { { quantizeUnorm8(vertex.color.x), quantizeUnorm8(vertex.color.y), quantizeUnorm8(vertex.color.z), 255 } };
+	}
+
+	static float getError(const Vertex& vertex, const VertexQuantization& quantization) {
+		ColorUnorm8 encoded = encode(vertex, quantization);
+		glm::vec3 decoded = glm::vec3(encoded.value[0], encoded.value[1], encoded.value[2]) / 255.0f;
+		return getMaxError(vertex.color, decoded) / kVERTEX_COLOR_TOLERANCE;
+	}
+};
+
+struct TexCoordFloat2 {
+	glm::vec2 value;
+
+	static constexpr uint32_t kLOCATION = 2;
+	static constexpr VkFormat kFORMAT = VK_FORMAT_R32G32_SFLOAT;
+	static constexpr bool kBOUNDS_RELATIVE = false;
+
+	static TexCoordFloat2 encode(const Vertex& vertex, const VertexQuantization& quantization) { return { vertex.texCoord }; }
+	static float getError(const Vertex& vertex, const VertexQuantization& quantization) { return 0.0f; }
+};
+
+struct TexCoordHalf2 {
+	uint16_t value[2];
+
+	static constexpr uint32_t kLOCATION = 2;
+	static constexpr VkFormat kFORMAT = VK_FORMAT_R16G16_SFLOAT;
+	static constexpr bool kBOUNDS_RELATIVE = false;
+
+	static TexCoordHalf2 encode(const Vertex& vertex, const VertexQuantization& quantization) {
+		return { { glm::packHalf1x16(vertex.texCoord.x), glm::packHalf1x16(vertex.texCoord.y) } };
+	}
+
+	static float getError(const Vertex& vertex, const VertexQuantization& quantization) {
+		TexCoordHalf2 encoded = encode(vertex, quantization);
+		glm::vec2 decoded(glm::unpackHalf1x16(encoded.value[0]), glm::unpackHalf1x16(encoded.value[1]));
+		return getMaxError(vertex.texCoord, decoded) / kVERTEX_TEXCOORD_TOLERANCE;
+	}
+};
+
+template<typename... Attributes>
+struct VertexLayout {
+	static constexpr uint32_t kATTRIBUTE_COUNT = sizeof...(Attributes);
+	static constexpr uint32_t kSTRIDE = (static_cast<uint32_t>(sizeof(Attributes)) + ...);
+	static constexpr bool kBOUNDS_RELATIVE = (Attributes::kBOUNDS_RELATIVE || ...);
+
+	static_assert(((sizeof(Attributes) % 4 == 0) && ...), "Attribute offsets must stay 4 byte aligned");
+
+	static constexpr VkVertexInputBindingDescription getBindingDescription() {
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = kSTRIDE;
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescription;
+	}
+
+	// offsets are the running sum of the attribute sizes, in declaration order
+	static constexpr std::array<VkVertexInputAttributeDescription, kATTRIBUTE_COUNT> getAttributeDescriptions() {
+		std::array<VkVertexInputAttributeDescription, kATTRIBUTE_COUNT> attributeDescriptions{};
+		uint32_t offset = 0;
+		size_t i = 0;
+
+		((attributeDescriptions[i] = { Attributes::kLOCATION, 0, Attributes::kFORMAT, offset },
+			offset += static_cast<uint32_t>(sizeof(Attributes)), i++), ...);
+
+		return attributeDescriptions;
+	}
+
+	static void encode(const Vertex& vertex, const VertexQuantization& quantization, char* output) {
+		((encodeAttribute<Attributes>(vertex, quantization, output), output += sizeof(Attributes)), ...);
+	}
+
+	static float getError(const Vertex& vertex, const VertexQuantization& quantization) {
+		return std::max({ 0.0f, Attributes::getError(vertex, quantization)... });
+	}
+
+	private:
+		template<typename Attribute>
+		static void encodeAttribute(const Vertex& vertex, const VertexQuantization& quantization, char* output) {
+			Attribute attribute = Attribute::encode(vertex, quantization);
+			memcpy(output, &attribute, sizeof(Attribute));
+		}
+};
+
+using VertexLayoutFloat = VertexLayout<PositionFloat3, ColorFloat3, TexCoordFloat2>;
+using VertexLayoutCompact = VertexLayout<PositionFloat3, ColorUnorm8, TexCoordHalf2>;
+using VertexLayoutQuantizedPosition = VertexLayout<PositionUnorm16, ColorUnorm8, TexCoordFloat2>;
+using VertexLayoutQuantized = VertexLayout<PositionUnorm16, ColorUnorm8, TexCoordHalf2>;
+
+static_assert(VertexLayoutFloat::kSTRIDE == sizeof(Vertex), "The float layout must match Vertex byte for byte");
+
+// the attribute array sized for the largest layout, only the first attributeCount entries are used
+struct VertexInputDescription {
+	VkVertexInputBindingDescription binding;
+	std::array<VkVertexInputAttributeDescription, 3> attributes;
+	uint32_t attributeCount;
+};
+
+/*	Per instance data for the instanced draw path, read from a second
+	binding that steps once per instance. The model matrix takes one
+	location per column, so instance attributes start after the vertex
+	ones and every vertex format can be paired with it.
+*/
+
+const uint32_t kINSTANCE_BINDING = 1;
+const uint32_t kINSTANCE_FIRST_LOCATION = 3;
+
+struct InstanceInputDescription {
+	VkVertexInputBindingDescription binding;
+	std::array<VkVertexInputAttributeDescription, 5> attributes; // four model columns then the tint
+};
+
+VertexQuantization getVertexQuantization(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+VertexInputDescription getVertexInputDescription(VertexFormat format);
+uint32_t getVertexStride(VertexFormat format);
+const char* getVertexFormatName(VertexFormat format);
+glm::mat4 getPositionDequantization(VertexFormat format, const VertexQuantization& quantization);
+void encodeVertices(const std::vector<Vertex>& vertices, VertexFormat format, const VertexQuantization& quantization, void* output);
+VertexFormat selectVertexFormat(const std::vector<Vertex>& vertices, const VertexQuantization& quantization);
+InstanceInputDescription getInstanceInputDescription();
+
+#endif
\ No newline at end of file
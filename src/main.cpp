@@ -1,7 +1,46 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "headers/VulkanApplication.h"
 
-int main() {
+int main(int argc, char** argv) {
+	// --benchmark <name> [args] runs a standalone benchmark instead of the renderer
+	if (argc >= 3 && std::string(argv[1]) == "--benchmark") {
+		std::string benchmark = argv[2];
+
+		try {
+			if (benchmark == "mesh-cache") {
+				runMeshCacheBenchmark(argc >= 4 ? argv[3] : kMODEL_PATH);
+			} else if (benchmark == "frustum-culling") {
+				runFrustumCullingBenchmark(argc >= 4 ? static_cast<uint32_t>(std::stoul(argv[3])) : kCULLING_BENCHMARK_OBJECTS);
+			} else if (benchmark == "scene-graph") {
+				runSceneGraphBenchmark(argc >= 4 ? static_cast<uint32_t>(std::stoul(argv[3])) : kSCENE_GRAPH_BENCHMARK_OBJECTS);
+			} else if (benchmark == "job-system") {
+				runJobSystemBenchmark(argc >= 4 ? static_cast<uint32_t>(std::stoul(argv[3])) : kJOB_BENCHMARK_JOBS);
+			} else if (benchmark == "mipmaps") {
+				runMipmapBenchmark(argc >= 4 ? static_cast<uint32_t>(std::stoul(argv[3])) : kMIPMAP_BENCHMARK_SIZE);
+			} else {
+				cerr << "Unknown benchmark " << benchmark << endl;
+				return EXIT_FAILURE;
+			}
+		} catch (const std::exception& e) {
+			cerr << e.what() << endl;
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	// --convert-texture <input> <output.ktx2> [bc1|bc3|bc5|bc7|rgba8] writes a texture the renderer streams as is
+	if (argc >= 4 && std::string(argv[1]) == "--convert-texture") {
+		try {
+			runTextureConverter(argv[2], argv[3], argc >= 5 ? argv[4] : "bc7");
+		} catch (const std::exception& e) {
+			cerr << e.what() << endl;
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
 	HelloTriangleApplication app;
 
 	try {
@@ -1,2 +1,6 @@
 C:\VulkanSDK\1.4.304.1\Bin\glslc.exe vert.vert -o vert.spv
-C:\VulkanSDK\1.4.304.1\Bin\glslc.exe frag.frag -o frag.spv
\ No newline at end of file
+C:\VulkanSDK\1.4.304.1\Bin\glslc.exe vert_push.vert -o vert_push.spv
+C:\VulkanSDK\1.4.304.1\Bin\glslc.exe frag.frag -o frag.spv
+C:\VulkanSDK\1.4.304.1\Bin\glslc.exe frag_bindless.frag -o frag_bindless.spv
+C:\VulkanSDK\1.4.304.1\Bin\glslc.exe vert_instanced.vert -o vert_instanced.spv
+C:\VulkanSDK\1.4.304.1\Bin\glslc.exe cull.comp -o cull.spv
\ No newline at end of file
@@ -6,6 +6,42 @@ layout(binding = 1) uniform sampler2D texSampler;
 
 layout(location = 0) out vec4 outColor;
 
+// must match ShaderPermutation, every combination is compiled as its own program
+// so the toggles below fold away and the tap loop unrolls
+layout(constant_id = 0) const bool kTEXTURED = true;
+layout(constant_id = 1) const bool kVERTEX_COLOR = true;
+layout(constant_id = 2) const bool kALPHA_TEST = false;
+layout(constant_id = 3) const float kALPHA_CUTOFF = 0.5;
+layout(constant_id = 4) const uint kTEXTURE_TAPS = 1;
+
+// rotated grid inside the pixel, kMAX_TEXTURE_TAPS of them
+const vec2 kTAP_OFFSETS[4] = vec2[](vec2(-0.125, -0.375), vec2(0.375, -0.125), vec2(-0.375, 0.125), vec2(0.125, 0.375));
+
+vec4 sampleTexture(vec2 uv) {
+	if (kTEXTURE_TAPS <= 1) {
+		return texture(texSampler, uv);
+	}
+
+	// spread across the pixel's footprint, an extra bit of filtering on top of the mips
+	vec2 dx = dFdx(uv);
+	vec2 dy = dFdy(uv);
+	vec4 sum = vec4(0.0);
+
+	for (uint i = 0; i < kTEXTURE_TAPS; i++) {
+		vec2 offset = kTAP_OFFSETS[i & 3u];
+		sum += texture(texSampler, uv + offset.x * dx + offset.y * dy);
+	}
+
+	return sum / float(kTEXTURE_TAPS);
+}
+
 void main() {
-	outColor = vec4(fragColor * texture(texSampler, fragTexCoord).rgb, 1.0);
+	vec4 texel = kTEXTURED ? sampleTexture(fragTexCoord) : vec4(1.0);
+
+	if (kALPHA_TEST && texel.a < kALPHA_CUTOFF) {
+		discard;
+	}
+
+	vec3 color = kVERTEX_COLOR ? fragColor : vec3(1.0);
+	outColor = vec4(color * texel.rgb, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// bindless path, every texture lives in one partially bound array at set 1
+// and the vertex shader passes along which one the object's material uses
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragMaterialIndex;
+
+// must match VulkanApplicationBindlessTextures, sized by the layout
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(location = 0) out vec4 outColor;
+
+// must match ShaderPermutation, every combination is compiled as its own program
+// so the toggles below fold away and the tap loop unrolls
+layout(constant_id = 0) const bool kTEXTURED = true;
+layout(constant_id = 1) const bool kVERTEX_COLOR = true;
+layout(constant_id = 2) const bool kALPHA_TEST = false;
+layout(constant_id = 3) const float kALPHA_CUTOFF = 0.5;
+layout(constant_id = 4) const uint kTEXTURE_TAPS = 1;
+
+// rotated grid inside the pixel, kMAX_TEXTURE_TAPS of them
+const vec2 kTAP_OFFSETS[4] = vec2[](vec2(-0.125, -0.375), vec2(0.375, -0.125), vec2(-0.375, 0.125), vec2(0.125, 0.375));
+
+vec4 sampleTexture(uint materialIndex, vec2 uv) {
+	// an instanced draw mixes materials, so the index can differ within a draw
+	if (kTEXTURE_TAPS <= 1) {
+		return texture(textures[nonuniformEXT(materialIndex)], uv);
+	}
+
+	// spread across the pixel's footprint, an extra bit of filtering on top of the mips
+	vec2 dx = dFdx(uv);
+	vec2 dy = dFdy(uv);
+	vec4 sum = vec4(0.0);
+
+	for (uint i = 0; i < kTEXTURE_TAPS; i++) {
+		vec2 offset = kTAP_OFFSETS[i & 3u];
+		sum += texture(textures[nonuniformEXT(materialIndex)], uv + offset.x * dx + offset.y * dy);
+	}
+
+	return sum / float(kTEXTURE_TAPS);
+}
+
+void main() {
+	vec4 texel = kTEXTURED ? sampleTexture(fragMaterialIndex, fragTexCoord) : vec4(1.0);
+
+	if (kALPHA_TEST && texel.a < kALPHA_CUTOFF) {
+		discard;
+	}
+
+	vec3 color = kVERTEX_COLOR ? fragColor : vec3(1.0);
+	outColor = vec4(color * texel.rgb, 1.0);
+}
\ No newline at end of file
@@ -10,13 +10,16 @@ layout(binding = 0) uniform UniformBufferObject {
 	mat4 model;
 	mat4 view;
 	mat4 projection;
+	uint materialIndex;
 } ubo;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragMaterialIndex;
 
 void main() {
 	gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPosition, 1.0);
 	fragColor = inColor;
 	fragTexCoord = inTexCoord;
+	fragMaterialIndex = ubo.materialIndex;
 }
\ No newline at end of file
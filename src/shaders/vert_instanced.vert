@@ -0,0 +1,29 @@
+#version 450
+#extension GL_KHR_vulkan_glsl: enable
+
+// instanced path, per object data comes from the per instance vertex
+// binding and only the camera lives in the uniform buffer
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+// must match InstanceData, a mat4 input takes one location per column
+layout(location = 3) in mat4 instanceModel;
+layout(location = 7) in vec4 instanceTint; // w is the material index
+
+layout(binding = 0) uniform CameraUniformObject {
+	mat4 view;
+	mat4 projection;
+} camera;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragMaterialIndex;
+
+void main() {
+	gl_Position = camera.projection * camera.view * instanceModel * vec4(inPosition, 1.0);
+	fragColor = inColor * instanceTint.rgb;
+	fragTexCoord = inTexCoord;
+	fragMaterialIndex = uint(instanceTint.w);
+}
\ No newline at end of file
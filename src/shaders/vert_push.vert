@@ -0,0 +1,32 @@
+#version 450
+#extension GL_KHR_vulkan_glsl: enable
+
+// push constant path, per draw data comes from push constants and
+// only the camera lives in the uniform buffer
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(binding = 0) uniform CameraUniformObject {
+	mat4 view;
+	mat4 projection;
+} camera;
+
+// must match ObjectPushConstants, 128 bytes is the most every device guarantees
+layout(push_constant) uniform ObjectPushConstants {
+	mat4 model;
+	uint objectIndex;
+	uint materialIndex;
+} object;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragMaterialIndex;
+
+void main() {
+	gl_Position = camera.projection * camera.view * object.model * vec4(inPosition, 1.0);
+	fragColor = inColor;
+	fragTexCoord = inTexCoord;
+	fragMaterialIndex = object.materialIndex;
+}
\ No newline at end of file